@@ -0,0 +1,178 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# ----------------------------------------
+# Simulation throughput benchmark
+#
+# Builds tb_fmul for every DUT x Verilator options combination and runs
+# the random regression in several harness configurations with
+# tb_fmul --bench. Each run appends one JSON line (vectors/s, DUT and
+# reference ns/vector, peak RSS) to the output file, labelled with the git
+# revision and build options, so files from different revisions can be
+# compared.
+# ----------------------------------------
+
+OUT="bench.jsonl"
+NVEC=4000000
+THREADS="1 2 4 0"
+FORMAT="fp32"
+PAR_LANES="4 8 16 32"
+PAR_THREADS="1 2 4"
+LOG="bench_build.log"
+
+usage() {
+  cat <<EOF
+Usage:
+  ./bench_verilator.sh [options]
+
+Options:
+  --out F          JSON lines output, appended to (default: ${OUT})
+  --n N            Vectors per run (default: ${NVEC}); trace runs use N/100
+  --threads "T.."  --jobs values of the thread runs (default: "${THREADS}", 0 = all cores)
+  --format F       Operand format passed to run_verilator.sh (default: ${FORMAT})
+  --par-lanes "L.."   fmul_vec lane counts of the parallelism runs (default: "${PAR_LANES}",
+                      "" = skip them)
+  --par-threads "T.." Verilator --threads values of the parallelism runs (default: "${PAR_THREADS}")
+  -h, --help       Show this help
+
+Matrix:
+  DUT        fmul (combinational), fmul_pipe STAGES=3
+  Verilator  -O3, -O3 --x-assign fast --x-initial fast, -O3 --output-split 20000,
+             all with tracing compiled out
+  Harness    batched driver (--batch 4096), scalar driver (--batch 1),
+             1..N threads
+  Tracing    -O3 FST build: tracing off, --trace-window 1000, --trace
+  Parallel   fmul_vec LANES x --threads T builds, each run as one model and as
+             cores/T models (--jobs 0); the best split per lane count is
+             printed at the end
+
+Build output goes to ${LOG}.
+EOF
+}
+
+while [[ $# -gt 0 ]]; do
+  case "$1" in
+    --out)
+      OUT="$2"
+      shift 2
+      ;;
+    --n)
+      NVEC="$2"
+      shift 2
+      ;;
+    --threads)
+      THREADS="$2"
+      shift 2
+      ;;
+    --format)
+      FORMAT="$2"
+      shift 2
+      ;;
+    --par-lanes)
+      PAR_LANES="$2"
+      shift 2
+      ;;
+    --par-threads)
+      PAR_THREADS="$2"
+      shift 2
+      ;;
+    -h|--help)
+      usage
+      exit 0
+      ;;
+    *)
+      echo "Unknown option: $1"
+      usage
+      exit 1
+      ;;
+  esac
+done
+
+REV="$(git rev-parse --short HEAD 2>/dev/null || echo unknown)"
+if ! git diff --quiet HEAD -- rtl dv 2>/dev/null; then
+  REV="${REV}-dirty"
+fi
+
+DUTS=("comb:" "pipe3:--pipe 3")
+OPTS=("O3:" "x-fast:--x-assign fast --x-initial fast" "split:--output-split 20000")
+
+# One benchmark run of the current build, labelled with $label
+run() {
+  echo "   $*"
+  ./obj_dir/Vfmul --check-flags --bench "$OUT" --bench-label "$label" "$@" > /dev/null
+}
+
+# vectors_per_s of the line the last run appended
+last_vps() {
+  tail -n 1 "$OUT" | sed -n 's/.*"vectors_per_s":\([0-9.]*\).*/\1/p'
+}
+
+: > "$LOG"
+echo "Benchmark rev ${REV}, ${NVEC} vectors per run, results in ${OUT}"
+
+for dut_cfg in "${DUTS[@]}"; do
+  dut_name="${dut_cfg%%:*}"
+  dut_args="${dut_cfg#*:}"
+  for opt_cfg in "${OPTS[@]}"; do
+    opt_name="${opt_cfg%%:*}"
+    opt_args="${opt_cfg#*:}"
+    label="rev=${REV} dut=${dut_name} vl=${opt_name} format=${FORMAT}"
+
+    echo "== ${dut_name} / ${opt_name}: build"
+    # Build plus a short smoke run; the benchmark runs use the binary directly
+    # shellcheck disable=SC2086
+    ./run_verilator.sh --format "$FORMAT" $dut_args ${opt_args:+--vl-opt "$opt_args"} \
+      --n 10000 --check-flags >> "$LOG" 2>&1
+
+    run --n "$NVEC" --batch 4096
+    run --n "$NVEC" --batch 1
+    for t in $THREADS; do
+      run --n "$NVEC" --jobs "$t"
+    done
+  done
+
+  # Tracing compiled in (FST): off, triggered window, whole run
+  label="rev=${REV} dut=${dut_name} vl=O3+trace-fst format=${FORMAT}"
+  echo "== ${dut_name} / O3+trace-fst: build"
+  # shellcheck disable=SC2086
+  ./run_verilator.sh --format "$FORMAT" $dut_args --trace \
+    --n 10000 --check-flags >> "$LOG" 2>&1
+
+  run --n "$NVEC"
+  run --n "$NVEC" --trace-window 1000
+  run --n "$(( NVEC / 100 ))" --trace
+  rm -f wave.fst
+done
+
+# Models x model threads over the same cores, per lane count
+CORES="$(nproc)"
+PAR_BEST=()
+for lanes in $PAR_LANES; do
+  best_vps=0
+  best_cfg=""
+  for t in $PAR_THREADS; do
+    label="rev=${REV} dut=vec${lanes} vl=O3-threads${t} format=${FORMAT}"
+    echo "== vec${lanes} / --threads ${t}: build"
+    ./run_verilator.sh --format "$FORMAT" --vec "$lanes" --threads "$t" \
+      --n 10000 --check-flags >> "$LOG" 2>&1
+
+    run --n "$NVEC" --jobs 1
+    models=$(( CORES / t > 0 ? CORES / t : 1 ))
+    run --n "$NVEC" --jobs 0
+    vps="$(last_vps)"
+    if awk -v a="$vps" -v b="$best_vps" 'BEGIN { exit !(a > b) }'; then
+      best_vps="$vps"
+      best_cfg="${models} models x ${t} threads"
+    fi
+  done
+  PAR_BEST+=("vec${lanes}: ${best_cfg} (${best_vps} vectors/s)")
+done
+
+if [[ ${#PAR_BEST[@]} -gt 0 ]]; then
+  echo "Best split of ${CORES} cores:"
+  for line in "${PAR_BEST[@]}"; do
+    echo "   $line"
+  done
+fi
+
+echo "Done: $(wc -l < "$OUT") lines in ${OUT}"
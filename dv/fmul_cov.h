@@ -0,0 +1,391 @@
+// fmul_cov.h
+//
+// Functional coverage of fmul stimulus, with optional coverage-directed
+// generation.
+//  - FmulCoverage   hit counters for the bins below, sampled on every
+//                   checked vector, mergeable across threads
+//  - CovDirector    replaces part of each random batch with vectors built
+//                   to hit the least-hit bins, so rare datapath corners are
+//                   reached without waiting for uniform random to find them
+//
+// Bins (sampled from the operands, following the fmul datapath):
+//  - class    sign(a) x sign(b) x class(a) x class(b), class in
+//             {zero, sub, norm, inf, nan}                       100 bins
+//  - shift    normalize shift of the product (normal path)        2 bins
+//  - lgrs     LSB, guard, round, sticky after normalize          16 bins
+//  - carry    rounding increment carried out of the significand   2 bins
+//  - exp      biased result exponent after rounding: <=-1, 0, 1,
+//             2..MAX-2, MAX-1, MAX, >=MAX+1, plus rounding-carry into
+//             1 and into MAX, MAX = all-ones exponent (255)       9 bins
+//
+// Everything follows the build format (RefFmt in fmul_ref.h).
+
+#ifndef FMUL_COV_H
+#define FMUL_COV_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "fmul_ref.h"
+#include "fmul_stim.h"
+
+enum CovGroup { COV_CLASS, COV_SHIFT, COV_LGRS, COV_CARRY, COV_EXP, COV_NGROUP };
+
+static const int COV_GROUP_BINS[COV_NGROUP] = { 100, 2, 16, 2, 9 };
+static const int COV_GROUP_BASE[COV_NGROUP] = { 0, 100, 102, 118, 120 };
+static const int COV_NBINS = 129;
+
+static const char* const COV_GROUP_NAME[COV_NGROUP] = {
+  "class", "shift", "lgrs", "carry", "exp"
+};
+
+enum CovOpClass { COV_OP_ZERO, COV_OP_SUB, COV_OP_NORM, COV_OP_INF, COV_OP_NAN };
+
+enum CovExpBin {
+  COV_EXP_NEG, COV_EXP_0, COV_EXP_1, COV_EXP_MID, COV_EXP_TOP, COV_EXP_MAX, COV_EXP_BIG,
+  COV_EXP_CARRY_1, COV_EXP_CARRY_MAX
+};
+
+// All-ones biased exponent, and the significand / product arithmetic of
+// the format
+static const int COV_EMAX = (int)RefFmt::EXP_ONES;
+typedef RefFmt::prod cov_prod;
+static const uint64_t COV_HID = 1ull << REF_MANT;               // hidden 1
+static const uint64_t COV_SIG_MAX = (2ull << REF_MANT) - 1;     // all-ones significand
+
+static inline int cov_op_class(fp_word x) {
+  if (is_zero_bits(x)) return COV_OP_ZERO;
+  if (is_sub_bits(x))  return COV_OP_SUB;
+  if (is_inf_bits(x))  return COV_OP_INF;
+  if (is_nan_bits(x))  return COV_OP_NAN;
+  return COV_OP_NORM;
+}
+
+static inline int cov_group_of(int bin) {
+  int g = COV_NGROUP - 1;
+  while (bin < COV_GROUP_BASE[g]) g--;
+  return g;
+}
+
+static inline void cov_bin_name(int bin, char* out, size_t len) {
+  static const char* const cls[5] = { "zero", "sub", "norm", "inf", "nan" };
+  const int g = cov_group_of(bin);
+  const int k = bin - COV_GROUP_BASE[g];
+  switch (g) {
+    case COV_CLASS:
+      std::snprintf(out, len, "class %c%s*%c%s", (k / 50) ? '-' : '+', cls[(k / 5) % 5],
+                    ((k / 25) % 2) ? '-' : '+', cls[k % 5]);
+      break;
+    case COV_SHIFT: std::snprintf(out, len, "shift %d", k); break;
+    case COV_LGRS:
+      std::snprintf(out, len, "lgrs %d%d%d%d", (k >> 3) & 1, (k >> 2) & 1, (k >> 1) & 1, k & 1);
+      break;
+    case COV_CARRY: std::snprintf(out, len, "carry %d", k); break;
+    default:
+      switch (k) {
+        case COV_EXP_NEG:       std::snprintf(out, len, "exp <=-1"); break;
+        case COV_EXP_MID:       std::snprintf(out, len, "exp 2..%d", COV_EMAX - 2); break;
+        case COV_EXP_TOP:       std::snprintf(out, len, "exp %d", COV_EMAX - 1); break;
+        case COV_EXP_MAX:       std::snprintf(out, len, "exp %d", COV_EMAX); break;
+        case COV_EXP_BIG:       std::snprintf(out, len, "exp >=%d", COV_EMAX + 1); break;
+        case COV_EXP_CARRY_1:   std::snprintf(out, len, "exp carry->1"); break;
+        case COV_EXP_CARRY_MAX: std::snprintf(out, len, "exp carry->%d", COV_EMAX); break;
+        default:                std::snprintf(out, len, "exp %d", k - COV_EXP_0); break;
+      }
+      break;
+  }
+}
+
+// Bins hit by one operand pair. Returns the number written to bins[]
+// (1 for special cases, 5 on the normal path).
+static inline int cov_bins(fp_word a, fp_word b, int bins[5]) {
+  const int ca = cov_op_class(a);
+  const int cb = cov_op_class(b);
+  bins[0] = COV_GROUP_BASE[COV_CLASS] +
+            (((int)sign_bit(a) * 2 + (int)sign_bit(b)) * 5 + ca) * 5 + cb;
+  if (ca != COV_OP_NORM || cb != COV_OP_NORM) return 1;
+
+  const int M = REF_MANT;
+  cov_prod prod = (cov_prod)(COV_HID | frac_field(a)) * (COV_HID | frac_field(b));
+  int e = (int)exp_field(a) + (int)exp_field(b) - REF_BIAS;
+  const int shift = (int)((prod >> (2 * M + 1)) & 1u);
+  if (shift) {
+    prod = (prod >> 1) | (prod & 1u);  // shifted-out bit stays sticky
+    e += 1;
+  }
+
+  const uint64_t upper = (uint64_t)(prod >> M) & COV_SIG_MAX;
+  const uint32_t L = (uint32_t)(upper & 1u);
+  const uint32_t G = (uint32_t)((prod >> (M - 1)) & 1u);
+  const uint32_t R = (uint32_t)((prod >> (M - 2)) & 1u);
+  const uint32_t S = (prod & (((cov_prod)1 << (M - 2)) - 1u)) != 0;
+  const int carry = (upper == COV_SIG_MAX) && (G & (R | S | L));
+
+  const int e_pre = e;
+  e += carry;
+
+  int eb;
+  if (carry && e_pre == 0)                 eb = COV_EXP_CARRY_1;
+  else if (carry && e_pre == COV_EMAX - 1) eb = COV_EXP_CARRY_MAX;
+  else if (e <= -1)                        eb = COV_EXP_NEG;
+  else if (e == 0)                         eb = COV_EXP_0;
+  else if (e == 1)                         eb = COV_EXP_1;
+  else if (e <= COV_EMAX - 2)              eb = COV_EXP_MID;
+  else if (e == COV_EMAX - 1)              eb = COV_EXP_TOP;
+  else if (e == COV_EMAX)                  eb = COV_EXP_MAX;
+  else                                     eb = COV_EXP_BIG;
+
+  bins[1] = COV_GROUP_BASE[COV_SHIFT] + shift;
+  bins[2] = COV_GROUP_BASE[COV_LGRS] + (int)((L << 3) | (G << 2) | (R << 1) | S);
+  bins[3] = COV_GROUP_BASE[COV_CARRY] + carry;
+  bins[4] = COV_GROUP_BASE[COV_EXP] + eb;
+  return 5;
+}
+
+struct FmulCoverage {
+  std::vector<uint64_t> hits = std::vector<uint64_t>(COV_NBINS, 0);
+  uint64_t vectors = 0;
+  int covered = 0;
+  uint64_t full_at = 0;  // vectors sampled when the last bin was first hit, 0: not yet
+
+  bool full() const { return covered == COV_NBINS; }
+
+  void sample(fp_word a, fp_word b) {
+    int bins[5];
+    const int nb = cov_bins(a, b, bins);
+    vectors++;
+    for (int i = 0; i < nb; i++) {
+      if (hits[bins[i]]++ == 0 && ++covered == COV_NBINS) full_at = vectors;
+    }
+  }
+
+  void sample(const fp_word* a, const fp_word* b, size_t n) {
+    for (size_t i = 0; i < n; i++) sample(a[i], b[i]);
+  }
+
+  // full_at is per stream and does not survive a merge
+  void merge(const FmulCoverage& o) {
+    vectors += o.vectors;
+    covered = 0;
+    for (int k = 0; k < COV_NBINS; k++) {
+      hits[k] += o.hits[k];
+      covered += hits[k] != 0;
+    }
+    full_at = 0;
+  }
+
+  void print() const {
+    std::printf("Coverage  : %d/%d bins", covered, COV_NBINS);
+    for (int g = 0; g < COV_NGROUP; g++) {
+      int c = 0;
+      for (int k = 0; k < COV_GROUP_BINS[g]; k++) c += hits[COV_GROUP_BASE[g] + k] != 0;
+      std::printf("%s %s %d/%d", g ? "," : " (", COV_GROUP_NAME[g], c, COV_GROUP_BINS[g]);
+    }
+    std::printf(")\n");
+    if (full_at) {
+      std::printf("            full coverage after %llu vectors\n", (unsigned long long)full_at);
+    }
+
+    // Rarest hit bin and the holes
+    int rare = -1;
+    for (int k = 0; k < COV_NBINS; k++) {
+      if (hits[k] && (rare < 0 || hits[k] < hits[rare])) rare = k;
+    }
+    char name[32];
+    if (rare >= 0) {
+      cov_bin_name(rare, name, sizeof name);
+      std::printf("            rarest bin: %s (%llu hits)\n", name,
+                  (unsigned long long)hits[rare]);
+    }
+    int shown = 0;
+    for (int k = 0; k < COV_NBINS && shown < 16; k++) {
+      if (hits[k]) continue;
+      cov_bin_name(k, name, sizeof name);
+      std::printf("            not hit   : %s\n", name);
+      shown++;
+    }
+  }
+};
+
+// -------------------------------------------------------------------
+// Coverage-directed generation
+//
+// steer() overwrites every DIRECT_EVERY-th vector of a batch with one
+// aimed at the bin with the fewest hits, counting bins already targeted
+// in this batch as pending hits so one batch spreads over many holes.
+// Each target has a constructive recipe (operand classes, significands
+// that force a normalize shift, a sticky-free product or a rounding
+// carry, exponents that land on a boundary), retried a few times until
+// cov_bins() confirms the hit. Feedback comes from FmulCoverage::sample()
+// on the checked batch.
+// -------------------------------------------------------------------
+class CovDirector {
+public:
+  static const size_t DIRECT_EVERY = 2;
+  static const int TRIES = 64;
+
+  CovDirector(uint64_t seed, unsigned stream)
+      : gen_(seed ^ (0xC0FFEE0000000000ull + stream)), pending_(COV_NBINS, 0) {}
+
+  // Returns the number of vectors replaced
+  size_t steer(const FmulCoverage& cov, fp_word* a, fp_word* b, size_t n) {
+    std::fill(pending_.begin(), pending_.end(), 0);
+    size_t replaced = 0;
+    for (size_t i = DIRECT_EVERY - 1; i < n; i += DIRECT_EVERY) {
+      int target = 0;
+      uint64_t best = ~0ull;
+      const int start = (int)(next32() % COV_NBINS);
+      for (int j = 0; j < COV_NBINS; j++) {
+        const int k = (start + j) % COV_NBINS;
+        const uint64_t h = cov.hits[k] + pending_[k];
+        if (h < best) {
+          best = h;
+          target = k;
+        }
+      }
+      pending_[target]++;
+      make(target, a[i], b[i]);
+      replaced++;
+    }
+    return replaced;
+  }
+
+private:
+  StimGen gen_;
+  uint64_t ctr_ = 0;
+  uint32_t buf_[4] = { 0, 0, 0, 0 };
+  int avail_ = 0;
+  std::vector<uint64_t> pending_;
+
+  uint32_t next32() {
+    if (avail_ == 0) {
+      gen_.block(ctr_++, buf_);
+      avail_ = 4;
+    }
+    return buf_[--avail_];
+  }
+
+  uint64_t next64() {
+    const uint64_t hi = next32();
+    return (hi << 32) | next32();
+  }
+
+  // Uniform in [lo, hi], empty ranges give lo
+  uint64_t range(uint64_t lo, uint64_t hi) {
+    if (hi <= lo) return lo;
+    if (hi - lo < 0xFFFFFFFFull) return lo + (((uint64_t)next32() * (hi - lo + 1)) >> 32);
+    return lo + (uint64_t)(((unsigned __int128)next64() * (hi - lo + 1)) >> 64);
+  }
+
+  // Random fraction field
+  fp_word frac_bits() {
+    return (fp_word)((REF_MANT > 32 ? next64() : next32()) & RefFmt::FRAC_MASK);
+  }
+
+  fp_word op_of_class(int cls, uint32_t sign) {
+    const fp_word frac = frac_bits();
+    const fp_word s = RefFmt::zero((fp_word)sign);
+    switch (cls) {
+      case COV_OP_ZERO: return s;
+      case COV_OP_SUB:  return (fp_word)(s | (frac ? frac : 1u));
+      case COV_OP_INF:  return (fp_word)(s | RefFmt::INF);
+      case COV_OP_NAN:  return (fp_word)(s | RefFmt::INF | (frac ? frac : 1u));
+      default:          return (fp_word)(s | (range(1, COV_EMAX - 1) << REF_MANT) | frac);
+    }
+  }
+
+  // Significands for the normal path, shaped for the target bin
+  void sigs(int group, int k, uint64_t& sa, uint64_t& sb) {
+    const int M = REF_MANT;
+    sa = range(COV_HID, COV_SIG_MAX);
+    sb = range(COV_HID, COV_SIG_MAX);
+    const bool want_carry = (group == COV_CARRY && k == 1) ||
+                            (group == COV_EXP && k >= COV_EXP_CARRY_1);
+    if (group == COV_SHIFT) {
+      // shift iff sa * sb >= 2^(2*MANT+1)
+      const cov_prod lim = (((cov_prod)1 << (2 * M + 1)) + sa - 1) / sa;
+      sb = k ? range(std::max<uint64_t>((uint64_t)lim, COV_HID), COV_SIG_MAX)
+             : range(COV_HID, std::min<uint64_t>((uint64_t)lim - 1, COV_SIG_MAX));
+    } else if (group == COV_LGRS && !(k & 1)) {
+      // no sticky: the low MANT-2 (+1 when shifting) product bits are
+      // zero, plus R, G and L when they are wanted zero too. Split the
+      // trailing zeros between both significands.
+      int z = M - 2 + (int)(next32() & 1u);
+      for (int bit = 1; bit <= 3 && !((k >> bit) & 1); bit++) z++;
+      const int i = (int)range((uint64_t)std::max(0, z - M), (uint64_t)std::min(M, z));
+      sa &= ~((1ull << i) - 1u);
+      sb &= ~((1ull << (z - i)) - 1u);
+    } else if (want_carry) {
+      // product just below 2^(2*MANT+1): all ones above the guard bit
+      sb = std::min<uint64_t>((uint64_t)((((cov_prod)1 << (2 * M + 1)) - 1) / sa), COV_SIG_MAX);
+    }
+  }
+
+  void make(int target, fp_word& a, fp_word& b) {
+    const int M = REF_MANT;
+    const int g = cov_group_of(target);
+    const int k = target - COV_GROUP_BASE[g];
+
+    if (g == COV_CLASS) {
+      a = op_of_class((k / 5) % 5, (uint32_t)(k / 50));
+      b = op_of_class(k % 5, (uint32_t)((k / 25) % 2));
+      return;
+    }
+
+    for (int t = 0; t < TRIES; t++) {
+      uint64_t sa, sb;
+      sigs(g, k, sa, sb);
+
+      // Result exponent without the exponent fields, then pick the
+      // fields for the wanted biased exponent
+      const cov_prod prod = (cov_prod)sa * sb;
+      const int shift = (int)((prod >> (2 * M + 1)) & 1u);
+      const cov_prod p = (prod >> shift) | (prod & (cov_prod)shift);
+      const uint64_t upper = (uint64_t)(p >> M) & COV_SIG_MAX;
+      const uint64_t grs = (uint64_t)p & (COV_HID - 1);
+      const int carry = upper == COV_SIG_MAX && (grs >> (M - 1)) &&
+                        ((grs & ((COV_HID >> 1) - 1)) || (upper & 1u));
+
+      // Exponent sums exp_a + exp_b range over 2..2*(MAX-1)
+      const int e_lo = 2 - REF_BIAS;
+      const int e_hi = 2 * (COV_EMAX - 1) - REF_BIAS;
+      int e_want;
+      if (g == COV_EXP) {
+        switch (k) {
+          case COV_EXP_NEG:       e_want = -(int)range(1, (uint64_t)-e_lo); break;
+          case COV_EXP_0:         e_want = 0; break;
+          case COV_EXP_1:         e_want = 1; break;
+          case COV_EXP_TOP:       e_want = COV_EMAX - 1; break;
+          case COV_EXP_MAX:       e_want = COV_EMAX; break;
+          case COV_EXP_BIG:       e_want = (int)range(COV_EMAX + 1, e_hi); break;
+          case COV_EXP_CARRY_1:   e_want = 1; break;
+          case COV_EXP_CARRY_MAX: e_want = COV_EMAX; break;
+          default:                e_want = (int)range(2, COV_EMAX - 2); break;
+        }
+      } else {
+        e_want = (int)range(2, COV_EMAX - 2);
+      }
+
+      const int need = e_want + REF_BIAS - shift - carry;  // exp_a + exp_b
+      const int lo = std::max(1, need - (COV_EMAX - 1));
+      const int hi = std::min(COV_EMAX - 1, need - 1);
+      if (lo > hi) continue;
+      const uint64_t ea = range((uint64_t)lo, (uint64_t)hi);
+      const uint64_t eb = (uint64_t)need - ea;
+
+      const uint32_t signs = next32();
+      a = (fp_word)(RefFmt::zero((fp_word)(signs & 1u)) | (ea << M) | (sa & RefFmt::FRAC_MASK));
+      b = (fp_word)(RefFmt::zero((fp_word)((signs >> 1) & 1u)) | (eb << M) | (sb & RefFmt::FRAC_MASK));
+
+      int bins[5];
+      const int nb = cov_bins(a, b, bins);
+      for (int i = 0; i < nb; i++) {
+        if (bins[i] == target) return;
+      }
+    }
+  }
+};
+
+#endif // FMUL_COV_H
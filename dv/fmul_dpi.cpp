@@ -0,0 +1,68 @@
+// fmul_dpi.cpp
+//
+// DPI-C entry points from fmul_ref.h for the SystemVerilog testbench
+// fmul_tb.sv. Each call handles a whole batch through open arrays, so one
+// DPI crossing covers the batch, and results come from the same
+// ref_model_batch() kernel as tb_fmul.cpp.
+//
+// Build with the same -DFMUL_EXP/-DFMUL_MANT/-DFMUL_BIAS/-DFMUL_SUBNORMAL as
+// the DUT parameters; fmul_tb.sv compares them via fmul_ref_config() at
+// time 0. Words travel as 64-bit longint unsigned whatever the format.
+
+#include <cstdio>
+#include <vector>
+
+#include "svdpi.h"
+#include "fmul_ref.h"
+
+// Element i of a 1-D open array. svGetArrayPtr() gives the whole array when
+// the simulator keeps it in C layout, otherwise fall back to
+// per-element access.
+template <class T>
+static inline T* dpi_elem(const svOpenArrayHandle h, T* base, int i) {
+  if (base) return base + i;
+  return static_cast<T*>(svGetArrElemPtr1(h, svLow(h, 1) + i));
+}
+
+extern "C" void fmul_ref_config(int* exp, int* mant, int* bias, int* subnormal) {
+  *exp = REF_EXP;
+  *mant = REF_MANT;
+  *bias = REF_BIAS;
+  *subnormal = REF_SUBNORMAL ? 1 : 0;
+}
+
+// y[i], flags[i] = ref_model(a[i], b[i], rm) for i < n. Flags are packed
+// {invalid, overflow, underflow, inexact} (bit 3..0), as the DUT ports.
+extern "C" void fmul_ref_batch(const svOpenArrayHandle a, const svOpenArrayHandle b,
+                               const svOpenArrayHandle y, const svOpenArrayHandle flags,
+                               int n, int rm) {
+  if (n <= 0) return;
+  if (svSize(a, 1) < n || svSize(b, 1) < n || svSize(y, 1) < n || svSize(flags, 1) < n) {
+    std::printf("ERROR: fmul_ref_batch: n=%d exceeds an array argument\n", n);
+    return;
+  }
+
+  // Reused across calls; the testbench calls from one thread
+  static std::vector<fp_word> av, bv, yv;
+  static std::vector<uint8_t> fv;
+  av.resize(n);
+  bv.resize(n);
+  yv.resize(n);
+  fv.resize(n);
+
+  uint64_t* ap = static_cast<uint64_t*>(svGetArrayPtr(a));
+  uint64_t* bp = static_cast<uint64_t*>(svGetArrayPtr(b));
+  for (int i = 0; i < n; i++) {
+    av[i] = (fp_word)(*dpi_elem(a, ap, i) & RefFmt::MASK);
+    bv[i] = (fp_word)(*dpi_elem(b, bp, i) & RefFmt::MASK);
+  }
+
+  ref_model_batch(av.data(), bv.data(), yv.data(), fv.data(), (size_t)n, rm);
+
+  uint64_t* yp = static_cast<uint64_t*>(svGetArrayPtr(y));
+  uint8_t* fp = static_cast<uint8_t*>(svGetArrayPtr(flags));
+  for (int i = 0; i < n; i++) {
+    *dpi_elem(y, yp, i) = yv[i];
+    *dpi_elem(flags, fp, i) = fv[i];
+  }
+}
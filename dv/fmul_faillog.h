@@ -0,0 +1,162 @@
+// fmul_faillog.h
+//
+// Bounded failure log for continue-on-fail runs (--max-fails).
+//  - FailBudget   shared count of failing vectors, tells every thread when
+//                 the run has seen enough
+//  - FailLog      one per thread: counts failures per failure class and
+//                 keeps the first example of each class in a fixed-size
+//                 single-producer ring, no locks on the hot path
+//  - merge_fail_logs()  combines the thread logs after the run, one entry
+//                 per class with the lowest-index example
+//
+// A failure class is what went wrong rather than which operands did it:
+// operand classes, reference result class, whether y differs, which flags
+// differ, and on the normal path the rounding carry and exponent bin.
+
+#ifndef FMUL_FAILLOG_H
+#define FMUL_FAILLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fmul_cov.h"
+#include "fmul_ref.h"
+
+struct FailBudget {
+  uint64_t limit = 1;  // 0: unlimited
+  std::atomic<uint64_t> used{0};
+
+  // Counts one failure, returns true while the run may go on
+  bool take() {
+    const uint64_t n = used.fetch_add(1, std::memory_order_relaxed) + 1;
+    return limit == 0 || n < limit;
+  }
+  bool exhausted() const {
+    return limit != 0 && used.load(std::memory_order_relaxed) >= limit;
+  }
+};
+
+struct FailRecord {
+  uint32_t key;
+  fp_word a, b;
+  fp_word y_dut, y_ref;
+  uint8_t f_dut, f_ref;
+  uint64_t index;  // stream index, or record index of a replay
+};
+
+// Operand classes, reference result class, mismatching fields, and on
+// the normal path rounding carry and exponent bin, packed into one key
+static inline uint32_t fail_class_key(const FailRecord& r) {
+  uint32_t key = (uint32_t)cov_op_class(r.a);
+  key = key * 5 + (uint32_t)cov_op_class(r.b);
+  key = key * 5 + (uint32_t)cov_op_class(r.y_ref);
+  key = key * 2 + (r.y_dut != r.y_ref);
+  key = key * 16 + ((r.f_dut ^ r.f_ref) & FLAG_ALL);
+
+  int bins[5];
+  if (cov_bins(r.a, r.b, bins) == 5) {
+    key = key * 2 + (uint32_t)(bins[3] - COV_GROUP_BASE[COV_CARRY]);
+    key = key * 16 + (uint32_t)(bins[4] - COV_GROUP_BASE[COV_EXP]);
+  } else {
+    key = key * 32;
+  }
+  return key;
+}
+
+static inline std::string fail_class_name(const FailRecord& r) {
+  static const char* const cls[5] = { "zero", "sub", "norm", "inf", "nan" };
+  static const char* const flag_names[4] = { "inexact", "underflow", "overflow", "invalid" };
+  std::string s = std::string(cls[cov_op_class(r.a)]) + "*" + cls[cov_op_class(r.b)] +
+                  " -> " + cls[cov_op_class(r.y_ref)] + ":";
+  if (r.y_dut != r.y_ref) s += " y";
+  const uint8_t df = (r.f_dut ^ r.f_ref) & FLAG_ALL;
+  for (int k = 3; k >= 0; k--) {
+    if (df & (1u << k)) s += std::string(" ") + flag_names[k];
+  }
+  int bins[5];
+  if (cov_bins(r.a, r.b, bins) == 5) {
+    char name[32];
+    cov_bin_name(bins[4], name, sizeof name);
+    s += std::string(" (") + name + (bins[3] > COV_GROUP_BASE[COV_CARRY] ? ", carry)" : ")");
+  }
+  return s;
+}
+
+class FailLog {
+public:
+  static const size_t RING = 256;  // distinct classes kept per thread
+
+  FailLog() : ring_(RING) {}
+
+  // Producer side, owning thread only
+  void add(FailRecord r) {
+    r.key = fail_class_key(r);
+    auto it = counts_.find(r.key);
+    if (it != counts_.end()) {
+      it->second++;
+      return;
+    }
+    counts_.emplace(r.key, 1);
+    const uint64_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == RING) {
+      dropped_++;
+      return;
+    }
+    ring_[h % RING] = r;
+    head_.store(h + 1, std::memory_order_release);
+  }
+
+  // Consumer side: moves the published records out
+  void drain(std::vector<FailRecord>& out) {
+    uint64_t t = tail_.load(std::memory_order_relaxed);
+    const uint64_t h = head_.load(std::memory_order_acquire);
+    for (; t != h; t++) out.push_back(ring_[t % RING]);
+    tail_.store(t, std::memory_order_release);
+  }
+
+  const std::unordered_map<uint32_t, uint64_t>& counts() const { return counts_; }
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  std::vector<FailRecord> ring_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::unordered_map<uint32_t, uint64_t> counts_;
+  uint64_t dropped_ = 0;
+};
+
+struct FailClass {
+  FailRecord first;
+  uint64_t count = 0;
+};
+
+// One entry per class over all logs, ordered by first occurrence
+static inline std::vector<FailClass> merge_fail_logs(std::vector<FailLog>& logs) {
+  std::unordered_map<uint32_t, FailClass> m;
+  for (FailLog& log : logs) {
+    std::vector<FailRecord> recs;
+    log.drain(recs);
+    for (const FailRecord& r : recs) {
+      auto it = m.find(r.key);
+      if (it == m.end()) m[r.key].first = r;
+      else if (r.index < it->second.first.index) it->second.first = r;
+    }
+    for (const auto& kv : log.counts()) m[kv.first].count += kv.second;
+  }
+
+  std::vector<FailClass> out;
+  for (auto& kv : m) {
+    if (kv.second.count && kv.second.first.key == kv.first) out.push_back(kv.second);
+  }
+  std::sort(out.begin(), out.end(), [](const FailClass& x, const FailClass& y) {
+    return x.first.index < y.first.index;
+  });
+  return out;
+}
+
+#endif // FMUL_FAILLOG_H
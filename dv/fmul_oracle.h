@@ -0,0 +1,535 @@
+// fmul_oracle.h
+//
+// Independent oracles for the reference model. ref_model() is written by
+// hand, so a mistake it shares with the RTL passes every DUT check; these
+// compute the same products another way, and the testbench compares them
+// with the reference results batch by batch (tb_fmul --oracle).
+//  - host       the host FPU: float/double multiply under the MXCSR
+//               rounding mode, DAZ|FTZ unless gradual underflow, flags
+//               from fetestexcept(). binary32 in either subnormal policy,
+//               binary64 (DAZ/FTZ fast, gradual underflow one vector at a
+//               time); rne/rtz/rdn/rup, x86 has no ties-away mode
+//  - softfloat  Berkeley SoftFloat 3 (-DFMUL_SOFTFLOAT=1 and softfloat.a,
+//               run_verilator.sh --softfloat DIR): binary16/32/64 in all
+//               five modes, DAZ/FTZ applied around the call. SoftFloat
+//               keeps its mode and flags in globals, calls are serialized
+// Both are post-processed into the conventions of the DUT: every NaN
+// result is qnan_const(), NaN operands raise no invalid (the host and
+// SoftFloat signal it for a signaling NaN).
+//
+// Host flags: clearing and reading the exception flags per vector costs
+// several times the scalar model, so oracle_batch() derives each vector's
+// flags from the hardware product (exact double product or fma residual,
+// rescaled copies for tininess and overflow in the current rounding mode)
+// and only checks their OR against fetestexcept() once per ORACLE_CHUNK
+// vectors. A chunk that disagrees is redone one vector at a time with the
+// flags of the hardware itself (oracle_redone() counts them), so the
+// result never rests on the derivation alone. binary32 multiplies 8 lanes
+// per AVX2 instruction when the host has it.
+
+#ifndef FMUL_ORACLE_H
+#define FMUL_ORACLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include "fmul_ref.h"
+
+#ifdef FMUL_SOFT_X86
+#include <cfenv>
+#endif
+
+#ifndef FMUL_SOFTFLOAT
+#define FMUL_SOFTFLOAT 0
+#endif
+
+#if FMUL_SOFTFLOAT
+extern "C" {
+#include "softfloat.h"
+}
+#endif
+
+enum class Oracle { None, Host, SoftFloat };
+
+static inline const char* oracle_name(Oracle o) {
+  switch (o) {
+    case Oracle::Host:      return "host";
+    case Oracle::SoftFloat: return "softfloat";
+    default:                return "none";
+  }
+}
+
+static inline bool oracle_parse(const std::string& s, Oracle& o) {
+  for (Oracle k : {Oracle::None, Oracle::Host, Oracle::SoftFloat}) {
+    if (s == oracle_name(k)) {
+      o = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Vectors per fetestexcept() check of the host oracle
+static const size_t ORACLE_CHUNK = 1024;
+
+// Host chunks whose flags were redone vector by vector, all threads
+static inline std::atomic<uint64_t>& oracle_redone() {
+  static std::atomic<uint64_t> n{0};
+  return n;
+}
+
+// Host arithmetic type of format F, void when the host has none
+template <class F> struct HostFloat { typedef void type; };
+template <> struct HostFloat<fmul_soft::binary32> { typedef float type; };
+template <> struct HostFloat<fmul_soft::binary64> { typedef double type; };
+
+#ifdef FMUL_SOFT_X86
+// -------------------------------------------------------------------
+// Host FPU
+// -------------------------------------------------------------------
+static const unsigned MXCSR_DAZ_FTZ = 0x8040u;
+
+static inline int host_round(int rm) {
+  switch (rm) {
+    case RM_RTZ: return FE_TOWARDZERO;
+    case RM_RDN: return FE_DOWNWARD;
+    case RM_RUP: return FE_UPWARD;
+    default:     return FE_TONEAREST;
+  }
+}
+
+// Rounding mode and subnormal handling of one oracle batch, the caller's
+// environment restored on exit
+class HostFpEnv {
+ public:
+  HostFpEnv(int rm, bool subn) : csr_(_mm_getcsr()) {
+    std::fegetenv(&env_);
+    std::fesetround(host_round(rm));
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr(subn ? csr & ~MXCSR_DAZ_FTZ : csr | MXCSR_DAZ_FTZ);
+  }
+  ~HostFpEnv() {
+    std::fesetenv(&env_);
+    _mm_setcsr(csr_);
+  }
+  HostFpEnv(const HostFpEnv&) = delete;
+  HostFpEnv& operator=(const HostFpEnv&) = delete;
+
+ private:
+  fenv_t env_;
+  unsigned csr_;
+};
+
+// Sticky host exceptions as packed flags
+static inline uint8_t host_except() {
+  const int e = std::fetestexcept(FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW | FE_INEXACT);
+  return (uint8_t)(((e & FE_INVALID) ? FLAG_INVALID : 0) | ((e & FE_OVERFLOW) ? FLAG_OVERFLOW : 0) |
+                   ((e & FE_UNDERFLOW) ? FLAG_UNDERFLOW : 0) | ((e & FE_INEXACT) ? FLAG_INEXACT : 0));
+}
+
+// Flags of y = x*z in the current rounding mode for finite nonzero
+// operands (garbage otherwise, the caller masks it), without raising an
+// exception the multiply itself did not. Branch free, so a chunk loop
+// can vectorize. binary32: the double product is exact; tininess and
+// overflow round a copy scaled away from the limits (after rounding,
+// like x86 and the RTL).
+static const double HOST_LO = std::ldexp(1.0, -125);    // below: may round tiny
+static const double HOST_HI = std::ldexp(1.0, 127);     // above: may overflow
+static const double HOST_UP = std::ldexp(1.0, 200);     // scale of the tiny copy
+static const double HOST_DOWN = std::ldexp(1.0, -128);  // scale of the overflow copy
+static const float HOST_TINY_UP = std::ldexp(1.0f, 74); // 2^-126 * HOST_UP
+
+static inline uint8_t host_flags(float x, float z, float y) {
+  const double p = (double)x * (double)z;
+  const double m = std::fabs(p);
+  // In range for the scaled copies; quiet compares, p may be a NaN
+  const double hi = std::isgreaterequal(m, HOST_HI) ? p : HOST_HI;
+  const double lo = std::isless(m, HOST_LO) ? p : HOST_LO;
+  const bool ovf = std::fabs((float)(hi * HOST_DOWN)) >= 1.0f;
+  const bool tiny = std::fabs((float)(lo * HOST_UP)) < HOST_TINY_UP;
+  const bool inx = ovf || (double)y != p;
+  return (uint8_t)((ovf ? FLAG_OVERFLOW : 0) | (tiny && inx ? FLAG_UNDERFLOW : 0) |
+                   (inx ? FLAG_INEXACT : 0));
+}
+
+// binary64, DAZ/FTZ: the significands in [1, 2) are multiplied in the
+// current rounding mode, the exponent sum tells tininess and overflow,
+// the fma residual inexactness. Operands that are not normal multiply
+// as 1.0 so they raise nothing.
+static inline uint8_t host_flags(double x, double z, double) {
+  typedef fmul_soft::binary64 F;
+  uint64_t ux, uz;
+  std::memcpy(&ux, &x, sizeof ux);
+  std::memcpy(&uz, &z, sizeof uz);
+  const uint64_t one = (uint64_t)F::BIAS << F::MANT;
+  const bool norm = F::exp_field(ux) != 0 && F::exp_field(ux) != F::EXP_ONES &&
+                    F::exp_field(uz) != 0 && F::exp_field(uz) != F::EXP_ONES;
+  const int e = (int)F::exp_field(ux) + (int)F::exp_field(uz) - 2 * F::BIAS;
+  ux = norm ? (ux & ~F::INF) | one : one;
+  uz = norm ? (uz & ~F::INF) | one : one;
+  double mx, mz;
+  std::memcpy(&mx, &ux, sizeof mx);
+  std::memcpy(&mz, &uz, sizeof mz);
+  const double t = mx * mz;
+  const double m = std::fabs(t);
+  const int et = e + (m >= 4.0 ? 2 : m >= 2.0 ? 1 : 0);
+  const bool ovf = et > F::BIAS;
+  const bool tiny = et < 1 - F::BIAS;
+  const bool inx = ovf || tiny || std::fma(mx, mz, -t) != 0.0;
+  return (uint8_t)((ovf ? FLAG_OVERFLOW : 0) | (tiny ? FLAG_UNDERFLOW : 0) |
+                   (inx ? FLAG_INEXACT : 0));
+}
+
+// NaN results to the DUT's qNaN, no invalid for a NaN operand
+template <class F>
+static inline void host_fixup(typename F::word a, typename F::word b, typename F::word& y,
+                              uint8_t& f) {
+  if (F::is_nan(y)) {
+    y = F::QNAN;
+    if (F::is_nan(a) || F::is_nan(b)) f &= (uint8_t)~FLAG_INVALID;
+  }
+}
+
+// One vector, flags read back from the FPU
+template <class F, class T>
+static inline void host_mul_exact(typename F::word a, typename F::word b, typename F::word& y,
+                                  uint8_t& f) {
+  T x, z;
+  std::memcpy(&x, &a, sizeof x);
+  std::memcpy(&z, &b, sizeof z);
+  volatile T vx = x, vz = z;
+  std::feclearexcept(FE_ALL_EXCEPT);
+  volatile T vp = vx * vz;
+  f = host_except();
+  const T p = vp;
+  std::memcpy(&y, &p, sizeof y);
+  host_fixup<F>(a, b, y, f);
+}
+
+// One chunk with derived flags, returns their OR plus invalid for every
+// signaling NaN operand: what fetestexcept() must read afterwards
+template <class F, class T>
+static uint8_t host_chunk(const typename F::word* a, const typename F::word* b,
+                          typename F::word* y, uint8_t* flags, size_t n, bool subn) {
+  typedef typename F::word word;
+  const word quiet = (word)1u << (F::MANT - 1);
+  uint8_t any = 0;
+  for (size_t i = 0; i < n; i++) {
+    T x, z;
+    std::memcpy(&x, &a[i], sizeof x);
+    std::memcpy(&z, &b[i], sizeof z);
+    const T p = x * z;
+    word w;
+    std::memcpy(&w, &p, sizeof w);
+    // Finite and nonzero after DAZ: the only operands with flags of
+    // their own, the rest are masked with selects
+    const bool a_val = !F::is_zero(a[i]) && (subn || !F::is_sub(a[i])) &&
+                       F::exp_field(a[i]) != F::EXP_ONES;
+    const bool b_val = !F::is_zero(b[i]) && (subn || !F::is_sub(b[i])) &&
+                       F::exp_field(b[i]) != F::EXP_ONES;
+    const bool a_nan = F::is_nan(a[i]), b_nan = F::is_nan(b[i]);
+    const bool y_nan = F::is_nan(w);
+    any |= ((a_nan && !(a[i] & quiet)) || (b_nan && !(b[i] & quiet))) ? FLAG_INVALID : 0;
+    const uint8_t fl = host_flags(x, z, p);
+    const uint8_t f = (uint8_t)((a_val && b_val ? fl : 0) |
+                                (y_nan && !a_nan && !b_nan ? FLAG_INVALID : 0));
+    y[i] = y_nan ? F::QNAN : w;
+    flags[i] = f;
+    any |= f;
+  }
+  return any;
+}
+
+// host_flags(float) for 4 lanes, flags in the low byte of each 32-bit lane
+__attribute__((target("avx2")))
+static inline __m128i host_flags_avx2(__m128 x, __m128 z, __m128 y) {
+  const __m256d lo_lim = _mm256_set1_pd(HOST_LO);
+  const __m256d hi_lim = _mm256_set1_pd(HOST_HI);
+  const __m256d sign   = _mm256_set1_pd(-0.0);
+  const __m128  sign_f = _mm_set1_ps(-0.0f);
+  const __m256d p = _mm256_mul_pd(_mm256_cvtps_pd(x), _mm256_cvtps_pd(z));
+  const __m256d m = _mm256_andnot_pd(sign, p);
+  const __m256d hi = _mm256_blendv_pd(hi_lim, p, _mm256_cmp_pd(m, hi_lim, _CMP_GE_OQ));
+  const __m256d lo = _mm256_blendv_pd(lo_lim, p, _mm256_cmp_pd(m, lo_lim, _CMP_LT_OQ));
+  const __m128 ho = _mm_andnot_ps(sign_f, _mm256_cvtpd_ps(_mm256_mul_pd(hi, _mm256_set1_pd(HOST_DOWN))));
+  const __m128 lw = _mm_andnot_ps(sign_f, _mm256_cvtpd_ps(_mm256_mul_pd(lo, _mm256_set1_pd(HOST_UP))));
+  const __m128 ovf  = _mm_cmp_ps(ho, _mm_set1_ps(1.0f), _CMP_GE_OQ);
+  const __m128 tiny = _mm_cmp_ps(lw, _mm_set1_ps(HOST_TINY_UP), _CMP_LT_OQ);
+  // y != p, the low half of each 64-bit mask
+  const __m256d ne = _mm256_cmp_pd(_mm256_cvtps_pd(y), p, _CMP_NEQ_UQ);
+  const __m128 ne32 = _mm_shuffle_ps(_mm_castpd_ps(_mm256_castpd256_pd128(ne)),
+                                     _mm_castpd_ps(_mm256_extractf128_pd(ne, 1)), _MM_SHUFFLE(2, 0, 2, 0));
+  const __m128i inx = _mm_castps_si128(_mm_or_ps(ovf, ne32));
+  return _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_castps_si128(ovf), _mm_set1_epi32(FLAG_OVERFLOW)),
+                                   _mm_and_si128(_mm_and_si128(_mm_castps_si128(tiny), inx),
+                                                 _mm_set1_epi32(FLAG_UNDERFLOW))),
+                      _mm_and_si128(inx, _mm_set1_epi32(FLAG_INEXACT)));
+}
+
+// host_chunk() for binary32, 8 lanes per _mm256_mul_ps
+__attribute__((target("avx2")))
+static uint8_t host_chunk_avx2(const uint32_t* a, const uint32_t* b, uint32_t* y,
+                               uint8_t* flags, size_t n, bool subn) {
+  const __m256i zero  = _mm256_setzero_si256();
+  const __m256i emax  = _mm256_set1_epi32(0xFF);
+  const __m256i fmsk  = _mm256_set1_epi32(0x7FFFFF);
+  const __m256i quiet = _mm256_set1_epi32(0x400000);
+  const __m256i f_inv = _mm256_set1_epi32(FLAG_INVALID);
+  const __m256i to_bytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  __m256i any = zero;
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    const __m256 xa = _mm256_castsi256_ps(va), xb = _mm256_castsi256_ps(vb);
+    const __m256 p = _mm256_mul_ps(xa, xb);
+    const __m256i w = _mm256_castps_si256(p);
+
+    const __m256i a_max = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srli_epi32(va, 23), emax), emax);
+    const __m256i b_max = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srli_epi32(vb, 23), emax), emax);
+    const __m256i y_max = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srli_epi32(w, 23), emax), emax);
+    const __m256i a_f0 = _mm256_cmpeq_epi32(_mm256_and_si256(va, fmsk), zero);
+    const __m256i b_f0 = _mm256_cmpeq_epi32(_mm256_and_si256(vb, fmsk), zero);
+    const __m256i y_f0 = _mm256_cmpeq_epi32(_mm256_and_si256(w, fmsk), zero);
+    const __m256i a_e0 = _mm256_cmpeq_epi32(_mm256_and_si256(va, _mm256_set1_epi32(0x7F800000)), zero);
+    const __m256i b_e0 = _mm256_cmpeq_epi32(_mm256_and_si256(vb, _mm256_set1_epi32(0x7F800000)), zero);
+    const __m256i a_zero = subn ? _mm256_and_si256(a_e0, a_f0) : a_e0;
+    const __m256i b_zero = subn ? _mm256_and_si256(b_e0, b_f0) : b_e0;
+    const __m256i a_nan = _mm256_andnot_si256(a_f0, a_max);
+    const __m256i b_nan = _mm256_andnot_si256(b_f0, b_max);
+    const __m256i y_nan = _mm256_andnot_si256(y_f0, y_max);
+    const __m256i valid = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(a_max, a_zero),
+                                                              _mm256_or_si256(b_max, b_zero)),
+                                              _mm256_set1_epi32(-1));
+    const __m256i snan = _mm256_or_si256(
+        _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(va, quiet), quiet), a_nan),
+        _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(vb, quiet), quiet), b_nan));
+    const __m256i inv = _mm256_andnot_si256(_mm256_or_si256(a_nan, b_nan), y_nan);
+
+    const __m128i fl_lo = host_flags_avx2(_mm256_castps256_ps128(xa), _mm256_castps256_ps128(xb),
+                                          _mm256_castps256_ps128(p));
+    const __m128i fl_hi = host_flags_avx2(_mm256_extractf128_ps(xa, 1), _mm256_extractf128_ps(xb, 1),
+                                          _mm256_extractf128_ps(p, 1));
+    const __m256i fl = _mm256_inserti128_si256(_mm256_castsi128_si256(fl_lo), fl_hi, 1);
+    const __m256i f = _mm256_or_si256(_mm256_and_si256(fl, valid), _mm256_and_si256(inv, f_inv));
+    any = _mm256_or_si256(any, _mm256_or_si256(f, _mm256_and_si256(snan, f_inv)));
+
+    _mm256_storeu_si256((__m256i*)(y + i),
+                        _mm256_blendv_epi8(w, _mm256_set1_epi32((int)fmul_soft::binary32::QNAN), y_nan));
+    const __m256i fb = _mm256_shuffle_epi8(f, to_bytes);
+    const uint32_t f_lo = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(fb));
+    const uint32_t f_hi = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(fb, 1));
+    std::memcpy(flags + i, &f_lo, 4);
+    std::memcpy(flags + i + 4, &f_hi, 4);
+  }
+
+  alignas(32) uint32_t lanes[8];
+  _mm256_store_si256((__m256i*)lanes, any);
+  uint8_t all = host_chunk<fmul_soft::binary32, float>(a + i, b + i, y + i, flags + i, n - i, subn);
+  for (uint32_t l : lanes) all |= (uint8_t)l;
+  return all;
+}
+
+// Chunk kernel of format F, AVX2 for binary32 when the host has it
+template <class F, class T>
+struct HostChunk {
+  typedef uint8_t (*Fn)(const typename F::word*, const typename F::word*, typename F::word*,
+                        uint8_t*, size_t, bool);
+  static Fn get() { return host_chunk<F, T>; }
+};
+template <>
+struct HostChunk<fmul_soft::binary32, float> {
+  typedef uint8_t (*Fn)(const uint32_t*, const uint32_t*, uint32_t*, uint8_t*, size_t, bool);
+  static Fn get() {
+    return fmul_soft::isa_best() != fmul_soft::Isa::Scalar ? host_chunk_avx2
+                                                           : host_chunk<fmul_soft::binary32, float>;
+  }
+};
+
+template <class F, class T>
+static void host_oracle_batch(const typename F::word* a, const typename F::word* b,
+                              typename F::word* y, uint8_t* flags, size_t n, int rm, bool subn) {
+  HostFpEnv env(rm, subn);
+  // Flag derivation covers binary64 with DAZ/FTZ only
+  const bool derive = std::is_same<T, float>::value || !subn;
+  const typename HostChunk<F, T>::Fn chunk = HostChunk<F, T>::get();
+
+  for (size_t i0 = 0; i0 < n; i0 += ORACLE_CHUNK) {
+    const size_t m = std::min(ORACLE_CHUNK, n - i0);
+    bool redo = !derive;
+    if (derive) {
+      std::feclearexcept(FE_ALL_EXCEPT);
+      const uint8_t any = chunk(a + i0, b + i0, y + i0, flags + i0, m, subn);
+      if (host_except() != any) {
+        redo = true;
+        oracle_redone().fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (redo) {
+      for (size_t i = i0; i < i0 + m; i++) host_mul_exact<F, T>(a[i], b[i], y[i], flags[i]);
+    }
+  }
+}
+#endif // FMUL_SOFT_X86
+
+#if FMUL_SOFTFLOAT
+// -------------------------------------------------------------------
+// Berkeley SoftFloat, tininess after rounding like the RTL
+// -------------------------------------------------------------------
+template <class F> struct SoftFloatOps { static const bool ok = false; };
+template <> struct SoftFloatOps<fmul_soft::binary16> {
+  static const bool ok = true;
+  static uint16_t mul(uint16_t a, uint16_t b) {
+    float16_t x, z;
+    x.v = a;
+    z.v = b;
+    return f16_mul(x, z).v;
+  }
+};
+template <> struct SoftFloatOps<fmul_soft::binary32> {
+  static const bool ok = true;
+  static uint32_t mul(uint32_t a, uint32_t b) {
+    float32_t x, z;
+    x.v = a;
+    z.v = b;
+    return f32_mul(x, z).v;
+  }
+};
+template <> struct SoftFloatOps<fmul_soft::binary64> {
+  static const bool ok = true;
+  static uint64_t mul(uint64_t a, uint64_t b) {
+    float64_t x, z;
+    x.v = a;
+    z.v = b;
+    return f64_mul(x, z).v;
+  }
+};
+
+static inline std::mutex& softfloat_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+template <class F>
+static void softfloat_oracle_batch(const typename F::word* a, const typename F::word* b,
+                                   typename F::word* y, uint8_t* flags, size_t n, int rm,
+                                   bool subn) {
+  typedef typename F::word word;
+  std::lock_guard<std::mutex> lock(softfloat_mutex());
+  // rm encodes like softfloat_round_*; 5..7 round like RNE, as in the RTL
+  softfloat_roundingMode = (uint_fast8_t)(rm <= RM_RMM ? rm : RM_RNE);
+  softfloat_detectTininess = softfloat_tininess_afterRounding;
+
+  for (size_t i = 0; i < n; i++) {
+    word x = a[i], z = b[i];
+    if (!subn) {
+      if (F::is_sub(x)) x &= F::SIGN;
+      if (F::is_sub(z)) z &= F::SIGN;
+    }
+    softfloat_exceptionFlags = 0;
+    word w = SoftFloatOps<F>::mul(x, z);
+    const uint_fast8_t e = softfloat_exceptionFlags;
+    uint8_t f = (uint8_t)(((e & softfloat_flag_invalid) ? FLAG_INVALID : 0) |
+                          ((e & softfloat_flag_overflow) ? FLAG_OVERFLOW : 0) |
+                          ((e & softfloat_flag_underflow) ? FLAG_UNDERFLOW : 0) |
+                          ((e & softfloat_flag_inexact) ? FLAG_INEXACT : 0));
+    if (F::is_nan(w)) {
+      w = F::QNAN;
+      if (F::is_nan(x) || F::is_nan(z)) f &= (uint8_t)~FLAG_INVALID;
+    } else if (!subn && (F::is_sub(w) || (f & FLAG_UNDERFLOW))) {
+      // FTZ: every tiny result, exact or not, is a signed zero
+      w &= F::SIGN;
+      f = FLAG_UNDERFLOW | FLAG_INEXACT;
+    }
+    y[i] = w;
+    flags[i] = f;
+  }
+}
+#endif // FMUL_SOFTFLOAT
+
+// -------------------------------------------------------------------
+// Why oracle o cannot check format F in mode rm, nullptr if it can
+// -------------------------------------------------------------------
+template <class F>
+static const char* oracle_unsupported(Oracle o, int rm, bool subn) {
+  (void)rm;
+  (void)subn;
+  switch (o) {
+    case Oracle::Host:
+#ifdef FMUL_SOFT_X86
+      if (std::is_void<typename HostFloat<F>::type>::value) {
+        return "the host FPU multiplies binary32 and binary64 only";
+      }
+      if (rm == RM_RMM) return "x86 has no round to nearest, ties away mode";
+      return nullptr;
+#else
+      return "the host oracle needs an x86 FPU (MXCSR DAZ/FTZ)";
+#endif
+    case Oracle::SoftFloat:
+#if FMUL_SOFTFLOAT
+      if (!SoftFloatOps<F>::ok) return "SoftFloat has binary16, binary32 and binary64 only";
+      return nullptr;
+#else
+      return "built without SoftFloat, see run_verilator.sh --softfloat";
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+// Formats without a host type or SoftFloat function never get here
+template <class F>
+static void host_oracle(const typename F::word*, const typename F::word*, typename F::word*,
+                        uint8_t*, size_t, int, bool, std::false_type) {}
+template <class F>
+static void host_oracle(const typename F::word* a, const typename F::word* b,
+                        typename F::word* y, uint8_t* flags, size_t n, int rm, bool subn,
+                        std::true_type) {
+#ifdef FMUL_SOFT_X86
+  host_oracle_batch<F, typename HostFloat<F>::type>(a, b, y, flags, n, rm, subn);
+#else
+  (void)a; (void)b; (void)y; (void)flags; (void)n; (void)rm; (void)subn;
+#endif
+}
+
+#if FMUL_SOFTFLOAT
+template <class F>
+static void softfloat_oracle(const typename F::word*, const typename F::word*, typename F::word*,
+                             uint8_t*, size_t, int, bool, std::false_type) {}
+template <class F>
+static void softfloat_oracle(const typename F::word* a, const typename F::word* b,
+                             typename F::word* y, uint8_t* flags, size_t n, int rm, bool subn,
+                             std::true_type) {
+  softfloat_oracle_batch<F>(a, b, y, flags, n, rm, subn);
+}
+#endif
+
+// -------------------------------------------------------------------
+// n products of format F in the layout of ref_model_batch(): y[] and one
+// packed flag byte per vector. o must be supported (oracle_unsupported()).
+// -------------------------------------------------------------------
+template <class F>
+static void oracle_batch(Oracle o, const typename F::word* a, const typename F::word* b,
+                         typename F::word* y, uint8_t* flags, size_t n, int rm, bool subn) {
+  if (o == Oracle::Host) {
+    host_oracle<F>(a, b, y, flags, n, rm, subn,
+                   std::integral_constant<bool, !std::is_void<typename HostFloat<F>::type>::value>());
+  }
+#if FMUL_SOFTFLOAT
+  if (o == Oracle::SoftFloat) {
+    softfloat_oracle<F>(a, b, y, flags, n, rm, subn,
+                        std::integral_constant<bool, SoftFloatOps<F>::ok>());
+  }
+#endif
+}
+
+#endif // FMUL_ORACLE_H
@@ -0,0 +1,548 @@
+// fmul_ref.h
+//
+// Reference model of fmul: DAZ/FTZ (or gradual underflow for a
+// SUBNORMAL_SUPPORT build, FMUL_SUBNORMAL), constant qNaN, the five IEEE 754
+// rounding modes of the rm input (round to nearest even by default). The
+// multiply itself is sw/fmul_soft.h, the software library that firmware and
+// emulators share; this header binds it to the format of the build and adds
+// the testbench-only models.
+//  - FpFormat<E,M,B>    field helpers of a format with the RTL parameters
+//                       EXP/MANT/BIAS (fmul_soft::Format). RefFmt is the
+//                       format of this build (FMUL_EXP/FMUL_MANT/FMUL_BIAS,
+//                       binary32 by default), fp_word the smallest unsigned
+//                       type holding one value
+//  - ref_model_t<F>()   one operand pair of format F, rm and subnormal
+//                       handling picked at runtime (fmul_soft::mul)
+//  - ref_model()        ref_model_t<RefFmt>, subnormal handling of the build
+//  - ref_model_batch()  n operand pairs into a structure-of-arrays result
+//                       (ref_batch_select() returns the kernel for a loop):
+//                       y[] plus one packed flag byte per vector.
+//                       AVX-512 (16 lanes) or AVX2 (8 lanes) kernels selected
+//                       at runtime for binary32 in every rounding mode,
+//                       scalar fallback (and scalar for every other format
+//                       and for gradual underflow).
+//                       Bit-exact with ref_model() for y and all four flags.
+//  - first_mismatch()   vectorized compare of two such result arrays
+//  - ref_fma()          scalar fused multiply-add a*b + c for ffma, exact sum
+//                       and a single rounding, same DAZ/FTZ/qNaN conventions
+//  - RefDot<F>          exact dot product accumulator for fdot: add() pairs
+//                       in any order, result() rounds the sum once
+
+#ifndef FMUL_REF_H
+#define FMUL_REF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../sw/fmul_soft.h"
+
+// Format of this build, must match the DUT parameters (run_verilator.sh
+// --format passes the same values as -GEXP/-GMANT/-GBIAS)
+#ifndef FMUL_EXP
+#define FMUL_EXP 8
+#endif
+#ifndef FMUL_MANT
+#define FMUL_MANT 23
+#endif
+#ifndef FMUL_BIAS
+#define FMUL_BIAS 127
+#endif
+
+// Gradual underflow instead of DAZ/FTZ, must match the DUT parameter
+// SUBNORMAL_SUPPORT (run_verilator.sh --subnormal passes both)
+#ifndef FMUL_SUBNORMAL
+#define FMUL_SUBNORMAL 0
+#endif
+
+// The SIMD kernels are written for binary32 only
+#if defined(FMUL_SOFT_X86) && FMUL_EXP == 8 && FMUL_MANT == 23 && FMUL_BIAS == 127
+#define FMUL_REF_SIMD 1
+#endif
+
+template <int E, int M, int B>
+using FpFormat = fmul_soft::Format<E, M, B>;
+
+typedef FpFormat<FMUL_EXP, FMUL_MANT, FMUL_BIAS> RefFmt;
+typedef RefFmt::word fp_word;
+
+static const int REF_EXP  = RefFmt::EXP;
+static const int REF_MANT = RefFmt::MANT;
+static const int REF_BIAS = RefFmt::BIAS;
+static const bool REF_SUBNORMAL = FMUL_SUBNORMAL != 0;
+
+// Helpers to extract sign, exp and mantissa
+static inline fp_word sign_bit(fp_word x) { return RefFmt::sign_bit(x); }
+static inline fp_word exp_field(fp_word x) { return RefFmt::exp_field(x); }
+static inline fp_word frac_field(fp_word x) { return RefFmt::frac_field(x); }
+
+// Check if NaN
+static inline bool is_nan_bits(fp_word x) { return RefFmt::is_nan(x); }
+// Check if Inf
+static inline bool is_inf_bits(fp_word x) { return RefFmt::is_inf(x); }
+// Check if zero
+static inline bool is_zero_bits(fp_word x) { return RefFmt::is_zero(x); }
+// Check if subnormal
+static inline bool is_sub_bits(fp_word x) { return RefFmt::is_sub(x); }
+// We work only with qNaN
+static inline fp_word qnan_const() { return RefFmt::QNAN; }
+
+// Output structure
+template <class F>
+using RefOutT = fmul_soft::Result<F>;
+typedef RefOutT<RefFmt> RefOut;
+
+// Helper function to generate signed zero
+static inline fp_word pack_signed_zero(fp_word sign) { return RefFmt::zero(sign); }
+
+// Rounding modes, encoded like the DUT rm input (RISC-V frm). Reserved
+// codes 5..7 round like RNE, as in the RTL.
+enum RefRm : int {
+  RM_RNE = fmul_soft::RNE,  // nearest, ties to even
+  RM_RTZ = fmul_soft::RTZ,  // toward zero
+  RM_RDN = fmul_soft::RDN,  // toward -Inf
+  RM_RUP = fmul_soft::RUP,  // toward +Inf
+  RM_RMM = fmul_soft::RMM,  // nearest, ties away from zero
+};
+
+static inline const char* ref_rm_name(int rm) {
+  switch (rm) {
+    case RM_RTZ: return "rtz";
+    case RM_RDN: return "rdn";
+    case RM_RUP: return "rup";
+    case RM_RMM: return "rmm";
+    default:     return "rne";
+  }
+}
+
+// Round-up decision from sign s, the result LSB, the guard bit G and the
+// OR of every bit below it (sticky)
+static inline uint32_t ref_round_inc(int rm, uint32_t s, uint32_t lsb, uint32_t G, uint32_t sticky) {
+  return fmul_soft::round_inc(rm, s, lsb, G, sticky);
+}
+
+// Overflow gives the largest finite value instead of Inf when the mode
+// rounds toward zero for sign s
+static inline bool ref_ovf_max(int rm, uint32_t s) { return fmul_soft::ovf_max(rm, s); }
+
+// -------------------------------------------------------------------
+// Reference model, all NaNs are qNaN, subnormals are treated as zeros
+// (DAZ/FTZ) or, with subn, as values with gradual underflow. Each
+// configuration is its own kernel (fmul_soft::mul_k), picked here at
+// runtime; loops select one once (ref_batch_select()).
+// -------------------------------------------------------------------
+template <class F>
+static RefOutT<F> ref_model_t(typename F::word a, typename F::word b, int rm = RM_RNE,
+                              bool subn = false) {
+  return fmul_soft::mul<F>(a, b, rm, subn);
+}
+
+static inline RefOut ref_model(fp_word a, fp_word b, int rm = RM_RNE) {
+  return ref_model_t<RefFmt>(a, b, rm, REF_SUBNORMAL);
+}
+
+
+// -------------------------------------------------------------------
+// Fused multiply-add reference: a*b + c with one rounding.
+//
+// Specials follow ref_model(): any NaN (or Inf * 0) gives the qNaN, only
+// Inf * 0 and Inf - Inf raise invalid, subnormal operands are zero. An
+// exact zero sum is +0 unless both terms are -0. Otherwise the product
+// and c are placed as integers in a 128-bit window 4*MANT+8 bits (100 for
+// binary32) below the top of the larger term; a term that falls below the
+// window keeps only a sticky bit there, far under the rounding position,
+// so the sum rounds as the exact value would.
+//
+// A template so that only the formats a testbench uses are instantiated:
+// the window does not fit formats wider than MANT = 29 (e.g. binary64).
+// -------------------------------------------------------------------
+template <class F = RefFmt>
+static RefOutT<F> ref_fma(typename F::word a, typename F::word b, typename F::word c) {
+  typedef typename F::word W;
+  const int M = F::MANT;
+  const int WIN = 4 * F::MANT + 8;
+  static_assert(4 * F::MANT + 8 + 2 <= 127, "ref_fma: the sum window of this format exceeds 128 bits");
+
+  RefOutT<F> o{};
+  o.y = 0;
+  o.invalid = o.overflow = o.underflow = o.inexact = false;
+
+  const W sp = (W)((F::sign_bit(a) ^ F::sign_bit(b)) & 1u);
+  const W sc = F::sign_bit(c);
+
+  const bool a_eff_zero = F::is_zero(a) || F::is_sub(a);
+  const bool b_eff_zero = F::is_zero(b) || F::is_sub(b);
+  const bool c_eff_zero = F::is_zero(c) || F::is_sub(c);
+  const bool p_inf = F::is_inf(a) || F::is_inf(b);
+
+  // NaN input => constant qNaN; Inf * 0 is invalid even with a NaN c
+  if (F::is_nan(a) || F::is_nan(b)) {
+    o.y = F::QNAN;
+    return o;
+  }
+  const bool p_invalid = (F::is_inf(a) && b_eff_zero) || (F::is_inf(b) && a_eff_zero);
+  if (p_invalid || F::is_nan(c)) {
+    o.invalid = p_invalid;
+    o.y = F::QNAN;
+    return o;
+  }
+
+  // Inf - Inf => invalid + qNaN, otherwise an Inf term wins
+  if (p_inf && F::is_inf(c) && sp != sc) {
+    o.invalid = true;
+    o.y = F::QNAN;
+    return o;
+  }
+  if (p_inf) {
+    o.y = F::inf(sp);
+    return o;
+  }
+  if (F::is_inf(c)) {
+    o.y = c;
+    return o;
+  }
+
+  // Zero product => c exactly, +0 for 0 + 0 unless both are -0
+  if (a_eff_zero || b_eff_zero) {
+    o.y = c_eff_zero ? F::zero((W)(sp & sc)) : c;
+    return o;
+  }
+
+  // ------------------------------------------------------------
+  // Exact sum: product p * 2^ep (2*MANT+2 bits), addend cs * 2^ec (MANT+1 bits)
+  // ------------------------------------------------------------
+  const uint64_t hid = 1ull << M;
+  const uint64_t p  = (hid | F::frac_field(a)) * (hid | F::frac_field(b));
+  const int      ep = (int)F::exp_field(a) + (int)F::exp_field(b) - 2 * F::BIAS - 2 * M;
+  const uint64_t cs = c_eff_zero ? 0 : (hid | F::frac_field(c));
+  const int      ec = (int)F::exp_field(c) - F::BIAS - M;
+
+  const int top_p = ep + 2 * M + 2;
+  const int top_c = ec + M + 1;
+  const int top  = c_eff_zero ? top_p : (top_p > top_c ? top_p : top_c);
+  const int base = top - WIN;
+
+  // v * 2^e in units of 2^base, bits below the window kept as sticky
+  auto place = [base](uint64_t v, int e) -> unsigned __int128 {
+    if (v == 0) return 0;
+    if (e >= base) return (unsigned __int128)v << (e - base);
+    const int sh = base - e;
+    if (sh >= 64) return 1;
+    return (unsigned __int128)(v >> sh) | ((v & ((1ull << sh) - 1)) ? 1u : 0u);
+  };
+
+  const __int128 x = (__int128)place(p, ep);
+  const __int128 z = (__int128)place(cs, ec);
+  __int128 sum = (sp == sc) ? x + z : x - z;
+
+  // Exact cancellation => +0
+  if (sum == 0) {
+    o.y = 0;
+    return o;
+  }
+
+  W s = sp;
+  if (sum < 0) {
+    sum = -sum;
+    s ^= 1u;
+  }
+  const unsigned __int128 mag = (unsigned __int128)sum;
+
+  int msb = 127;
+  while (!((mag >> msb) & 1u)) msb--;
+
+  // (MANT+1)-bit significand, G = first dropped bit, S = OR of the rest
+  int sh = msb - M;
+  uint64_t upper_bits;
+  uint32_t G = 0, S = 0;
+  if (sh > 0) {
+    upper_bits = (uint64_t)(mag >> sh);
+    G = (uint32_t)((mag >> (sh - 1)) & 1u);
+    S = (mag & (((unsigned __int128)1 << (sh - 1)) - 1)) != 0 ? 1u : 0u;
+  } else {
+    upper_bits = (uint64_t)(mag << -sh);
+  }
+
+  // RN ties-to-even
+  upper_bits += G & (S | (upper_bits & 1u));
+  if (upper_bits >> (M + 1)) {
+    upper_bits >>= 1;
+    sh += 1;
+  }
+  const int expR = base + sh + M + F::BIAS;  // biased
+
+  if (G | S) o.inexact = true;
+
+  // Flush to zero and overflow handling, as in ref_model()
+  if (expR >= (int)F::EXP_ONES) {
+    o.overflow = true;
+    o.inexact  = true;
+    o.y = F::inf(s);
+    return o;
+  }
+  if (expR <= 0) {
+    o.underflow = true;
+    o.inexact   = true;
+    o.y = F::zero(s);
+    return o;
+  }
+
+  o.y = (W)(F::zero(s) | ((uint64_t)expR << M) | (upper_bits & F::FRAC_MASK));
+  return o;
+}
+
+// -------------------------------------------------------------------
+// Dot product reference for fdot: products added exactly, one rounding.
+//
+// add() places the exact product of an operand pair in a two's complement
+// integer of 64-bit limbs, LSB weight 2^(2 - 2*BIAS - 2*MANT) (the
+// smallest normal times the smallest normal), wide enough for any product
+// of the format plus 64 carry bits; result() rounds the sum in mode rm.
+// The sum and so the result do not depend on the order of the add()s.
+//
+// Specials as in fdot: a NaN operand gives the qNaN, Inf * 0 or products of
+// both infinite signs give the qNaN with invalid, subnormal operands are
+// zero, a result below the normal range flushes to zero. An exact zero sum
+// is -0 when every product is a zero with sign bit set, -0 for RDN when
+// products cancel or zeros of both signs meet, +0 otherwise.
+// -------------------------------------------------------------------
+template <class F = RefFmt>
+struct RefDot {
+  typedef typename F::word W;
+  typedef unsigned __int128 U128;
+
+  static const int ACC_BITS = 2 * F::MANT + 2 + (1 << (F::EXP + 1)) - 6 + 64;
+  static const int LIMBS = (ACC_BITS + 63) / 64;
+
+  uint64_t acc[LIMBS];
+  bool nan, invalid, inf_pos, inf_neg, finite, zero_pos, zero_neg;
+
+  RefDot() { clear(); }
+
+  void clear() {
+    std::memset(acc, 0, sizeof acc);
+    nan = invalid = inf_pos = inf_neg = finite = zero_pos = zero_neg = false;
+  }
+
+  void add(W a, W b) {
+    const W s = (W)((F::sign_bit(a) ^ F::sign_bit(b)) & 1u);
+    const bool a_daz = F::is_zero(a) || F::is_sub(a);
+    const bool b_daz = F::is_zero(b) || F::is_sub(b);
+
+    if (F::is_nan(a) || F::is_nan(b)) {
+      nan = true;
+      return;
+    }
+    if ((F::is_inf(a) && b_daz) || (F::is_inf(b) && a_daz)) {
+      nan = invalid = true;
+      return;
+    }
+    if (F::is_inf(a) || F::is_inf(b)) {
+      (s ? inf_neg : inf_pos) = true;
+      return;
+    }
+    if (a_daz || b_daz) {
+      (s ? zero_neg : zero_pos) = true;
+      return;
+    }
+    finite = true;
+
+    // p << sh as three limbs from limb k0 on
+    const uint64_t hid = 1ull << F::MANT;
+    const U128 p = (U128)(hid | F::frac_field(a)) * (U128)(hid | F::frac_field(b));
+    const int sh = (int)F::exp_field(a) + (int)F::exp_field(b) - 2;
+    const int k0 = sh / 64, off = sh % 64;
+    const uint64_t lo = (uint64_t)p, hi = (uint64_t)(p >> 64);
+    const uint64_t part[3] = {lo << off, off ? (hi << off) | (lo >> (64 - off)) : hi,
+                              off ? hi >> (64 - off) : 0};
+
+    uint64_t c = 0;
+    for (int k = k0; k < LIMBS; k++) {
+      const uint64_t v = k - k0 < 3 ? part[k - k0] : 0;
+      if (k - k0 >= 3 && c == 0) break;
+      const U128 x = s ? (U128)acc[k] - v - c : (U128)acc[k] + v + c;
+      acc[k] = (uint64_t)x;
+      c = (uint64_t)(x >> 64) & 1u;
+    }
+  }
+
+  RefOutT<F> result(int rm = RM_RNE) const {
+    const int M = F::MANT;
+    RefOutT<F> o{};
+    o.y = 0;
+    o.invalid = o.overflow = o.underflow = o.inexact = false;
+
+    if (nan || (inf_pos && inf_neg)) {
+      o.invalid = invalid || (inf_pos && inf_neg);
+      o.y = F::QNAN;
+      return o;
+    }
+    if (inf_pos || inf_neg) {
+      o.y = F::inf(inf_neg);
+      return o;
+    }
+
+    // Sign and magnitude
+    uint64_t mag[LIMBS];
+    const W s = (W)(acc[LIMBS - 1] >> 63);
+    uint64_t c = s;
+    for (int k = 0; k < LIMBS; k++) {
+      const U128 x = (U128)(s ? ~acc[k] : acc[k]) + c;
+      mag[k] = (uint64_t)x;
+      c = (uint64_t)(x >> 64);
+    }
+
+    int msb = LIMBS * 64 - 1;
+    while (msb >= 0 && !((mag[msb / 64] >> (msb % 64)) & 1u)) msb--;
+    if (msb < 0) {
+      const bool neg = (finite || (zero_pos && zero_neg)) ? rm == RM_RDN : zero_neg;
+      o.y = F::zero((W)neg);
+      return o;
+    }
+
+    auto bit = [&mag](int i) -> uint64_t {
+      return i < 0 ? 0 : (mag[i / 64] >> (i % 64)) & 1u;
+    };
+    // OR of bits [0, n)
+    auto any_below = [&mag](int n) -> bool {
+      for (int k = 0; k < n / 64; k++) {
+        if (mag[k]) return true;
+      }
+      return n > 0 && n % 64 && (mag[n / 64] & ((1ull << (n % 64)) - 1)) != 0;
+    };
+
+    // (MANT+1)-bit significand below the leading one, G = first dropped bit
+    uint64_t upper_bits = 0;
+    for (int j = 0; j <= M; j++) upper_bits = (upper_bits << 1) | bit(msb - j);
+    const uint32_t G = (uint32_t)bit(msb - M - 1);
+    const uint32_t S = any_below(msb - M - 1) ? 1u : 0u;
+
+    upper_bits += ref_round_inc(rm, (uint32_t)s, (uint32_t)(upper_bits & 1u), G, S);
+    int expR = msb + 2 - F::BIAS - 2 * M;  // biased
+    if (upper_bits >> (M + 1)) {
+      upper_bits >>= 1;
+      expR += 1;
+    }
+    o.inexact = (G | S) != 0;
+
+    // Flush to zero and overflow handling, as in ref_model()
+    if (expR >= (int)F::EXP_ONES) {
+      o.overflow = true;
+      o.inexact  = true;
+      o.y = ref_ovf_max(rm, (uint32_t)s) ? F::max_finite(s) : F::inf(s);
+      return o;
+    }
+    if (expR <= 0) {
+      o.underflow = true;
+      o.inexact   = true;
+      o.y = F::zero(s);
+      return o;
+    }
+
+    o.y = (W)(F::zero(s) | ((uint64_t)expR << M) | (upper_bits & F::FRAC_MASK));
+    return o;
+  }
+};
+
+
+// -------------------------------------------------------------------
+// Batched reference model, fmul_soft's batch kernels for RefFmt
+//
+// Flags are packed per lane as {invalid, overflow, underflow, inexact}
+// (bit 3..0), the same order as the DUT ports.
+// -------------------------------------------------------------------
+typedef fmul_soft::Isa RefIsa;
+
+static inline const char* ref_isa_name(RefIsa isa) { return fmul_soft::isa_name(isa); }
+
+// Packed flag bits, same order as the DUT ports {invalid, overflow, underflow, inexact}
+using fmul_soft::FLAG_INEXACT;
+using fmul_soft::FLAG_UNDERFLOW;
+using fmul_soft::FLAG_OVERFLOW;
+using fmul_soft::FLAG_INVALID;
+using fmul_soft::FLAG_ALL;
+
+static inline uint8_t pack_ref_flags(const RefOut& o) { return fmul_soft::pack_flags(o); }
+
+static inline RefOut unpack_ref_flags(fp_word y, uint8_t fl) {
+  return fmul_soft::unpack_flags<RefFmt>(y, fl);
+}
+
+// Batch kernel: n pairs into y[] and packed flags, one configuration
+typedef fmul_soft::Batch<RefFmt>::Fn RefBatchFn;
+
+// Widest kernel the host supports
+static inline RefIsa ref_isa_best() {
+#ifdef FMUL_REF_SIMD
+  return fmul_soft::isa_best();
+#else
+  return RefIsa::Scalar;
+#endif
+}
+
+// Kernel used by ref_model_batch(); may be lowered (e.g. --ref-isa)
+static RefIsa REF_ISA = ref_isa_best();
+
+// SIMD kernels run with DAZ/FTZ only
+static const bool REF_BATCH_SIMD = !REF_SUBNORMAL;
+
+// Batch kernel for rounding mode rm on isa, subnormal handling of the
+// build. A loop over many batches selects once and calls the result.
+static inline RefBatchFn ref_batch_select(int rm, RefIsa isa) {
+  return fmul_soft::batch_select<RefFmt>(rm, REF_SUBNORMAL, isa);
+}
+
+static inline void ref_model_batch(const fp_word* a, const fp_word* b,
+                                   fp_word* y, uint8_t* flags, size_t n,
+                                   int rm = RM_RNE) {
+  ref_batch_select(rm, REF_ISA)(a, b, y, flags, n);
+}
+
+// -------------------------------------------------------------------
+// Mismatch scan over two result arrays: index of the first i where
+// y0[i] != y1[i] or (f0[i] ^ f1[i]) & fmask != 0, or n if none.
+// -------------------------------------------------------------------
+static inline size_t first_mismatch_scalar(const fp_word* y0, const uint8_t* f0,
+                                           const fp_word* y1, const uint8_t* f1,
+                                           size_t n, uint8_t fmask) {
+  for (size_t i = 0; i < n; i++) {
+    if ((y0[i] != y1[i]) || ((f0[i] ^ f1[i]) & fmask)) return i;
+  }
+  return n;
+}
+
+#ifdef FMUL_REF_SIMD
+// 32 vectors per step: four y compares and one 32-byte flag compare
+__attribute__((target("avx2")))
+static size_t first_mismatch_avx2(const uint32_t* y0, const uint8_t* f0,
+                                  const uint32_t* y1, const uint8_t* f1,
+                                  size_t n, uint8_t fmask) {
+  const __m256i vmask = _mm256_set1_epi8((char)fmask);
+  size_t i = 0;
+
+  for (; i + 32 <= n; i += 32) {
+    __m256i diff = _mm256_and_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(f0 + i)),
+                                                     _mm256_loadu_si256((const __m256i*)(f1 + i))),
+                                    vmask);
+    for (int k = 0; k < 32; k += 8) {
+      diff = _mm256_or_si256(diff, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(y0 + i + k)),
+                                                    _mm256_loadu_si256((const __m256i*)(y1 + i + k))));
+    }
+    if (!_mm256_testz_si256(diff, diff)) break;
+  }
+
+  return i + first_mismatch_scalar(y0 + i, f0 + i, y1 + i, f1 + i, n - i, fmask);
+}
+#endif
+
+static inline size_t first_mismatch(const fp_word* y0, const uint8_t* f0,
+                                    const fp_word* y1, const uint8_t* f1,
+                                    size_t n, uint8_t fmask) {
+#ifdef FMUL_REF_SIMD
+  if (REF_ISA != RefIsa::Scalar) return first_mismatch_avx2(y0, f0, y1, f1, n, fmask);
+#endif
+  return first_mismatch_scalar(y0, f0, y1, f1, n, fmask);
+}
+
+#endif // FMUL_REF_H
@@ -0,0 +1,268 @@
+// fmul_regdb.h
+//
+// Regression database (--db DIR): what every run did, and the failing
+// vectors it found, kept across runs.
+//  - DIR/runs.jsonl  one JSON line per run: configuration, stimulus range,
+//                    throughput, coverage bins and failing vectors
+//                    (written by the testbench, under RegDbLock)
+//  - DIR/corpus-e<EXP>m<MANT>b<BIAS>-<rm>-<ftz|sub>.fvec
+//                    minimized failing pairs of one format, rounding mode
+//                    and subnormal handling, a vector file (fmul_vecfile.h)
+//                    with the reference results. Replayed before the
+//                    stimulus of every later run with the same
+//                    configuration, and with --replay like any other file
+//  - shrink_failure() moves a failing pair toward the simplest pair that
+//                    still fails the same way (same y/flag mismatch)
+//  - RegDbLock       flock() on DIR/lock, so concurrent runs append whole
+//                    lines and merge the corpus without losing entries
+
+#ifndef FMUL_REGDB_H
+#define FMUL_REGDB_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmul_ref.h"
+#include "fmul_vecfile.h"
+
+typedef std::pair<fp_word, fp_word> RegPair;
+
+static const size_t REGDB_CORPUS_MAX = VECFILE_BLOCK;  // pairs kept per corpus file
+static const int REGDB_SHRINK_ROUNDS = 512;            // candidate batches per pair
+
+// -------------------------------------------------------------------
+// Database directory, lock and file names
+// -------------------------------------------------------------------
+static inline bool regdb_open_dir(const std::string& dir, std::string& err) {
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    err = "cannot create " + dir;
+    return false;
+  }
+  struct stat sb;
+  if (stat(dir.c_str(), &sb) != 0 || !S_ISDIR(sb.st_mode)) {
+    err = dir + " is not a directory";
+    return false;
+  }
+  return true;
+}
+
+class RegDbLock {
+public:
+  explicit RegDbLock(const std::string& dir) {
+    fd_ = ::open((dir + "/lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ >= 0 && flock(fd_, LOCK_EX) != 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+  RegDbLock(const RegDbLock&) = delete;
+  RegDbLock& operator=(const RegDbLock&) = delete;
+  ~RegDbLock() {
+    if (fd_ >= 0) {
+      flock(fd_, LOCK_UN);
+      ::close(fd_);
+    }
+  }
+  bool locked() const { return fd_ >= 0; }
+
+private:
+  int fd_ = -1;
+};
+
+static inline std::string regdb_corpus_path(const std::string& dir, int rm) {
+  char name[64];
+  std::snprintf(name, sizeof name, "/corpus-e%dm%db%d-%s-%s.fvec", REF_EXP, REF_MANT, REF_BIAS,
+                ref_rm_name(rm), REF_SUBNORMAL ? "sub" : "ftz");
+  return dir + name;
+}
+
+// -------------------------------------------------------------------
+// Corpus file: operand pairs in first-found order, the reference results
+// of the file's rounding mode stored alongside so --replay works on it.
+// One block of exactly the corpus size, no padding.
+// -------------------------------------------------------------------
+
+// A missing file is an empty corpus
+static inline bool regdb_load_corpus(const std::string& path, std::vector<RegPair>& out,
+                                     std::string& err) {
+  out.clear();
+  if (access(path.c_str(), F_OK) != 0) return true;
+  VecFileReader vf;
+  if (!vf.open(path, err)) return false;
+  const VecFileHeader& h = vf.header();
+  if (h.exp != REF_EXP || h.mant != REF_MANT || h.bias != REF_BIAS ||
+      h.subnormal != (REF_SUBNORMAL ? VECFILE_SUBNORMAL_GRADUAL : VECFILE_SUBNORMAL_FTZ)) {
+    err = path + " holds vectors of another format or subnormal handling";
+    return false;
+  }
+  for (uint64_t k = 0; k < vf.blocks(); k++) {
+    const VecBlock blk = vf.block(k);
+    for (size_t i = 0; i < blk.n; i++) out.emplace_back(blk.a[i], blk.b[i]);
+  }
+  return true;
+}
+
+// Adds the pairs not in the file yet, up to REGDB_CORPUS_MAX, and rewrites
+// it through a temporary file. Call under RegDbLock. Returns the number
+// of pairs added, -1 on error.
+static inline long regdb_merge_corpus(const std::string& path, const std::vector<RegPair>& add,
+                                      int rm, std::string& err) {
+  std::vector<RegPair> pairs;
+  if (!regdb_load_corpus(path, pairs, err)) return -1;
+  std::set<RegPair> seen(pairs.begin(), pairs.end());
+  long added = 0;
+  for (const RegPair& p : add) {
+    if (pairs.size() == REGDB_CORPUS_MAX) break;
+    if (seen.insert(p).second) {
+      pairs.push_back(p);
+      added++;
+    }
+  }
+  if (!added) return 0;
+
+  std::vector<fp_word> a(pairs.size()), b(pairs.size()), y(pairs.size());
+  std::vector<uint8_t> flags(pairs.size());
+  for (size_t i = 0; i < pairs.size(); i++) {
+    a[i] = pairs[i].first;
+    b[i] = pairs[i].second;
+    const RefOut r = ref_model(a[i], b[i], rm);
+    y[i] = r.y;
+    flags[i] = pack_ref_flags(r);
+  }
+
+  const std::string tmp = path + ".tmp." + std::to_string((long)getpid());
+  {
+    VecFileWriter w;
+    if (!w.open(tmp, pairs.size(), REF_EXP, REF_MANT, REF_BIAS, (uint8_t)rm,
+                REF_SUBNORMAL ? VECFILE_SUBNORMAL_GRADUAL : VECFILE_SUBNORMAL_FTZ, FLAG_ALL, err,
+                (uint32_t)pairs.size())) {
+      std::remove(tmp.c_str());
+      return -1;
+    }
+    w.append(a.data(), b.data(), y.data(), flags.data(), pairs.size());
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    err = "cannot replace " + path;
+    return -1;
+  }
+  return added;
+}
+
+// -------------------------------------------------------------------
+// Failure minimization
+//
+// A failure's signature is which fields mismatch: bit 4 for y, the
+// FLAG_* bits for the flags. shrink_failure() tries batches of simpler
+// variants of the pair and moves to the simplest one with the same
+// signature until none is left: signs cleared, significand bits cleared
+// (all, one at a time, or one set in both at once), exponents stepped toward the bias alone or
+// traded between the operands so the product exponent stays put, in
+// steps of 1, 2, 4, ... Simpler is fewer significand bits, then a
+// smaller exponent distance from 1.0, then fewer sign bits; every move
+// lowers that score, so the search ends. The evaluator runs the DUT and
+// the reference on a candidate batch and fills one signature per pair,
+// returning false if the DUT hung.
+// -------------------------------------------------------------------
+static inline uint8_t regdb_fail_sig(fp_word y_dut, uint8_t f_dut, fp_word y_ref, uint8_t f_ref,
+                                     uint8_t mask) {
+  return (uint8_t)((y_dut != y_ref ? 0x10u : 0u) | ((f_dut ^ f_ref) & mask));
+}
+
+typedef std::tuple<int, int, int> RegScore;
+
+static inline RegScore regdb_score(const RegPair& p) {
+  auto bits = [](fp_word x) { return __builtin_popcountll((unsigned long long)frac_field(x)); };
+  auto dist = [](fp_word x) { return std::abs((int)exp_field(x) - REF_BIAS); };
+  return RegScore(bits(p.first) + bits(p.second), dist(p.first) + dist(p.second),
+                  (sign_bit(p.first) != 0) + (sign_bit(p.second) != 0));
+}
+
+static inline fp_word regdb_with_exp(fp_word x, int e) {
+  return (fp_word)((x & ~((fp_word)RefFmt::EXP_ONES << REF_MANT)) | ((fp_word)e << REF_MANT));
+}
+
+// Normal exponent field, specials and (sub)zeros keep their class
+static inline bool regdb_normal_exp(int e) { return e >= 1 && e < (int)RefFmt::EXP_ONES; }
+
+static inline void regdb_candidates(const RegPair& p, std::vector<RegPair>& out) {
+  out.clear();
+  for (int side = 0; side < 2; side++) {
+    const fp_word x = side ? p.second : p.first;
+    auto put = [&](fp_word v) { out.push_back(side ? RegPair(p.first, v) : RegPair(v, p.second)); };
+
+    if (sign_bit(x)) put((fp_word)(x & ~RefFmt::SIGN));
+    const fp_word m = frac_field(x);
+    if (m) put((fp_word)(x & ~RefFmt::FRAC_MASK));
+    if (m & (m - 1)) {
+      for (fp_word r = m; r; r &= (fp_word)(r - 1)) put((fp_word)(x & ~(r & (~r + 1))));
+    }
+
+    const int e = (int)exp_field(x);
+    if (!regdb_normal_exp(e)) continue;
+    const int d = REF_BIAS - e;
+    for (int s = 1; s < std::abs(d); s *= 2) put(regdb_with_exp(x, e + (d > 0 ? s : -s)));
+    if (d) put(regdb_with_exp(x, REF_BIAS));
+  }
+
+  // Significand bits set in both cleared together
+  for (fp_word r = (fp_word)(frac_field(p.first) & frac_field(p.second)); r; r &= (fp_word)(r - 1)) {
+    const fp_word bit = (fp_word)(r & (~r + 1));
+    out.emplace_back((fp_word)(p.first & ~bit), (fp_word)(p.second & ~bit));
+  }
+
+  // Exponent traded between a and b
+  const int ea = (int)exp_field(p.first), eb = (int)exp_field(p.second);
+  if (regdb_normal_exp(ea) && regdb_normal_exp(eb)) {
+    for (int s = 1; s < (int)RefFmt::EXP_ONES; s *= 2) {
+      for (int t : { s, -s }) {
+        if (regdb_normal_exp(ea - t) && regdb_normal_exp(eb + t)) {
+          out.emplace_back(regdb_with_exp(p.first, ea - t), regdb_with_exp(p.second, eb + t));
+        }
+      }
+    }
+  }
+}
+
+template <typename Eval>
+static RegPair shrink_failure(RegPair p, uint8_t sig, Eval eval) {
+  std::vector<RegPair> cand;
+  std::vector<fp_word> a, b;
+  std::vector<uint8_t> got;
+  for (int round = 0; round < REGDB_SHRINK_ROUNDS; round++) {
+    regdb_candidates(p, cand);
+    a.resize(cand.size());
+    b.resize(cand.size());
+    got.resize(cand.size());
+    for (size_t i = 0; i < cand.size(); i++) {
+      a[i] = cand[i].first;
+      b[i] = cand[i].second;
+    }
+    if (cand.empty() || !eval(a.data(), b.data(), got.data(), cand.size())) break;
+
+    const RegScore cur = regdb_score(p);
+    size_t best = cand.size();
+    for (size_t i = 0; i < cand.size(); i++) {
+      if (got[i] != sig || !(regdb_score(cand[i]) < cur)) continue;
+      if (best == cand.size() || regdb_score(cand[i]) < regdb_score(cand[best])) best = i;
+    }
+    if (best == cand.size()) break;
+    p = cand[best];
+  }
+  return p;
+}
+
+#endif // FMUL_REGDB_H
@@ -0,0 +1,83 @@
+// fmul_stats.h
+//
+// Software model of the fmul_stats counters (rtl/fmul_stats.sv): the same
+// result classes, flag counts and subnormal-operand count, at the same CSR
+// addresses, so a histogram from simulation compares directly with
+// counters read back from silicon.
+//  - stats_class()  result class of one result, first match as in the RTL
+//  - FmulStats      counters, sampled per vector, mergeable across threads;
+//                   sat() is what a CNT_W-bit hardware counter reads
+//
+// Everything follows the build format (RefFmt in fmul_ref.h).
+
+#ifndef FMUL_STATS_H
+#define FMUL_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "fmul_ref.h"
+
+// CSR addresses, fmul_stats_pkg
+enum StatCounter {
+  STAT_TOTAL, STAT_INVALID, STAT_NAN, STAT_OVERFLOW, STAT_INF, STAT_UNDERFLOW, STAT_ZERO,
+  STAT_FINITE, STAT_F_INVALID, STAT_F_OVERFLOW, STAT_F_UNDERFLOW, STAT_F_INEXACT, STAT_SUB_IN,
+  STAT_N
+};
+
+static const char* const STAT_NAME[STAT_N] = {
+  "total", "invalid", "nan", "overflow", "inf", "underflow", "zero",
+  "finite", "flag invalid", "flag overflow", "flag underflow", "flag inexact", "subnormal in"
+};
+
+static inline int stats_class(fp_word y, uint8_t flags) {
+  if (flags & FLAG_INVALID)   return STAT_INVALID;
+  if (is_nan_bits(y))         return STAT_NAN;
+  if (flags & FLAG_OVERFLOW)  return STAT_OVERFLOW;
+  if (is_inf_bits(y))         return STAT_INF;
+  if (flags & FLAG_UNDERFLOW) return STAT_UNDERFLOW;
+  if (is_zero_bits(y))        return STAT_ZERO;
+  return STAT_FINITE;
+}
+
+struct FmulStats {
+  uint64_t cnt[STAT_N] = {};
+
+  void sample(fp_word a, fp_word b, fp_word y, uint8_t flags) {
+    cnt[STAT_TOTAL]++;
+    cnt[stats_class(y, flags)]++;
+    cnt[STAT_F_INVALID]   += (flags & FLAG_INVALID) != 0;
+    cnt[STAT_F_OVERFLOW]  += (flags & FLAG_OVERFLOW) != 0;
+    cnt[STAT_F_UNDERFLOW] += (flags & FLAG_UNDERFLOW) != 0;
+    cnt[STAT_F_INEXACT]   += (flags & FLAG_INEXACT) != 0;
+    cnt[STAT_SUB_IN]      += is_sub_bits(a) || is_sub_bits(b);
+  }
+
+  void sample(const fp_word* a, const fp_word* b, const fp_word* y, const uint8_t* flags,
+              size_t n) {
+    for (size_t i = 0; i < n; i++) sample(a[i], b[i], y[i], flags[i]);
+  }
+
+  void merge(const FmulStats& o) {
+    for (int k = 0; k < STAT_N; k++) cnt[k] += o.cnt[k];
+  }
+
+  // Counter k as a saturating cnt_w-bit counter
+  uint64_t sat(int k, int cnt_w) const {
+    const uint64_t max = cnt_w >= 64 ? ~0ull : (1ull << cnt_w) - 1;
+    return cnt[k] < max ? cnt[k] : max;
+  }
+
+  void print() const {
+    std::printf("Stats     : %llu results (CSR address, counter, share of results)\n",
+                (unsigned long long)cnt[STAT_TOTAL]);
+    for (int k = 1; k < STAT_N; k++) {
+      std::printf("            %2d %-14s %12llu  %8.4f%%\n", k, STAT_NAME[k],
+                  (unsigned long long)cnt[k],
+                  cnt[STAT_TOTAL] ? 100.0 * (double)cnt[k] / (double)cnt[STAT_TOTAL] : 0.0);
+    }
+  }
+};
+
+#endif
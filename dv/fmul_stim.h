@@ -0,0 +1,210 @@
+// fmul_stim.h
+//
+// Random operand generator for the fmul testbench.
+//  - Philox4x32-10 counter-based PRNG (Salmon et al., SC'11): vector i of a
+//    run is a pure function of (--seed, i). Jumping a shard or a resumed run
+//    to any position is just setting the counter, and the stream does not
+//    depend on --batch, --chunk or --jobs.
+//  - One Philox block (128 bits) per vector: one 64-bit draw per operand,
+//    high 32 bits pick the operand class, low 32 bits are the payload.
+//    Formats wider than 32 bits take the upper payload bits from a second
+//    counter stream, so the selectors and low payloads are unchanged.
+//  - Three-operand DUTs (ffma) draw c from a second counter stream, so a
+//    and b of vector i are the same as in the fmul stream.
+//  - Class mix is a weight table (StimWeights), default equal to the original
+//    12-way mix: +0, -0, +Inf, -Inf, NaN, exp=0, exp=1, exp=254 once each and
+//    uniform bits 4 times. The masks follow the build format (RefFmt);
+//    "exp254" is the largest finite binade, all-ones exponent minus one.
+
+#ifndef FMUL_STIM_H
+#define FMUL_STIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "fmul_ref.h"
+
+enum StimClass {
+  STIM_PZERO,
+  STIM_NZERO,
+  STIM_PINF,
+  STIM_NINF,
+  STIM_NAN,
+  STIM_EXP0,    // subnormal/zero, random sign and fraction
+  STIM_EXP1,    // smallest normal binade
+  STIM_EXP254,  // largest finite binade
+  STIM_UNIFORM, // all bits random
+  STIM_NCLASS
+};
+
+static inline const char* stim_class_name(int c) {
+  static const char* const names[STIM_NCLASS] = {
+    "+0", "-0", "+inf", "-inf", "nan", "exp0", "exp1", "exp254", "uniform"
+  };
+  return (c >= 0 && c < STIM_NCLASS) ? names[c] : "?";
+}
+
+// operand = (payload & and_mask) | or_mask, per class
+struct StimMask {
+  fp_word and_mask;
+  fp_word or_mask;
+};
+
+static const fp_word STIM_SIGN_FRAC = RefFmt::SIGN | RefFmt::FRAC_MASK;
+
+static const StimMask STIM_MASKS[STIM_NCLASS] = {
+  { 0, 0 },                                                          // +0
+  { 0, RefFmt::SIGN },                                               // -0
+  { 0, RefFmt::INF },                                                // +Inf
+  { 0, (fp_word)(RefFmt::SIGN | RefFmt::INF) },                      // -Inf
+  { 0, (fp_word)(RefFmt::QNAN | 1u) },                               // NaN
+  { STIM_SIGN_FRAC, 0 },                                             // exp=0
+  { STIM_SIGN_FRAC, (fp_word)(1ull << REF_MANT) },                   // exp=1
+  { STIM_SIGN_FRAC, (fp_word)((RefFmt::EXP_ONES - 1ull) << REF_MANT) }, // exp=254
+  { RefFmt::MASK, 0 },                                               // uniform
+};
+
+struct StimWeights {
+  uint32_t w[STIM_NCLASS] = { 1, 1, 1, 1, 1, 1, 1, 1, 4 };
+
+  uint64_t total() const {
+    uint64_t t = 0;
+    for (int c = 0; c < STIM_NCLASS; c++) t += w[c];
+    return t;
+  }
+
+  // "w0,w1,...,w8" in StimClass order. Returns false on a malformed list
+  // or when every weight is zero.
+  bool parse(const char* s) {
+    StimWeights tmp;
+    for (int c = 0; c < STIM_NCLASS; c++) {
+      char* end = nullptr;
+      unsigned long v = std::strtoul(s, &end, 0);
+      if (end == s || v > 0xFFFFFFFFul) return false;
+      tmp.w[c] = (uint32_t)v;
+      s = end;
+      if (c + 1 < STIM_NCLASS) {
+        if (*s != ',') return false;
+        s++;
+      }
+    }
+    if (*s != '\0' || tmp.total() == 0) return false;
+    *this = tmp;
+    return true;
+  }
+
+  std::string str() const {
+    std::string out;
+    char tmp[16];
+    for (int c = 0; c < STIM_NCLASS; c++) {
+      std::snprintf(tmp, sizeof tmp, "%s%u", c ? "," : "", w[c]);
+      out += tmp;
+    }
+    return out;
+  }
+};
+
+class StimGen {
+public:
+  explicit StimGen(uint64_t seed, const StimWeights& wt = StimWeights()) {
+    // splitmix64 so that nearby seeds give unrelated keys
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    key0_ = (uint32_t)z;
+    key1_ = (uint32_t)(z >> 32);
+    set_weights(wt);
+  }
+
+  // Cumulative class boundaries on the 32-bit selector: the class of a
+  // selector s is the number of cuts <= s.
+  void set_weights(const StimWeights& wt) {
+    const uint64_t total = wt.total() ? wt.total() : 1;
+    uint64_t acc = 0;
+    for (int c = 0; c + 1 < STIM_NCLASS; c++) {
+      acc += wt.w[c];
+      cut_[c] = (uint64_t)(((unsigned __int128)acc << 32) / total);
+    }
+  }
+
+  int classify(uint32_t sel) const {
+    int c = 0;
+    for (int k = 0; k + 1 < STIM_NCLASS; k++) c += (uint64_t)sel >= cut_[k];
+    return c;
+  }
+
+  fp_word operand(uint32_t sel, uint64_t payload) const {
+    const StimMask& m = STIM_MASKS[classify(sel)];
+    return (fp_word)(((fp_word)payload & m.and_mask) | m.or_mask);
+  }
+
+  // Operands of vector i of the stream
+  void vector(uint64_t i, fp_word& a, fp_word& b) const {
+    uint32_t x[4];
+    philox(i, x);
+    uint64_t pa = x[0], pb = x[2];
+    if (RefFmt::WIDTH > 32) {
+      uint32_t h[4];
+      philox(i, h, WIDE_STREAM);
+      pa |= (uint64_t)h[0] << 32;
+      pb |= (uint64_t)h[1] << 32;
+    }
+    a = operand(x[1], pa);
+    b = operand(x[3], pb);
+  }
+
+  // Vectors [first, first + n) of the stream
+  void fill(uint64_t first, fp_word* a, fp_word* b, size_t n) const {
+    for (size_t i = 0; i < n; i++) vector(first + i, a[i], b[i]);
+  }
+
+  // Third operand of vector i, plus 32 spare random bits for the caller
+  fp_word addend(uint64_t i, uint32_t& spare) const {
+    uint32_t x[4];
+    philox(i, x, ADDEND_STREAM);
+    spare = x[2];
+    return operand(x[1], ((uint64_t)x[3] << 32) | x[0]);
+  }
+
+  // Raw 128-bit block at counter ctr, for generators built on this stream
+  void block(uint64_t ctr, uint32_t x[4]) const { philox(ctr, x); }
+
+private:
+  // High counter words of the addend stream and of the upper payload bits
+  // of formats wider than 32 bits, 0 is the a/b stream
+  static const uint64_t ADDEND_STREAM = 1;
+  static const uint64_t WIDE_STREAM = 2;
+
+  uint32_t key0_, key1_;
+  uint64_t cut_[STIM_NCLASS - 1];
+
+  static inline uint32_t mulhilo(uint32_t m, uint32_t x, uint32_t& hi) {
+    uint64_t p = (uint64_t)m * x;
+    hi = (uint32_t)(p >> 32);
+    return (uint32_t)p;
+  }
+
+  void philox(uint64_t ctr, uint32_t x[4], uint64_t ctr_hi = 0) const {
+    uint32_t c0 = (uint32_t)ctr, c1 = (uint32_t)(ctr >> 32);
+    uint32_t c2 = (uint32_t)ctr_hi, c3 = (uint32_t)(ctr_hi >> 32);
+    uint32_t k0 = key0_, k1 = key1_;
+    for (int r = 0; r < 10; r++) {
+      uint32_t hi0, hi1;
+      uint32_t lo0 = mulhilo(0xD2511F53u, c0, hi0);
+      uint32_t lo1 = mulhilo(0xCD9E8D57u, c2, hi1);
+      c0 = hi1 ^ c1 ^ k0;
+      c1 = lo1;
+      c2 = hi0 ^ c3 ^ k1;
+      c3 = lo0;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    x[0] = c0; x[1] = c1; x[2] = c2; x[3] = c3;
+  }
+};
+
+#endif // FMUL_STIM_H
@@ -1,42 +1,236 @@
-module fmul_tb;
-    parameter DATA_WIDTH = 32;
-    logic [DATA_WIDTH - 1:0] a_i;
-    logic [DATA_WIDTH - 1:0] b_i;
-    logic [DATA_WIDTH - 1:0] c_o;
-    
-    //Instanciranje DUT-a
-    fmul dut (
-    .a_i (a_i),
-    .b_i (b_i),
-    .c_o (c_o)
+`timescale 1ns / 1ps
+
+// fmul_tb.sv
+//
+// Self-checking SystemVerilog testbench for fmul. Expected results come from
+// the C++ reference model (fmul_ref.h) through DPI-C, see fmul_dpi.cpp.
+// Vectors are generated and checked in batches of BATCH: one
+// fmul_ref_batch() call per batch fills the expected y and flags through
+// open arrays, then the batch is driven through the DUT.
+//
+// Needs DPI-C and delay control only, so it runs on the commercial
+// simulators as well as Verilator 5 with --timing:
+//   verilator --binary --timing --top-module fmul_tb rtl/*.sv dv/fmul_tb.sv dv/fmul_dpi.cpp
+// (run_verilator.sh --sv-tb). The format parameters must match the
+// -DFMUL_EXP/MANT/BIAS/SUBNORMAL the DPI library was compiled with, checked
+// at time 0.
+//
+// Plusargs:
+//   +n=<N>          random vectors after the directed ones (default 100000)
+//   +seed=<S>       $urandom seed (default 1)
+//   +rm=<0..7>      rounding mode on the rm input (default 0, RNE)
+//   +check_flags    check invalid/overflow/underflow/inexact as well as y
+//   +print_ok       print passing vectors too
+//   +max_fails=<F>  stop after F failures (default 10, 0 = no limit)
+
+module fmul_tb #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17,
+    parameter FAST_ROUND = 0,
+    parameter SUBNORMAL_SUPPORT = 0,
+    parameter OPERAND_ISOLATION = 0,
+    parameter BATCH = 1024     // vectors per DPI call
+);
+
+    localparam W        = 1 + EXP + MANT;
+    localparam EXP_ONES = (1 << EXP) - 1;
+    localparam NDIR     = 12;  // directed vectors, see directed()
+
+    import "DPI-C" function void fmul_ref_config(output int ref_exp, output int ref_mant,
+                                                 output int ref_bias, output int ref_subnormal);
+    import "DPI-C" function void fmul_ref_batch(input  longint unsigned a[],
+                                                input  longint unsigned b[],
+                                                output longint unsigned y[],
+                                                output byte unsigned flags[],
+                                                input  int n,
+                                                input  int rm);
+
+    logic [W - 1:0] a;
+    logic [W - 1:0] b;
+    logic [2:0] rm;
+    logic [W - 1:0] y;
+    logic invalid;
+    logic overflow;
+    logic underflow;
+    logic inexact;
+
+    fmul #(
+        .EXP               (EXP),
+        .MANT              (MANT),
+        .BIAS              (BIAS),
+        .MULT_IMPL         (MULT_IMPL),
+        .DSP_W             (DSP_W),
+        .FAST_ROUND        (FAST_ROUND),
+        .SUBNORMAL_SUPPORT (SUBNORMAL_SUPPORT),
+        .OPERAND_ISOLATION (OPERAND_ISOLATION)
+    ) dut (
+        .a         (a),
+        .b         (b),
+        .rm        (rm),
+        .y         (y),
+        .invalid   (invalid),
+        .overflow  (overflow),
+        .underflow (underflow),
+        .inexact   (inexact)
     );
-    
+
+    // One batch: operands and the reference results for them
+    longint unsigned a_q[BATCH];
+    longint unsigned b_q[BATCH];
+    longint unsigned y_q[BATCH];
+    byte unsigned    f_q[BATCH];
+
+    // -------------------------------------------------------------------
+    // Stimulus
+    // -------------------------------------------------------------------
+    function automatic logic [W - 1:0] fp(input logic s, input int e, input longint unsigned frac);
+        logic [W - 1:0] x;
+        x = W'(frac) & W'((64'd1 << MANT) - 1);
+        x[MANT +: EXP] = EXP'(e);
+        x[W - 1]       = s;
+        return x;
+    endfunction
+
+    task automatic directed(input int k, output logic [W - 1:0] da, output logic [W - 1:0] db);
+        case (k)
+            0:  begin da = fp(0, BIAS, 0);                    db = fp(0, BIAS, 0);          end // 1 * 1
+            1:  begin da = fp(0, BIAS, 0);                    db = fp(0, BIAS + 1, 0);      end // 1 * 2
+            2:  begin da = fp(0, BIAS, 64'd1 << (MANT - 1));  db = fp(0, BIAS + 1, 0);      end // 1.5 * 2
+            3:  begin da = fp(1, BIAS, 0);                    db = fp(0, BIAS + 1, 0);      end // -1 * 2
+            4:  begin da = fp(0, 0, 0);                       db = fp(0, BIAS + 1, 0);      end // 0 * 2
+            5:  begin da = fp(1, 0, 0);                       db = fp(0, EXP_ONES, 0);      end // -0 * Inf, invalid
+            6:  begin da = fp(0, EXP_ONES, 1);                db = fp(0, BIAS, 0);          end // NaN * 1
+            7:  begin da = fp(0, EXP_ONES - 1, '1);           db = fp(0, BIAS + 1, 0);      end // max * 2, overflow
+            8:  begin da = fp(0, 1, 0);                       db = fp(0, BIAS - 1, 0);      end // min normal / 2
+            9:  begin da = fp(1, 0, 1);                       db = fp(0, BIAS, 0);          end // -min subnormal * 1
+            10: begin da = fp(0, 1, 0);                       db = fp(0, BIAS - 1, '1);     end // just below min normal
+            default: begin da = fp(0, BIAS, 1);               db = fp(0, BIAS, 1);          end // (1 + ulp)^2, inexact
+        endcase
+    endtask
+
+    function automatic logic [W - 1:0] rand_word();
+        logic [63:0] r;
+        r = {$urandom, $urandom};
+        return r[W - 1:0];
+    endfunction
+
+    // Operand class mix: signed zero, Inf, NaN, subnormal, the lowest and
+    // highest normal exponent, close to 1.0, uniform
+    function automatic logic [W - 1:0] rand_operand();
+        logic [W - 1:0] x;
+        x = rand_word();
+        case ($urandom_range(11))
+            0: x[W - 2:0] = '0;
+            1: begin x[W - 2:0] = '0; x[MANT +: EXP] = '1; end
+            2: begin x[MANT +: EXP] = '1; x[0] = 1'b1; end
+            3: x[MANT +: EXP] = '0;
+            4: x[MANT +: EXP] = EXP'(1);
+            5: x[MANT +: EXP] = EXP'(EXP_ONES - 1);
+            6: x[MANT +: EXP] = EXP'(BIAS - 1 + int'($urandom_range(2)));
+            default: ;
+        endcase
+        return x;
+    endfunction
+
+    // b for a given a with the product exponent next to the underflow or
+    // the overflow boundary; uniform when no normal exponent gets there
+    function automatic logic [W - 1:0] rand_partner(input logic [W - 1:0] x_a);
+        logic [W - 1:0] x;
+        int ea, eb;
+        x  = rand_word();
+        ea = int'(x_a[MANT +: EXP]);
+        if ($urandom_range(1) == 0) eb = BIAS - ea - (MANT + 2) + int'($urandom_range(MANT + 4));
+        else                        eb = EXP_ONES - 2 + BIAS - ea + int'($urandom_range(2));
+        if (eb >= 1 && eb < EXP_ONES) x[MANT +: EXP] = EXP'(eb);
+        return x;
+    endfunction
+
+    // -------------------------------------------------------------------
+    // Run
+    // -------------------------------------------------------------------
+    int n, seed, rm_arg, max_fails;
+    bit check_flags, print_ok;
+    int cfg_exp, cfg_mant, cfg_bias, cfg_subnormal;
+    longint tests, fails, total;
+    int nb;
+    logic [W - 1:0] va, vb;
+    logic [W - 1:0] y_ref;
+    logic [3:0] f_dut, f_ref;
+    bit ok;
+
     initial begin
-        a_i = 32'h3F800000;   // 1.0
-        b_i = 32'h3F800000;   // 1.0
-        #10;
-        //expected = 32'h3F800000
-
-        a_i = 32'h3F800000;   // 1.0
-        b_i = 32'h40000000;   // 2.0
-        #10;
-        //expected = 32'h40000000
-        
-        a_i = 32'h3FC00000;   // 1.5
-        b_i = 32'h40000000;   // 2.0
-        #10;
-        //expected = 32'h40400000
-        
-        a_i = 32'hBF800000;   // -1.0
-        b_i = 32'h40000000;   // 2.0
-        #10;
-        //expected = 32'hC0000000
-        
-        a_i = 32'h00000000;   // 0
-        b_i = 32'h40000000;   // 2.0
-        #10;
-        //expected = 32'h00000000
-    
-    end     
-    
-endmodule
\ No newline at end of file
+        if (!$value$plusargs("n=%d", n)) n = 100000;
+        if (!$value$plusargs("seed=%d", seed)) seed = 1;
+        if (!$value$plusargs("rm=%d", rm_arg)) rm_arg = 0;
+        if (!$value$plusargs("max_fails=%d", max_fails)) max_fails = 10;
+        if (max_fails <= 0) max_fails = 32'h7fff_ffff;
+        check_flags = $test$plusargs("check_flags");
+        print_ok    = $test$plusargs("print_ok");
+
+        fmul_ref_config(cfg_exp, cfg_mant, cfg_bias, cfg_subnormal);
+        if (cfg_exp != EXP || cfg_mant != MANT || cfg_bias != BIAS ||
+            cfg_subnormal != int'(SUBNORMAL_SUPPORT != 0)) begin
+            $fatal(1, "fmul_tb: DPI reference built for EXP=%0d MANT=%0d BIAS=%0d SUBNORMAL=%0d, DUT is EXP=%0d MANT=%0d BIAS=%0d SUBNORMAL=%0d",
+                   cfg_exp, cfg_mant, cfg_bias, cfg_subnormal, EXP, MANT, BIAS, SUBNORMAL_SUPPORT != 0);
+        end
+        if (rm_arg < 0 || rm_arg > 7) $fatal(1, "fmul_tb: +rm=%0d, expected 0..7", rm_arg);
+
+        void'($urandom(seed));
+        rm    = 3'(rm_arg);
+        total = NDIR + longint'(n);
+        tests = 0;
+        fails = 0;
+
+        while (tests < total && fails < longint'(max_fails)) begin
+            nb = 0;
+            while (nb < BATCH && tests + longint'(nb) < total) begin
+                if (tests + longint'(nb) < NDIR) begin
+                    directed(int'(tests) + nb, va, vb);
+                end else begin
+                    va = rand_operand();
+                    vb = ($urandom_range(3) == 0) ? rand_partner(va) : rand_operand();
+                end
+                a_q[nb] = 64'(va);
+                b_q[nb] = 64'(vb);
+                nb++;
+            end
+
+            fmul_ref_batch(a_q, b_q, y_q, f_q, nb, rm_arg);
+
+            for (int i = 0; i < nb && fails < longint'(max_fails); i++) begin
+                a = a_q[i][W - 1:0];
+                b = b_q[i][W - 1:0];
+                #1;
+                y_ref = y_q[i][W - 1:0];
+                f_ref = f_q[i][3:0];
+                f_dut = {invalid, overflow, underflow, inexact};
+                ok    = (y === y_ref) && (!check_flags || f_dut === f_ref);
+                if (!ok) fails++;
+                if (!ok || print_ok) begin
+                    $display("%s [%s %0d] a=0x%h b=0x%h rm=%0d | DUT y=0x%h flags(iovx)=%b | REF y=0x%h flags=%b",
+                             ok ? "PASS" : "FAIL", (tests < NDIR) ? "directed" : "rand",
+                             (tests < NDIR) ? tests : tests - NDIR,
+                             a, b, rm, y, f_dut, y_ref, f_ref);
+                end
+                tests++;
+            end
+        end
+
+        $display("---------------------------------------------------------------------------------------------------------------------");
+        $display("Tests run : %0d", tests);
+        $display("Failures  : %0d%s", fails, (fails >= longint'(max_fails)) ? " (stopped at +max_fails)" : "");
+        $display("Flag check: %s", check_flags ? "ENABLED (+check_flags)" : "DISABLED");
+        $display("Format    : EXP=%0d MANT=%0d BIAS=%0d", EXP, MANT, BIAS);
+        $display("Subnormal : %s", SUBNORMAL_SUPPORT != 0 ? "gradual underflow" : "DAZ/FTZ");
+        $display("Rounding  : %0d", rm_arg);
+        $display("Batch     : %0d vectors per DPI call", BATCH);
+        $display("---------------------------------------------------------------------------------------------------------------------");
+
+        if (fails != 0) $fatal(1, "fmul_tb: %0d failures", fails);
+        $finish;
+    end
+
+endmodule
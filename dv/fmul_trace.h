@@ -0,0 +1,84 @@
+// fmul_trace.h
+//
+// Waveform tracing of the Verilator testbenches, chosen at build time
+// (run_verilator.sh passes the matching Verilator option):
+//  - FMUL_TRACE=0   compiled out: no trace object and no dump call on the
+//                   eval path, for throughput runs
+//  - FMUL_TRACE=1   VCD, verilator --trace (default for a plain build)
+//  - FMUL_TRACE=2   FST, verilator --trace-fst, compressed
+// TraceFile is the trace class of the build, TRACE_EXT its file extension.
+//
+//  - TraceWindow    the last K vectors driven by a random stream, kept in
+//                   memory for --trace-window. On a mismatch the testbench
+//                   drives them again through a fresh traced model, so
+//                   only failures cost a waveform.
+
+#ifndef FMUL_TRACE_H
+#define FMUL_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef FMUL_TRACE
+#define FMUL_TRACE 1
+#endif
+
+#if FMUL_TRACE == 2
+#include "verilated_fst_c.h"
+typedef VerilatedFstC TraceFile;
+static const char* const TRACE_EXT = "fst";
+#elif FMUL_TRACE == 1
+#include "verilated_vcd_c.h"
+typedef VerilatedVcdC TraceFile;
+static const char* const TRACE_EXT = "vcd";
+#elif FMUL_TRACE != 0
+#error "FMUL_TRACE must be 0 (off), 1 (VCD) or 2 (FST)"
+#endif
+
+// Ring buffer of operand pairs, oldest overwritten first
+template <class W>
+class TraceWindow {
+ public:
+  explicit TraceWindow(size_t k) : a_(k ? k : 1), b_(k ? k : 1) {}
+
+  size_t capacity() const { return a_.size(); }
+  size_t size() const { return size_; }
+
+  void push(const W* a, const W* b, size_t n) {
+    const size_t k = capacity();
+    if (n > k) {
+      a += n - k;
+      b += n - k;
+      n = k;
+    }
+    for (size_t i = 0; i < n; i++) {
+      a_[head_] = a[i];
+      b_[head_] = b[i];
+      head_ = head_ + 1 == k ? 0 : head_ + 1;
+    }
+    size_ = size_ + n < k ? size_ + n : k;
+  }
+
+  // Contents oldest first
+  void copy_out(std::vector<W>& a, std::vector<W>& b) const {
+    const size_t k = capacity();
+    size_t i = (head_ + k - size_) % k;
+    a.resize(size_);
+    b.resize(size_);
+    for (size_t j = 0; j < size_; j++) {
+      a[j] = a_[i];
+      b[j] = b_[i];
+      i = i + 1 == k ? 0 : i + 1;
+    }
+  }
+
+  bool dumped = false;  // one waveform per stream, at its first mismatch
+
+ private:
+  std::vector<W> a_, b_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+#endif
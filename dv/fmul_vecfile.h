@@ -0,0 +1,270 @@
+// fmul_vecfile.h
+//
+// Binary vector files for fmul: golden sets from other tools, archived
+// failures, recorded random runs. Files are memory mapped, readers hand
+// pointers into the mapping straight to the batch driver and checker.
+//
+// Layout (little-endian):
+//   header   64 bytes, VecFileHeader
+//   blocks   ceil(count / block) blocks of `block` vectors, each stored
+//            column-wise so a block is directly a batch:
+//              a[block], b[block], y[block]   word_bytes each
+//              flags[block]                   one byte, FLAG_* bits
+//            The last block is padded to full size.
+//
+// y and flags are the expected results. flag_mask tells which FLAG_* bits
+// the producer actually computed, the others read as 0 and are not checked.
+// This testbench reads and writes words of its build format (fp_word,
+// fmul_ref.h): 2 bytes for fp16/bf16, 4 for fp32, 8 for fp64.
+
+#ifndef FMUL_VECFILE_H
+#define FMUL_VECFILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmul_ref.h"
+
+static const char VECFILE_MAGIC[8] = { 'F', 'M', 'U', 'L', 'V', 'E', 'C', '\0' };
+static const uint16_t VECFILE_VERSION = 1;
+static const uint32_t VECFILE_BLOCK = 4096;
+
+// Rounding mode of the expected results, same codes as RefRm / the DUT rm input
+enum : uint8_t {
+  VECFILE_RM_RNE = 0,
+  VECFILE_RM_RTZ = 1,
+  VECFILE_RM_RDN = 2,
+  VECFILE_RM_RUP = 3,
+  VECFILE_RM_RMM = 4,
+};
+
+// Subnormal handling of the expected results
+enum : uint8_t {
+  VECFILE_SUBNORMAL_FTZ     = 0,   // DAZ/FTZ
+  VECFILE_SUBNORMAL_GRADUAL = 1,   // SUBNORMAL_SUPPORT, gradual underflow
+};
+
+struct VecFileHeader {
+  char magic[8];
+  uint16_t version;
+  uint16_t header_bytes;
+  uint8_t exp;
+  uint8_t mant;
+  uint16_t bias;
+  uint8_t rounding;     // VECFILE_RM_*
+  uint8_t flag_mask;    // FLAG_* bits present in the records
+  uint8_t word_bytes;   // bytes per a/b/y value: 2, 4 or 8
+  uint8_t subnormal;    // VECFILE_SUBNORMAL_*
+  uint32_t block;       // vectors per block
+  uint64_t count;       // vectors in the file
+  uint8_t reserved[32];
+};
+static_assert(sizeof(VecFileHeader) == 64, "VecFileHeader must be 64 bytes");
+
+static inline uint64_t vecfile_block_bytes(const VecFileHeader& h) {
+  return (uint64_t)h.block * (3u * h.word_bytes + 1u);
+}
+
+static inline uint64_t vecfile_bytes(const VecFileHeader& h) {
+  const uint64_t blocks = (h.count + h.block - 1) / h.block;
+  return sizeof(VecFileHeader) + blocks * vecfile_block_bytes(h);
+}
+
+// One block of a mapped file, column pointers into the mapping
+struct VecBlock {
+  const fp_word* a;
+  const fp_word* b;
+  const fp_word* y;
+  const uint8_t* flags;
+  size_t n;
+};
+
+// -------------------------------------------------------------------
+// Read-only mapping of a vector file
+// -------------------------------------------------------------------
+class VecFileReader {
+public:
+  VecFileReader() = default;
+  VecFileReader(const VecFileReader&) = delete;
+  VecFileReader& operator=(const VecFileReader&) = delete;
+  ~VecFileReader() { close(); }
+
+  bool open(const std::string& path, std::string& err) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      err = "cannot open " + path;
+      return false;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (uint64_t)sb.st_size < sizeof(VecFileHeader)) {
+      ::close(fd);
+      err = path + " is too short for a vector file header";
+      return false;
+    }
+    void* p = mmap(nullptr, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      err = "cannot mmap " + path;
+      return false;
+    }
+    base_ = (uint8_t*)p;
+    size_ = (size_t)sb.st_size;
+    std::memcpy(&hdr_, base_, sizeof hdr_);
+
+    if (std::memcmp(hdr_.magic, VECFILE_MAGIC, sizeof VECFILE_MAGIC) != 0) {
+      err = path + " is not an fmul vector file";
+    } else if (hdr_.version != VECFILE_VERSION || hdr_.header_bytes != sizeof(VecFileHeader)) {
+      err = path + ": unsupported vector file version";
+    } else if (hdr_.word_bytes != sizeof(fp_word) || hdr_.block == 0) {
+      err = path + ": holds " + std::to_string(hdr_.word_bytes) + "-byte records, this testbench is built for " +
+            std::to_string(sizeof(fp_word)) + "-byte words";
+    } else if (vecfile_bytes(hdr_) > size_) {
+      err = path + " is truncated";
+    } else {
+      madvise(base_, size_, MADV_SEQUENTIAL);
+      return true;
+    }
+    close();
+    return false;
+  }
+
+  void close() {
+    if (base_) munmap(base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+  }
+
+  const VecFileHeader& header() const { return hdr_; }
+  uint64_t count() const { return hdr_.count; }
+  uint64_t blocks() const { return (hdr_.count + hdr_.block - 1) / hdr_.block; }
+
+  VecBlock block(uint64_t k) const {
+    const uint8_t* p = base_ + sizeof(VecFileHeader) + k * vecfile_block_bytes(hdr_);
+    VecBlock blk;
+    blk.a = (const fp_word*)p;
+    blk.b = blk.a + hdr_.block;
+    blk.y = blk.b + hdr_.block;
+    blk.flags = (const uint8_t*)(blk.y + hdr_.block);
+    blk.n = (size_t)std::min<uint64_t>(hdr_.block, hdr_.count - k * hdr_.block);
+    return blk;
+  }
+
+private:
+  uint8_t* base_ = nullptr;
+  size_t size_ = 0;
+  VecFileHeader hdr_{};
+};
+
+// -------------------------------------------------------------------
+// Writer: the file is sized for `capacity` vectors up front and mapped
+// shared, append() copies a batch into the mapping. finish() stores the
+// final count and trims the unused blocks. Small files of known size
+// can pass their count as `block` to skip the padding.
+// -------------------------------------------------------------------
+class VecFileWriter {
+public:
+  VecFileWriter() = default;
+  VecFileWriter(const VecFileWriter&) = delete;
+  VecFileWriter& operator=(const VecFileWriter&) = delete;
+  ~VecFileWriter() { finish(); }
+
+  bool open(const std::string& path, uint64_t capacity, int exp, int mant, int bias,
+            uint8_t rounding, uint8_t subnormal, uint8_t flag_mask, std::string& err,
+            uint32_t block = VECFILE_BLOCK) {
+    std::memset(&hdr_, 0, sizeof hdr_);
+    std::memcpy(hdr_.magic, VECFILE_MAGIC, sizeof VECFILE_MAGIC);
+    hdr_.version = VECFILE_VERSION;
+    hdr_.header_bytes = sizeof(VecFileHeader);
+    hdr_.exp = (uint8_t)exp;
+    hdr_.mant = (uint8_t)mant;
+    hdr_.bias = (uint16_t)bias;
+    hdr_.rounding = rounding;
+    hdr_.subnormal = subnormal;
+    hdr_.flag_mask = flag_mask;
+    hdr_.word_bytes = sizeof(fp_word);
+    hdr_.block = block ? block : 1;
+    hdr_.count = capacity;
+    size_ = (size_t)vecfile_bytes(hdr_);
+    hdr_.count = 0;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      err = "cannot create " + path;
+      return false;
+    }
+    if (ftruncate(fd_, (off_t)size_) != 0) {
+      err = "cannot size " + path;
+      finish();
+      return false;
+    }
+    void* p = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+      err = "cannot mmap " + path;
+      finish();
+      return false;
+    }
+    base_ = (uint8_t*)p;
+    std::memcpy(base_, &hdr_, sizeof hdr_);
+    capacity_ = capacity;
+    return true;
+  }
+
+  // Appends up to the capacity, returns the number of vectors stored
+  size_t append(const fp_word* a, const fp_word* b, const fp_word* y,
+                const uint8_t* flags, size_t n) {
+    size_t done = 0;
+    while (done < n && hdr_.count < capacity_) {
+      const uint64_t k = hdr_.count / hdr_.block;
+      const size_t off = (size_t)(hdr_.count % hdr_.block);
+      const size_t m = (size_t)std::min<uint64_t>(
+          std::min<uint64_t>(n - done, hdr_.block - off), capacity_ - hdr_.count);
+      uint8_t* p = base_ + sizeof(VecFileHeader) + k * vecfile_block_bytes(hdr_);
+      fp_word* fa = (fp_word*)p;
+      fp_word* fb = fa + hdr_.block;
+      fp_word* fy = fb + hdr_.block;
+      uint8_t* ff = (uint8_t*)(fy + hdr_.block);
+      std::memcpy(fa + off, a + done, m * sizeof(fp_word));
+      std::memcpy(fb + off, b + done, m * sizeof(fp_word));
+      std::memcpy(fy + off, y + done, m * sizeof(fp_word));
+      std::memcpy(ff + off, flags + done, m);
+      hdr_.count += m;
+      done += m;
+    }
+    return done;
+  }
+
+  uint64_t count() const { return hdr_.count; }
+
+  void finish() {
+    if (base_) {
+      std::memcpy(base_, &hdr_, sizeof hdr_);
+      munmap(base_, size_);
+      base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      if (ftruncate(fd_, (off_t)vecfile_bytes(hdr_)) != 0) {
+        // keeps the padded size, the header count is still right
+      }
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+private:
+  int fd_ = -1;
+  uint8_t* base_ = nullptr;
+  size_t size_ = 0;
+  uint64_t capacity_ = 0;
+  VecFileHeader hdr_{};
+};
+
+#endif // FMUL_VECFILE_H
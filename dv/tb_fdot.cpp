@@ -0,0 +1,577 @@
+// tb_fdot.cpp
+//
+// Verilator C++ testbench for fdot (y = sum of a[k]*b[k] over a stream of
+// beats, one rounding). Same conventions as fmul: only qNaN, denormals are
+// zero, results are flushed to zero. The lane count is fixed at build time
+// (-DFDOT_LANES=<LANES>, the same value as -GLANES); the operand format
+// follows the build format (RefFmt in fmul_ref.h).
+// Features:
+//  - Exact reference RefDot from fmul_ref.h: every product added without
+//    rounding, the sum rounded once, so the expected result is the same for
+//    any order of the products
+//  - Optional tracing:            --trace   (writes wave.vcd, or wave.fst for an
+//                                 FST build; FMUL_TRACE=0 compiles it out, fmul_trace.h)
+//  - Optional print on PASS too:  --print-ok
+//  - Optional check of status flags (invalid/overflow/underflow/inexact):
+//                                 --check-flags     (enable checking; default is OFF)
+//  - Rounding mode, driven on rm: --rm <rne|rtz|rdn|rup|rmm>   (default rne)
+//  - Random test count, in streams: --n <N>
+//  - Counter-based stimulus (fmul_stim.h): the operand pairs of stream j are
+//    fmul stream vectors from index j * max_beats * LANES on, the stream
+//    length and shape come from its addend draw; stream j depends only on
+//    --seed, --max-beats and j:
+//                                 --start <J>  --stim-weights <W0,...,W8>
+//                                 --max-beats <K>   (1..K beats, default 16)
+//    A quarter of the streams repeat their first half negated in reverse
+//    order (exact or near-exact cancellation), another quarter keep every
+//    operand within a few binades of 1 so the products overlap.
+//  - Streams are generated, driven and checked in batches:
+//                                 --batch <B>       (streams, default 256)
+//  - Random input bubbles and out_ready stalls: --backpressure
+//
+// Example runs:
+//  1) Quiet, check flags:
+//        ./obj_dir/Vfdot --n 100000 --check-flags
+//  2) Replay one reported stream verbosely:
+//        ./obj_dir/Vfdot --check-flags --seed 12345 --start 4711 --n 1 --print-ok
+//  3) Long streams, stalls on both sides, round toward -Inf:
+//        ./obj_dir/Vfdot --n 20000 --check-flags --max-beats 256 --backpressure --rm rdn
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Vfdot.h"
+#include "verilated.h"
+
+#include "fmul_ref.h"
+#include "fmul_stim.h"
+#include "fmul_trace.h"
+
+#ifndef FDOT_LANES
+#define FDOT_LANES 4
+#endif
+static const size_t LANES = FDOT_LANES;
+static_assert(LANES >= 1 && LANES <= 32, "FDOT_LANES lane count must be in 1..32");
+
+// Products per stream the DUT accumulator holds, 2^CARRY_W (fdot default)
+static const uint64_t MAX_PRODUCTS = 1ull << 16;
+
+// Global flags
+static bool PRINT_OK = false;
+static bool CHECK_FLAGS = false;
+static int ROUND_MODE = RM_RNE;
+
+// Hex digits of a value
+static const int HEX_W = (RefFmt::WIDTH + 3) / 4;
+
+// -----------------------------------------------------------------
+// Pretty printing
+// -----------------------------------------------------------------
+static void print_fp(const char* label, fp_word bits) {
+  const unsigned long long v = bits;
+  const int exp = (int)exp_field(bits);
+  const unsigned long long man = frac_field(bits);
+
+  if (is_nan_bits(bits)) {
+    std::printf("  %-8s : 0x%0*llx  NaN\n", label, HEX_W, v);
+  } else if (is_inf_bits(bits)) {
+    std::printf("  %-8s : 0x%0*llx  %sInf\n", label, HEX_W, v, sign_bit(bits) ? "-" : "+");
+  } else {
+    // Exact in a double for every format up to binary64
+    const unsigned long long sig = exp ? (1ull << REF_MANT) | man : man;
+    const double mag = std::ldexp((double)sig, (exp ? exp : 1) - REF_BIAS - REF_MANT);
+    std::printf("  %-8s : 0x%0*llx  %+.20e\n", label, HEX_W, v, sign_bit(bits) ? -mag : mag);
+  }
+}
+
+static void print_case(const char* status, const char* tag,
+                       const fp_word* a, const fp_word* b, size_t npairs,
+                       const RefOut& dut, const RefOut& ref) {
+  std::printf("\n==================================================== %s [%s] ====================================================\n", status, tag);
+
+  std::printf("  %zu products in %zu beats of %zu lanes, rm=%s\n",
+              npairs, npairs / LANES, LANES, ref_rm_name(ROUND_MODE));
+  for (size_t k = 0; k < npairs; k++) {
+    std::printf("  [%3zu.%-2zu] a=0x%0*llx b=0x%0*llx\n", k / LANES, k % LANES,
+                HEX_W, (unsigned long long)a[k], HEX_W, (unsigned long long)b[k]);
+  }
+
+  std::printf("\n ------------------------------------------------------- DUT ------------------------------------------------------- \n");
+  print_fp("y", dut.y);
+  std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
+              (int)dut.invalid, (int)dut.overflow, (int)dut.underflow, (int)dut.inexact);
+
+  std::printf("\n ------------------------------------------------------- REF ------------------------------------------------------- \n\n");
+  print_fp("y", ref.y);
+  std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
+              (int)ref.invalid, (int)ref.overflow, (int)ref.underflow, (int)ref.inexact);
+
+  std::printf("=====================================================================================================================\n");
+}
+
+// -----------------------------------------------------------------
+// Lane access to the packed operand ports: lane l is bits [W*l +: W],
+// W = RefFmt::WIDTH, of a CData/SData/IData/QData port (up to 64 bits)
+// or of a VlWide port of 32-bit words, where a lane may straddle words.
+// -----------------------------------------------------------------
+static const int LANE_BITS = RefFmt::WIDTH;
+
+template <typename P>
+static inline typename std::enable_if<std::is_integral<P>::value>::type
+set_lane(P& p, size_t l, fp_word v) {
+  const int sh = (int)(LANE_BITS * l);
+  p = (P)(((uint64_t)p & ~((uint64_t)RefFmt::MASK << sh)) | ((uint64_t)v << sh));
+}
+template <std::size_t N>
+static inline void set_lane(VlWide<N>& p, size_t l, fp_word v) {
+  for (int k = 0; k < LANE_BITS; ) {
+    const size_t bit = LANE_BITS * l + k;
+    const int off = (int)(bit % 32);
+    const int n = std::min(32 - off, LANE_BITS - k);
+    const uint32_t m = (uint32_t)(((1ull << n) - 1) << off);
+    p[bit / 32] = (p[bit / 32] & ~m) | ((uint32_t)((uint64_t)v >> k << off) & m);
+    k += n;
+  }
+}
+
+// -----------------------------------------------------------------
+// Streams of a batch: beat k, lane l at a/b[k*LANES + l], stream j is
+// beats [first[j], first[j+1])
+// -----------------------------------------------------------------
+struct StreamBatch {
+  std::vector<fp_word> a, b;
+  std::vector<uint8_t> last;
+  std::vector<size_t> first{0};
+
+  size_t streams() const { return first.size() - 1; }
+  size_t beats() const { return last.size(); }
+
+  void clear() {
+    a.clear();
+    b.clear();
+    last.clear();
+    first.assign(1, 0);
+  }
+
+  // npairs products, the last beat filled up with pad_a * pad_b
+  void push(const fp_word* pa, const fp_word* pb, size_t npairs,
+            fp_word pad_a = 0, fp_word pad_b = 0) {
+    const size_t nb = npairs ? (npairs + LANES - 1) / LANES : 1;
+    for (size_t k = 0; k < nb * LANES; k++) {
+      a.push_back(k < npairs ? pa[k] : pad_a);
+      b.push_back(k < npairs ? pb[k] : pad_b);
+    }
+    for (size_t k = 0; k < nb; k++) last.push_back(k + 1 == nb);
+    first.push_back(beats());
+  }
+};
+
+// -----------------------------------------------------------------
+// Driver state: one model plus its trace and time
+// -----------------------------------------------------------------
+struct Driver {
+  Vfdot* dut = nullptr;
+#if FMUL_TRACE
+  TraceFile* tfp = nullptr;
+#endif
+  vluint64_t t = 0;
+  // Random bubbles / out_ready stalls, separate from the operand stream
+  bool backpressure = false;
+  std::mt19937_64 stall_rng;
+  uint64_t cycles = 0;
+};
+
+static inline void tick_eval(Driver& d) {
+  d.dut->eval();
+#if FMUL_TRACE
+  if (d.tfp) d.tfp->dump(d.t);
+#endif
+  d.t++;
+}
+
+static inline void tick_clk(Driver& d) {
+  d.dut->clk = 0;
+  tick_eval(d);
+  d.dut->clk = 1;
+  tick_eval(d);
+}
+
+static void reset_pipe(Driver& d) {
+  d.dut->in_valid  = 0;
+  d.dut->in_last   = 0;
+  d.dut->out_ready = 0;
+  d.dut->rst_n     = 0;
+  for (int i = 0; i < 4; i++) tick_clk(d);
+  d.dut->rst_n = 1;
+  tick_clk(d);
+}
+
+// DUT flag ports packed like the reference flags (FLAG_* in fmul_ref.h)
+static inline uint8_t sample_flags(const Vfdot* dut) {
+  return (uint8_t)((dut->invalid << 3) | (dut->overflow << 2) |
+                   (dut->underflow << 1) | dut->inexact);
+}
+
+// Longest legal wait for a handshake before the DUT counts as hung
+static const int PIPE_TIMEOUT = 64;
+
+// Stream the beats of s through the DUT and collect one result per stream
+// in issue order. Returns false if the DUT hangs.
+static bool run_batch(Driver& d, const StreamBatch& s, fp_word* y, uint8_t* flags) {
+  Vfdot* dut = d.dut;
+  const size_t nb = s.beats(), n = s.streams();
+  size_t sent = 0, done = 0, ended = 0;
+  int idle = 0;
+
+  while (done < n) {
+    const size_t k = std::min(sent, nb - 1);
+    for (size_t l = 0; l < LANES; l++) {
+      set_lane(dut->a, l, s.a[k * LANES + l]);
+      set_lane(dut->b, l, s.b[k * LANES + l]);
+    }
+    dut->in_last   = s.last[k];
+    dut->rm        = (uint8_t)ROUND_MODE;
+    dut->in_valid  = sent < nb && (!d.backpressure || (d.stall_rng() & 3u) != 0);
+    dut->out_ready = !d.backpressure || (d.stall_rng() & 3u) != 0;
+
+    dut->clk = 0;
+    tick_eval(d);
+
+    // Sample both handshakes before the rising edge
+    const bool fire_in  = dut->in_valid && dut->in_ready;
+    const bool fire_out = dut->out_valid && dut->out_ready;
+
+    if (fire_out) {
+      if (done == ended) {
+        std::printf("ERROR: out_valid with no complete stream in flight\n");
+        return false;
+      }
+      y[done] = (fp_word)dut->y;
+      flags[done] = sample_flags(dut);
+      done++;
+    }
+    if (fire_in) {
+      ended += s.last[k];
+      sent++;
+    }
+    if (fire_in || fire_out) {
+      idle = 0;
+    } else if (++idle == PIPE_TIMEOUT) {
+      std::printf("ERROR: no handshake for %d cycles (%zu beats sent, %zu of %zu results)\n",
+                  PIPE_TIMEOUT, sent, done, n);
+      return false;
+    }
+
+    dut->clk = 1;
+    tick_eval(d);
+    d.cycles++;
+  }
+
+  dut->in_valid  = 0;
+  dut->out_ready = 1;
+  return true;
+}
+
+// -----------------------------------------------------------------
+// Stimulus: stream j, 1..max_beats beats. The spare bits of its addend
+// draw pick the length and the shape.
+// -----------------------------------------------------------------
+static size_t stim_stream(const StimGen& gen, uint64_t j, size_t max_beats,
+                          std::vector<fp_word>& a, std::vector<fp_word>& b) {
+  uint32_t spare;
+  gen.addend(j, spare);
+  const size_t npairs = (1 + (spare >> 2) % max_beats) * LANES;
+
+  a.resize(npairs);
+  b.resize(npairs);
+  gen.fill(j * max_beats * LANES, a.data(), b.data(), npairs);
+
+  switch (spare & 3u) {
+    case 1: {
+      // Second half: the first half negated, in reverse order, one
+      // fraction bit changed on request
+      const size_t half = npairs / 2;
+      for (size_t k = 0; k < half; k++) {
+        a[npairs - 1 - k] = a[k] ^ RefFmt::SIGN;
+        b[npairs - 1 - k] = b[k];
+      }
+      if (half && ((spare >> 16) & 1u)) a[npairs - 1] ^= 1u;
+      break;
+    }
+    case 2: {
+      // Exponents within +-4 binades of 1, so the products overlap and
+      // carries run through the accumulator
+      for (size_t k = 0; k < npairs; k++) {
+        const fp_word ea = (fp_word)(REF_BIAS - 4 + (int)(frac_field(a[k]) % 9));
+        const fp_word eb = (fp_word)(REF_BIAS - 4 + (int)(frac_field(b[k]) % 9));
+        a[k] = (fp_word)((a[k] & STIM_SIGN_FRAC) | ((uint64_t)ea << REF_MANT));
+        b[k] = (fp_word)((b[k] & STIM_SIGN_FRAC) | ((uint64_t)eb << REF_MANT));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return npairs;
+}
+
+// -----------------------------------------------------------------
+// Checks
+// -----------------------------------------------------------------
+static inline uint8_t check_mask() { return CHECK_FLAGS ? FLAG_ALL : 0; }
+
+static RefOut ref_stream(const StreamBatch& s, size_t j) {
+  RefDot<> r;
+  for (size_t k = s.first[j] * LANES; k < s.first[j + 1] * LANES; k++) r.add(s.a[k], s.b[k]);
+  return r.result(ROUND_MODE);
+}
+
+static bool check_result(const StreamBatch& s, size_t j, fp_word y, uint8_t flags,
+                         const char* tag, bool verbose_on_fail) {
+  const RefOut r = ref_stream(s, j);
+  const bool ok_y = y == r.y;
+  const bool ok = ok_y && ((flags ^ pack_ref_flags(r)) & check_mask()) == 0;
+
+  if ((!ok && verbose_on_fail) || (ok && PRINT_OK)) {
+    const size_t k = s.first[j] * LANES;
+    print_case(ok ? "PASS" : "FAIL", tag, &s.a[k], &s.b[k], (s.first[j + 1] - s.first[j]) * LANES,
+               unpack_ref_flags(y, flags), r);
+    if (!ok && !CHECK_FLAGS && !ok_y) {
+      std::printf("NOTE: Flag checking is disabled (--check-flags not set). "
+                  "Failure is due to output y mismatch.\n");
+    }
+  }
+  return ok;
+}
+
+// One directed stream
+static bool run_one(Driver& d, const std::vector<fp_word>& a, const std::vector<fp_word>& b,
+                    fp_word pad_a, fp_word pad_b, const char* tag, bool verbose_on_fail) {
+  StreamBatch s;
+  s.push(a.data(), b.data(), a.size(), pad_a, pad_b);
+  fp_word y;
+  uint8_t flags;
+  if (!run_batch(d, s, &y, &flags)) return false;
+  return check_result(s, 0, y, flags, tag, verbose_on_fail);
+}
+
+// Value (-1)^s * 1.frac * 2^e of the build format
+static inline fp_word fp_make(int s, int e, uint64_t frac = 0) {
+  return (fp_word)(RefFmt::zero((fp_word)s) | ((uint64_t)(e + REF_BIAS) << REF_MANT) |
+                   (frac & RefFmt::FRAC_MASK));
+}
+
+int main(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+
+  bool do_trace = false;
+  uint64_t nrand = 20000;
+  uint64_t seed  = 0xC001D00Du;
+  size_t batch   = 256;
+  uint64_t start = 0;
+  size_t max_beats = 16;
+  bool backpressure = false;
+  StimWeights weights;
+
+  // Args:
+  //  --n <N>           random streams
+  //  --trace           enable wave.vcd (wave.fst in an FST build)
+  //  --print-ok        print PASS cases too
+  //  --check-flags     check invalid/overflow/underflow/inexact
+  //  --rm <M>          rounding mode: rne (default), rtz, rdn, rup, rmm
+  //  --seed <S>        stimulus stream seed
+  //  --start <J>       first stream index (replays from stream J)
+  //  --stim-weights <W0,...,W8>
+  //                    class weights: +0,-0,+inf,-inf,nan,exp0,exp1,exp254,uniform
+  //  --max-beats <K>   longest random stream, in beats
+  //  --batch <B>       streams per driver/check batch
+  //  --backpressure    random input bubbles and out_ready stalls
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trace") do_trace = true;
+    else if (arg == "--print-ok") PRINT_OK = true;
+    else if (arg == "--check-flags") CHECK_FLAGS = true;
+    else if (arg == "--backpressure") backpressure = true;
+    else if (arg == "--n" && i + 1 < argc) nrand = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--start" && i + 1 < argc) start = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--batch" && i + 1 < argc) batch = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--max-beats" && i + 1 < argc) max_beats = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--rm" && i + 1 < argc) {
+      std::string rm = argv[++i];
+      ROUND_MODE = -1;
+      for (int m = RM_RNE; m <= RM_RMM; m++) {
+        if (rm == ref_rm_name(m)) ROUND_MODE = m;
+      }
+      if (ROUND_MODE < 0) {
+        std::printf("ERROR: bad --rm '%s', expected rne, rtz, rdn, rup or rmm\n", rm.c_str());
+        return 2;
+      }
+    }
+    else if (arg == "--stim-weights" && i + 1 < argc) {
+      if (!weights.parse(argv[++i])) {
+        std::printf("ERROR: bad --stim-weights '%s', expected %d comma-separated weights\n",
+                    argv[i], (int)STIM_NCLASS);
+        return 2;
+      }
+    }
+  }
+  if (batch == 0) batch = 1;
+  if (max_beats == 0 || max_beats * LANES > MAX_PRODUCTS) {
+    std::printf("ERROR: --max-beats must be in 1..%llu (2^CARRY_W products per stream)\n",
+                (unsigned long long)(MAX_PRODUCTS / LANES));
+    return 2;
+  }
+
+  Driver d;
+  d.dut = new Vfdot;
+
+#if FMUL_TRACE
+  if (do_trace) {
+    char path[32];
+    std::snprintf(path, sizeof path, "wave.%s", TRACE_EXT);
+    Verilated::traceEverOn(true);
+    d.tfp = new TraceFile;
+    d.dut->trace(d.tfp, 99);
+    d.tfp->open(path);
+  }
+#else
+  if (do_trace) std::printf("NOTE: built without tracing (FMUL_TRACE=0), --trace ignored.\n");
+#endif
+
+  d.backpressure = backpressure;
+  d.stall_rng.seed(seed ^ 0x5DEECE66Dull);
+  reset_pipe(d);
+
+  uint64_t tests = 0, fails = 0;
+  uint64_t stream_beats = 0, stream_cycles = 0;
+
+  auto check = [&](const std::vector<fp_word>& a, const std::vector<fp_word>& b,
+                   const char* tag, fp_word pad_a = 0, fp_word pad_b = 0) {
+    tests++;
+    if (!run_one(d, a, b, pad_a, pad_b, tag, /*verbose_on_fail=*/true)) fails++;
+  };
+
+  // Directed tests, in the build format
+  const int EMAX = (int)RefFmt::EXP_ONES - 1 - REF_BIAS;
+  const int EMIN = 1 - REF_BIAS;
+  const fp_word ONE = fp_make(0, 0), HALF = fp_make(0, -1), TWO = fp_make(0, 1);
+  const fp_word BIG = fp_make(0, EMAX), MAXF = RefFmt::max_finite(0);
+  const fp_word NZERO = RefFmt::zero(1), PINF = RefFmt::INF, NINF = RefFmt::inf(1);
+
+  check({BIG, ONE, BIG ^ RefFmt::SIGN}, {BIG, ONE, BIG}, "big*big + 1 - big*big => 1, exact");
+  check({ONE, BIG, BIG ^ RefFmt::SIGN}, {ONE, BIG, BIG}, "same products in another order");
+  check({MAXF, MAXF ^ RefFmt::SIGN}, {TWO, ONE}, "max*2 - max => max, no intermediate overflow");
+  check({MAXF, MAXF}, {ONE, ONE}, "max + max => overflow");
+  check({ONE, fp_make(0, -REF_MANT - 1)}, {ONE, ONE}, "1 + half ulp: tie, even => 1");
+  check({fp_make(0, 0, 1), fp_make(0, -REF_MANT - 1)}, {ONE, ONE}, "1+ulp + half ulp: tie, odd => up");
+  check({ONE, fp_make(0, -REF_MANT - 1), fp_make(0, EMIN)}, {ONE, ONE, fp_make(0, EMIN)},
+        "tie broken by a product far below the window");
+  check({ONE, ONE ^ RefFmt::SIGN}, {fp_make(0, 0, 3), fp_make(0, 0, 3)}, "x - x => +0 (-0 in rdn)");
+  check({NZERO}, {ONE}, "all products -0 => -0", NZERO, ONE);
+  check({NZERO, 0}, {ONE, ONE}, "-0 + +0 => +0 (-0 in rdn)");
+  check({fp_make(0, EMIN)}, {HALF}, "sum below min_norm => FTZ");
+  check({fp_make(0, EMIN), fp_make(0, EMIN)}, {HALF, TWO}, "half min_norm + 2 min_norm, normal");
+  check({(fp_word)1u, ONE}, {ONE, ONE}, "sub*1 + 1 => 1 (DAZ)");
+  check({PINF, ONE}, {ONE, ONE}, "Inf + 1 => Inf");
+  check({PINF, NINF}, {ONE, ONE}, "Inf - Inf => invalid");
+  check({PINF, ONE}, {0, ONE}, "Inf*0 + 1 => invalid");
+  check({qnan_const(), PINF, NINF}, {ONE, ONE, ONE}, "NaN + Inf - Inf => invalid");
+  {
+    // A long stream of alternating +-1 and one +-big pair that cancel,
+    // with one tiny term: any rounding of a partial sum would lose it
+    const size_t nb = std::min<size_t>(64, MAX_PRODUCTS / LANES) * LANES * 2;
+    std::vector<fp_word> a(nb), b(nb, ONE);
+    for (size_t k = 0; k < nb; k++) a[k] = k & 1u ? ONE ^ RefFmt::SIGN : ONE;
+    a[0] = BIG;
+    a[1] = BIG ^ RefFmt::SIGN;
+    a[nb / 2] = fp_make(0, EMIN + 1);
+    a[nb / 2 + 1] = 0;
+    check(a, b, "long stream, +-1 and +-big cancel, tiny term kept");
+  }
+
+  // Random tests
+  StimGen gen(seed, weights);
+  StreamBatch sb;
+  std::vector<fp_word> a, b, y(batch);
+  std::vector<uint8_t> flags(batch);
+  bool failed = false;
+  bool hung = false;
+  uint64_t fail_index = 0;
+
+  for (uint64_t done = 0; done < nrand && !failed; ) {
+    const size_t n = (size_t)std::min<uint64_t>(batch, nrand - done);
+    sb.clear();
+    for (size_t j = 0; j < n; j++) {
+      const size_t np = stim_stream(gen, start + done + j, max_beats, a, b);
+      sb.push(a.data(), b.data(), np);
+    }
+
+    const uint64_t cycles0 = d.cycles;
+    if (!run_batch(d, sb, y.data(), flags.data())) {
+      failed = hung = true;
+      fail_index = start + done;
+      fails++;
+      break;
+    }
+    stream_beats += sb.beats();
+    stream_cycles += d.cycles - cycles0;
+
+    size_t bad = n;
+    for (size_t j = 0; j < n && bad == n; j++) {
+      const RefOut r = ref_stream(sb, j);
+      if (((y[j] ^ r.y) & RefFmt::MASK) != 0 || ((flags[j] ^ pack_ref_flags(r)) & check_mask()) != 0) {
+        bad = j;
+      } else if (PRINT_OK) {
+        check_result(sb, j, y[j], flags[j], "rand", false);
+      }
+    }
+
+    tests += (bad < n) ? bad + 1 : n;
+    if (bad < n) {
+      failed = true;
+      fail_index = start + done + bad;
+      fails++;
+    }
+    done += n;
+  }
+
+  if (failed && !hung) {
+    std::printf("First failing stream: index %llu (replay with --seed %llu --start %llu --n 1"
+                " --max-beats %zu)\n",
+                (unsigned long long)fail_index, (unsigned long long)seed,
+                (unsigned long long)fail_index, max_beats);
+    stim_stream(gen, fail_index, max_beats, a, b);
+    run_one(d, a, b, 0, 0, "rand (verbose)", /*verbose_on_fail=*/true);
+  }
+
+#if FMUL_TRACE
+  if (d.tfp) {
+    d.tfp->close();
+    delete d.tfp;
+  }
+#endif
+
+  std::printf("\n---------------------------------------------------------------------------------------------------------------------\n");
+  std::printf("Tests run : %llu streams\n", (unsigned long long)tests);
+  std::printf("Failures  : %llu\n", (unsigned long long)fails);
+  std::printf("Flag check: %s\n", CHECK_FLAGS ? "ENABLED (--check-flags)" : "DISABLED");
+  std::printf("Rounding  : %s\n", ref_rm_name(ROUND_MODE));
+  std::printf("Stream    : %llu beats of %zu lanes in %llu cycles (%.3f beats/cycle)%s\n",
+              (unsigned long long)stream_beats, LANES, (unsigned long long)stream_cycles,
+              stream_cycles ? (double)stream_beats / (double)stream_cycles : 0.0,
+              backpressure ? ", with back-pressure" : "");
+  std::printf("---------------------------------------------------------------------------------------------------------------------\n");
+
+  d.dut->final();
+  delete d.dut;
+  return fails ? 1 : 0;
+}
@@ -0,0 +1,479 @@
+// tb_ffma.cpp
+//
+// Verilator C++ testbench for ffma (y = a*b + c, one rounding). Same conventions
+// as fmul: only qNaN, denormals are zero, results are flushed to zero.
+// Features:
+//  - Single-rounding reference ref_fma() from fmul_ref.h
+//  - Optional tracing:            --trace   (writes wave.vcd, or wave.fst for an
+//                                 FST build; FMUL_TRACE=0 compiles it out, fmul_trace.h)
+//  - Optional print on PASS too:  --print-ok
+//  - Optional check of status flags (invalid/overflow/underflow/inexact):
+//                                 --check-flags     (enable checking; default is OFF)
+//  - Random test count:           --n <N>
+//  - Counter-based stimulus (fmul_stim.h): a and b are the fmul stream, c comes
+//    from its addend stream; vector i depends only on --seed and i:
+//                                 --start <I>  --stim-weights <W0,...,W8>
+//    A quarter of the vectors put c next to -(a*b) for cancellation, another
+//    quarter move c into the exponent range of the product.
+//  - Random vectors are generated, driven and checked in batches:
+//                                 --batch <B>       (default 4096)
+//  - Pipelined DUT (ffma_pipe, built with -DFFMA_PIPE): random vectors are
+//    streamed at one per cycle and checked in order; --backpressure adds
+//    random input bubbles and out_ready stalls
+//
+// Example runs:
+//  1) Quiet, check flags:
+//        ./obj_dir/Vffma --n 1000000 --check-flags
+//  2) Replay one reported vector verbosely:
+//        ./obj_dir/Vffma --check-flags --seed 12345 --start 4711 --n 1 --print-ok
+//  3) ffma_pipe build, stalls on both sides:
+//        ./obj_dir/Vffma --n 200000 --check-flags --backpressure
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Vffma.h"
+#include "verilated.h"
+
+#include "fmul_ref.h"
+#include "fmul_stim.h"
+#include "fmul_trace.h"
+
+// The ffma testbench and its stimulus shaping are written for binary32 only
+static_assert(REF_EXP == 8 && REF_MANT == 23 && REF_BIAS == 127,
+              "tb_ffma supports the binary32 format only");
+
+// Global flags
+static bool PRINT_OK = false;
+static bool CHECK_FLAGS = false;
+
+static inline float bits_to_f32(uint32_t u) {
+  float f;
+  static_assert(sizeof(f) == sizeof(u), "float must be 32-bit");
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// -----------------------------------------------------------------
+// Pretty printing
+// -----------------------------------------------------------------
+static void print_fp(const char* label, uint32_t bits) {
+  const uint32_t exp = exp_field(bits);
+  const uint32_t man = frac_field(bits);
+
+  if (is_nan_bits(bits)) {
+    std::printf("  %-8s : 0x%08x  NaN  | s=0x%x e=0x%02x m=0x%06x\n",
+                label, bits, sign_bit(bits), exp, man);
+  } else if (is_inf_bits(bits)) {
+    std::printf("  %-8s : 0x%08x  %sInf  | s=0x%x e=0x%02x m=0x%06x\n",
+                label, bits, sign_bit(bits) ? "-" : "+", sign_bit(bits), exp, man);
+  } else {
+    std::printf("  %-8s : 0x%08x  %+.20e  | s=0x%x e=0x%02x m=0x%06x\n",
+                label, bits, bits_to_f32(bits), sign_bit(bits), exp, man);
+  }
+}
+
+static void print_case(const char* status, const char* tag,
+                       uint32_t a, uint32_t b, uint32_t c,
+                       const RefOut& dut, const RefOut& ref) {
+  std::printf("\n==================================================== %s [%s] ====================================================\n", status, tag);
+
+  print_fp("a", a);
+  print_fp("b", b);
+  print_fp("c", c);
+
+  std::printf("\n ------------------------------------------------------- DUT ------------------------------------------------------- \n");
+  print_fp("y", dut.y);
+  std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
+              (int)dut.invalid, (int)dut.overflow, (int)dut.underflow, (int)dut.inexact);
+
+  std::printf("\n ------------------------------------------------------- REF ------------------------------------------------------- \n\n");
+  print_fp("y", ref.y);
+  std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
+              (int)ref.invalid, (int)ref.overflow, (int)ref.underflow, (int)ref.inexact);
+
+  std::printf("=====================================================================================================================\n");
+}
+
+// -----------------------------------------------------------------
+// Driver state: one model plus its trace and time
+// -----------------------------------------------------------------
+struct Driver {
+  Vffma* dut = nullptr;
+#if FMUL_TRACE
+  TraceFile* tfp = nullptr;
+#endif
+  vluint64_t t = 0;
+#ifdef FFMA_PIPE
+  // Random bubbles / out_ready stalls, separate from the operand stream
+  bool backpressure = false;
+  std::mt19937_64 stall_rng;
+  uint64_t cycles = 0;
+#endif
+};
+
+static inline bool tracing(const Driver& d) {
+#if FMUL_TRACE
+  return d.tfp != nullptr;
+#else
+  (void)d;
+  return false;
+#endif
+}
+
+static inline void tick_eval(Driver& d) {
+  d.dut->eval();
+#if FMUL_TRACE
+  if (d.tfp) d.tfp->dump(d.t);
+#endif
+  d.t++;
+}
+
+// DUT flag ports packed like the reference flags (FLAG_* in fmul_ref.h)
+static inline uint8_t sample_flags(const Vffma* dut) {
+  return (uint8_t)((dut->invalid << 3) | (dut->overflow << 2) |
+                   (dut->underflow << 1) | dut->inexact);
+}
+
+#ifndef FFMA_PIPE
+// -----------------------------------------------------------------
+// Batched driver, combinational DUT: one eval per vector, or the
+// settle/hold evals when tracing
+// -----------------------------------------------------------------
+static bool run_batch(Driver& d, const uint32_t* a, const uint32_t* b, const uint32_t* c,
+                      uint32_t* y, uint8_t* flags, size_t n) {
+  Vffma* dut = d.dut;
+
+  for (size_t i = 0; i < n; i++) {
+    dut->a = a[i];
+    dut->b = b[i];
+    dut->c = c[i];
+    if (!tracing(d)) {
+      dut->eval();
+      d.t++;
+    } else {
+      tick_eval(d);
+      tick_eval(d);
+    }
+    y[i] = dut->y;
+    flags[i] = sample_flags(dut);
+    if (tracing(d)) {
+      tick_eval(d);
+      tick_eval(d);
+    }
+  }
+  return true;
+}
+#else
+// -----------------------------------------------------------------
+// ffma_pipe: clocking and handshake
+// -----------------------------------------------------------------
+static inline void tick_clk(Driver& d) {
+  d.dut->clk = 0;
+  tick_eval(d);
+  d.dut->clk = 1;
+  tick_eval(d);
+}
+
+static void reset_pipe(Driver& d) {
+  d.dut->in_valid  = 0;
+  d.dut->out_ready = 0;
+  d.dut->rst_n     = 0;
+  for (int i = 0; i < 4; i++) tick_clk(d);
+  d.dut->rst_n = 1;
+  tick_clk(d);
+}
+
+// Longest legal wait for a handshake before the pipe counts as hung
+static const int PIPE_TIMEOUT = 64;
+
+// Stream n vectors through the pipe and collect the results in issue
+// order. Returns false if the pipe hangs.
+static bool run_batch(Driver& d, const uint32_t* a, const uint32_t* b, const uint32_t* c,
+                      uint32_t* y, uint8_t* flags, size_t n) {
+  Vffma* dut = d.dut;
+  size_t sent = 0, done = 0;
+  int idle = 0;
+
+  while (done < n) {
+    const size_t i = std::min(sent, n - 1);
+    dut->a = a[i];
+    dut->b = b[i];
+    dut->c = c[i];
+    dut->in_valid  = sent < n && (!d.backpressure || (d.stall_rng() & 3u) != 0);
+    dut->out_ready = !d.backpressure || (d.stall_rng() & 3u) != 0;
+
+    dut->clk = 0;
+    tick_eval(d);
+
+    // Sample both handshakes before the rising edge
+    const bool fire_in  = dut->in_valid && dut->in_ready;
+    const bool fire_out = dut->out_valid && dut->out_ready;
+
+    if (fire_out) {
+      if (done == sent) {
+        std::printf("ERROR: out_valid with no vector in flight\n");
+        return false;
+      }
+      y[done] = dut->y;
+      flags[done] = sample_flags(dut);
+      done++;
+      idle = 0;
+    } else if (++idle == PIPE_TIMEOUT) {
+      std::printf("ERROR: no result for %d cycles (%zu vectors in flight)\n",
+                  PIPE_TIMEOUT, sent - done);
+      return false;
+    }
+    if (fire_in) sent++;
+
+    dut->clk = 1;
+    tick_eval(d);
+    d.cycles++;
+  }
+
+  dut->in_valid  = 0;
+  dut->out_ready = 1;
+  return true;
+}
+#endif
+
+// -----------------------------------------------------------------
+// Stimulus: a, b of vector i from the fmul stream, c from the addend
+// stream. The spare bits of the addend draw steer c toward the
+// interesting alignments: next to -(a*b) (massive cancellation, exact
+// zero) or within +-30 binades of the product.
+// -----------------------------------------------------------------
+static void stim_vector(const StimGen& gen, uint64_t i, uint32_t& a, uint32_t& b, uint32_t& c) {
+  uint32_t spare;
+  gen.vector(i, a, b);
+  c = gen.addend(i, spare);
+
+  const RefOut p = ref_model(a, b);
+  const uint32_t ep = exp_field(p.y);
+  if (ep == 0 || ep == 0xFFu) return;
+
+  switch (spare & 7u) {
+    case 0:
+    case 1: {
+      // -round(a*b), a few ulps either way
+      const int32_t ulps = (int32_t)((spare >> 3) % 9) - 4;
+      const uint32_t m = (uint32_t)((int32_t)(p.y & 0x7FFFFFFFu) + ulps);
+      if (exp_field(m) != 0 && exp_field(m) != 0xFFu) c = (m | (p.y & 0x80000000u)) ^ 0x80000000u;
+      break;
+    }
+    case 2:
+    case 3: {
+      const int e = (int)ep + (int)((spare >> 3) % 61) - 30;
+      if (e >= 1 && e <= 254) c = (c & 0x807FFFFFu) | ((uint32_t)e << 23);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// -----------------------------------------------------------------
+// Checks
+// -----------------------------------------------------------------
+static inline uint8_t check_mask() { return CHECK_FLAGS ? FLAG_ALL : 0; }
+
+static bool check_result(uint32_t a, uint32_t b, uint32_t c, uint32_t y, uint8_t flags,
+                         const char* tag, bool verbose_on_fail) {
+  const RefOut r = ref_fma(a, b, c);
+  const bool ok_y = y == r.y;
+  const bool ok = ok_y && ((flags ^ pack_ref_flags(r)) & check_mask()) == 0;
+
+  if ((!ok && verbose_on_fail) || (ok && PRINT_OK)) {
+    print_case(ok ? "PASS" : "FAIL", tag, a, b, c, unpack_ref_flags(y, flags), r);
+    if (!ok && !CHECK_FLAGS && !ok_y) {
+      std::printf("NOTE: Flag checking is disabled (--check-flags not set). "
+                  "Failure is due to output y mismatch.\n");
+    }
+  }
+  return ok;
+}
+
+static bool run_one(Driver& d, uint32_t a, uint32_t b, uint32_t c,
+                    const char* tag, bool verbose_on_fail) {
+  uint32_t y;
+  uint8_t flags;
+  if (!run_batch(d, &a, &b, &c, &y, &flags, 1)) return false;
+  return check_result(a, b, c, y, flags, tag, verbose_on_fail);
+}
+
+int main(int argc, char** argv) {
+  Verilated::commandArgs(argc, argv);
+
+  bool do_trace = false;
+  uint64_t nrand = 200000;
+  uint64_t seed  = 0xC001D00Du;
+  size_t batch   = 4096;
+  uint64_t start = 0;
+  bool backpressure = false;
+  StimWeights weights;
+
+  // Args:
+  //  --n <N>           random tests
+  //  --trace           enable wave.vcd (wave.fst in an FST build)
+  //  --print-ok        print PASS cases too
+  //  --check-flags     check invalid/overflow/underflow/inexact
+  //  --seed <S>        stimulus stream seed
+  //  --start <I>       first stimulus stream index (replays from vector I)
+  //  --stim-weights <W0,...,W8>
+  //                    class weights: +0,-0,+inf,-inf,nan,exp0,exp1,exp254,uniform
+  //  --batch <B>       vectors per driver/check batch
+  //  --backpressure    ffma_pipe only: random input bubbles and out_ready stalls
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trace") do_trace = true;
+    else if (arg == "--print-ok") PRINT_OK = true;
+    else if (arg == "--check-flags") CHECK_FLAGS = true;
+    else if (arg == "--backpressure") backpressure = true;
+    else if (arg == "--n" && i + 1 < argc) nrand = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--start" && i + 1 < argc) start = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--batch" && i + 1 < argc) batch = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--stim-weights" && i + 1 < argc) {
+      if (!weights.parse(argv[++i])) {
+        std::printf("ERROR: bad --stim-weights '%s', expected %d comma-separated weights\n",
+                    argv[i], (int)STIM_NCLASS);
+        return 2;
+      }
+    }
+  }
+  if (batch == 0) batch = 1;
+
+  Driver d;
+  d.dut = new Vffma;
+
+#if FMUL_TRACE
+  if (do_trace) {
+    char path[32];
+    std::snprintf(path, sizeof path, "wave.%s", TRACE_EXT);
+    Verilated::traceEverOn(true);
+    d.tfp = new TraceFile;
+    d.dut->trace(d.tfp, 99);
+    d.tfp->open(path);
+  }
+#else
+  if (do_trace) std::printf("NOTE: built without tracing (FMUL_TRACE=0), --trace ignored.\n");
+#endif
+
+#ifdef FFMA_PIPE
+  d.backpressure = backpressure;
+  d.stall_rng.seed(seed ^ 0x5DEECE66Dull);
+  reset_pipe(d);
+#else
+  (void)backpressure;
+#endif
+
+  uint64_t tests = 0, fails = 0;
+#ifdef FFMA_PIPE
+  uint64_t stream_tests = 0, stream_cycles = 0;
+#endif
+
+  auto check = [&](uint32_t a, uint32_t b, uint32_t c, const char* tag) {
+    tests++;
+    if (!run_one(d, a, b, c, tag, /*verbose_on_fail=*/true)) fails++;
+  };
+
+  // Directed tests
+  check(0x7F800000u, 0x00000000u, 0x3F800000u, "Inf*0+1 => invalid");
+  check(0x7F800000u, 0x3F800000u, 0xFF800000u, "Inf-Inf => invalid");
+  check(0x3F800000u, 0x3F800000u, 0x7FC00001u, "1*1+NaN");
+  check(0x00000001u, 0x3F800000u, 0x80000000u, "sub*1-0 => +0 (DAZ)");
+  check(0x80000000u, 0x3F800000u, 0x80000000u, "-0*1-0 => -0");
+  check(0x3F800001u, 0x3F800001u, 0xBF800002u, "exact cancellation of the high part");
+  check(0x3FC00000u, 0x40000000u, 0xC0400000u, "1.5*2-3 => +0");
+  check(0x3F800000u, 0x3F800000u, 0x33800000u, "1+2^-24: tie, even => 1");
+  check(0x3F800001u, 0x3F800000u, 0x33800000u, "1+ulp+2^-24: tie, odd => up");
+  check(0x3F800000u, 0x3F800000u, 0x33800001u, "1+just over half ulp => up");
+  check(0x00800001u, 0x3F800000u, 0x80800000u, "difference below min_norm => FTZ");
+  check(0x7F7FFFFFu, 0x3F800000u, 0x7F7FFFFFu, "max_finite+max_finite => overflow");
+  check(0x3F800000u, 0x3F800000u, 0x7F000000u, "c dominant, product sticky only");
+  check(0x7E800000u, 0x40000000u, 0x3F800000u, "product dominant, c sticky only");
+
+  // Random tests
+  StimGen gen(seed, weights);
+  std::vector<uint32_t> a(batch), b(batch), c(batch), y(batch), y_ref(batch);
+  std::vector<uint8_t> flags(batch), f_ref(batch);
+  bool failed = false;
+  bool hung = false;
+  uint64_t fail_index = 0;
+
+  for (uint64_t done = 0; done < nrand && !failed; ) {
+    const size_t n = (size_t)std::min<uint64_t>(batch, nrand - done);
+    for (size_t i = 0; i < n; i++) stim_vector(gen, start + done + i, a[i], b[i], c[i]);
+
+#ifdef FFMA_PIPE
+    const uint64_t cycles0 = d.cycles;
+#endif
+    if (!run_batch(d, a.data(), b.data(), c.data(), y.data(), flags.data(), n)) {
+      failed = hung = true;
+      fail_index = start + done;
+      fails++;
+      break;
+    }
+#ifdef FFMA_PIPE
+    stream_tests += n;
+    stream_cycles += d.cycles - cycles0;
+#endif
+
+    for (size_t i = 0; i < n; i++) {
+      const RefOut r = ref_fma(a[i], b[i], c[i]);
+      y_ref[i] = r.y;
+      f_ref[i] = pack_ref_flags(r);
+    }
+    const size_t bad = first_mismatch(y.data(), flags.data(), y_ref.data(), f_ref.data(), n,
+                                      check_mask());
+    if (PRINT_OK) {
+      for (size_t i = 0; i < bad; i++) check_result(a[i], b[i], c[i], y[i], flags[i], "rand", false);
+    }
+
+    tests += (bad < n) ? bad + 1 : n;
+    if (bad < n) {
+      failed = true;
+      fail_index = start + done + bad;
+      fails++;
+    }
+    done += n;
+  }
+
+  if (failed && !hung) {
+    std::printf("First failing vector: index %llu (replay with --seed %llu --start %llu --n 1)\n",
+                (unsigned long long)fail_index, (unsigned long long)seed,
+                (unsigned long long)fail_index);
+    uint32_t fa, fb, fc;
+    stim_vector(gen, fail_index, fa, fb, fc);
+    run_one(d, fa, fb, fc, "rand (verbose)", /*verbose_on_fail=*/true);
+  }
+
+#if FMUL_TRACE
+  if (d.tfp) {
+    d.tfp->close();
+    delete d.tfp;
+  }
+#endif
+
+  std::printf("\n---------------------------------------------------------------------------------------------------------------------\n");
+  std::printf("Tests run : %llu\n", (unsigned long long)tests);
+  std::printf("Failures  : %llu\n", (unsigned long long)fails);
+  std::printf("Flag check: %s\n", CHECK_FLAGS ? "ENABLED (--check-flags)" : "DISABLED");
+#ifdef FFMA_PIPE
+  std::printf("Stream    : %llu results in %llu cycles (%.3f results/cycle)%s\n",
+              (unsigned long long)stream_tests, (unsigned long long)stream_cycles,
+              stream_cycles ? (double)stream_tests / (double)stream_cycles : 0.0,
+              backpressure ? ", with back-pressure" : "");
+#endif
+  std::printf("---------------------------------------------------------------------------------------------------------------------\n");
+
+  d.dut->final();
+  delete d.dut;
+  return fails ? 1 : 0;
+}
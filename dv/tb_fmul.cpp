@@ -2,12 +2,76 @@
 //
 // Verilator C++ testbench for fmul. Fmul supports only qNaN, denormals are zero and we are flushing to zero.
 // Features:
-//  - Reference model matching DUT behavior (DAZ/FTZ + constant qNaN)
-//  - Optional VCD tracing:        --trace   (writes wave.vcd)
+//  - Reference model matching DUT behavior (DAZ/FTZ + constant qNaN), see fmul_ref.h;
+//    gradual underflow instead for a SUBNORMAL_SUPPORT=1 DUT built with -DFMUL_SUBNORMAL=1;
+//    batches use its AVX-512/AVX2 kernel:  --ref-isa <scalar|avx2|avx512>
+//  - Differential check of the reference itself: every batch of reference
+//    results is compared with the host FPU or Berkeley SoftFloat, see
+//    fmul_oracle.h:               --oracle <host|softfloat>
+//  - Optional tracing:            --trace   (writes wave.vcd, or wave.fst for an FST build)
+//    Tracing is chosen at build time, FMUL_TRACE in fmul_trace.h: 0 compiles
+//    it out, 1 is VCD, 2 FST. Triggered mode keeps the last K vectors in
+//    memory and writes wave_fail_<index>.<vcd|fst> only on a mismatch:
+//                                 --trace-window <K>
 //  - Optional print on PASS too:  --print-ok
 //  - Optional check of status flags (invalid/overflow/underflow/inexact):
 //                                 --check-flags     (enable checking; default is OFF)
 //  - Random test count:           --n <N>
+//  - Rounding mode on the DUT rm input, reference follows:
+//                                 --rm <rne|rtz|rdn|rup|rmm>   (default rne)
+//  - Counter-based stimulus stream (fmul_stim.h): vector i depends only on
+//    --seed and i, any vector can be replayed alone, class mix is a weight table:
+//                                 --start <I>  --stim-weights <W0,...,W8>
+//  - Functional coverage (class pairs, normalize shift, L/G/R/S, rounding
+//    carry, exponent boundaries), optionally steering generation toward
+//    the least-hit bins, see fmul_cov.h:
+//                                 --coverage  --cov-directed  --until-covered
+//  - Random vectors are generated, driven and checked in batches:
+//                                 --batch <B>       (default 4096)
+//  - Sharded multi-threaded run, one model per thread:
+//                                 --jobs <J> [--chunk <C>]
+//    Shard k (C vectors, default 65536) starts at stream index k*C,
+//    so every shard replays identically for any J.
+//  - Multithreaded model (verilator --threads T, built with
+//    -DFMUL_MODEL_THREADS=T): every context gets T threads, --jobs 0 runs
+//    hardware threads / T models (run_verilator.sh --threads, --par)
+//  - Exhaustive sweep of an operand tile with checkpoint/resume and a
+//    mergeable JSON summary line:
+//                                 --sweep <A_LO:A_HI:B_LO:B_HI> [--checkpoint <F>] [--summary <F>]
+//    Formats of at most 16 bits (fp16, bf16) can sweep every operand pair,
+//    on all cores unless --jobs says otherwise, with a vectors/s report:
+//                                 --exhaustive
+//  - Continue-on-fail: mismatches are logged per thread, deduplicated by
+//    failure class and dumped once per class at the end:
+//                                 --max-fails <K>   (0 = no limit)
+//  - Binary vector files (fmul_vecfile.h), memory mapped: replay a golden set
+//    or an archived run, or record the random vectors with reference results:
+//                                 --replay <F>  --record <F>
+//  - Regression database (fmul_regdb.h): the minimized failures of earlier
+//    runs are replayed before anything else, this run's failures are shrunk
+//    into that corpus, and the run (configuration, stimulus range,
+//    throughput, coverage bins, failing vectors) is appended to DIR/runs.jsonl:
+//                                 --db <DIR>  [--db-label <S>]
+//  - Throughput benchmark of a random run: vectors/s, ns/vector spent in
+//    the DUT, the reference model and stimulus generation, peak RSS, as
+//    one JSON line (bench_verilator.sh runs the configuration matrix):
+//                                 --bench <F|->  [--bench-label <S>]
+//  - Result statistics: histogram of the checked random vectors over the
+//    fmul_stats result classes, flags and subnormal operands (fmul_stats.h):
+//                                 --stats
+//    An fmul_stats build (-DFMUL_PIPE -DFMUL_STATS=<CNT_W>) also reads the
+//    DUT's counters back through the CSR port at the end of every model's
+//    run and checks them against the same histogram of what it drove
+//  - Pipelined DUT (fmul_pipe, built with -DFMUL_PIPE): random vectors are
+//    streamed at one per cycle and checked in order; --backpressure adds
+//    random input bubbles and out_ready stalls
+//  - Vector DUT (fmul_vec, built with -DFMUL_PIPE -DFMUL_VEC=<LANES>): every
+//    cycle carries LANES vectors, the any_*/sticky_* flag outputs are checked
+//    against the lane flags on every cycle
+//  - Any format the RTL is built for (-DFMUL_EXP/-DFMUL_MANT/-DFMUL_BIAS
+//    matching -GEXP/-GMANT/-GBIAS, e.g. run_verilator.sh --format bf16):
+//    reference, stimulus, coverage and vector files follow RefFmt, values
+//    are fp_word (fmul_ref.h)
 //
 // Example runs:
 //  1) Quiet (print only FAIL), don't check flags:
@@ -18,265 +82,165 @@
 //        ./obj_dir/Vfmul --n 50 --print-ok --trace --check-flags
 //  4) Quiet + trace + check flags:
 //        ./obj_dir/Vfmul --n 200000 --trace --check-flags
+//  5) Exhaustive sweep of one tile on all cores, resumable:
+//        ./obj_dir/Vfmul --check-flags --jobs 0 --sweep 0x3f800000:0x3f80ffff:0:0xffffffff
+//                        --checkpoint tile.ckpt --summary tiles.jsonl
+//  6) bf16/fp16 build, every operand pair on all cores:
+//        ./obj_dir/Vfmul --check-flags --exhaustive --checkpoint full.ckpt
+//  7) All cores, check flags:
+//        ./obj_dir/Vfmul --n 100000000 --jobs 0 --check-flags
+//  8) fmul_pipe build, stalls on both sides:
+//        ./obj_dir/Vfmul --n 200000 --check-flags --backpressure
+//  9) Record a run, replay it later on all cores:
+//        ./obj_dir/Vfmul --n 10000000 --record run.fvec
+//        ./obj_dir/Vfmul --check-flags --jobs 0 --replay run.fvec
+// 10) Reference cross-checked against the host FPU, all cores:
+//        ./obj_dir/Vfmul --n 100000000 --jobs 0 --check-flags --rm rdn --oracle host
+// 11) Nightly run against the regression database, every failure class kept:
+//        ./obj_dir/Vfmul --n 100000000 --jobs 0 --check-flags --max-fails 0 --db regress
 
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cmath>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <sys/resource.h>
 
 #include "Vfmul.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+
+#include "fmul_ref.h"
+#include "fmul_cov.h"
+#include "fmul_faillog.h"
+#include "fmul_oracle.h"
+#include "fmul_regdb.h"
+#include "fmul_stats.h"
+#include "fmul_stim.h"
+#include "fmul_trace.h"
+#include "fmul_vecfile.h"
 
 // Global flags
 static bool PRINT_OK = false;
 static bool CHECK_FLAGS = false;
-
-// Bit/float helpers 
-static inline uint32_t f32_to_bits(float f) {
-  union { float f; uint32_t u; } v;
-  v.f = f;
-  return v.u;
-}
-static inline float bits_to_f32(uint32_t u) {
-  float f;
-  static_assert(sizeof(f) == sizeof(u), "float must be 32-bit");
-  std::memcpy(&f, &u, sizeof(f));
-  return f;
-}
-
-// Helpers to extract sign, exp and mantissa
-static inline uint32_t sign_bit(uint32_t x) { return x >> 31; }
-static inline uint32_t exp_field(uint32_t x) { return (x >> 23) & 0xFFu; }
-static inline uint32_t frac_field(uint32_t x) { return x & 0x7FFFFFu; }
-
-// Check if NaN
-static inline bool is_nan_bits(uint32_t x) {
-  return exp_field(x) == 0xFFu && frac_field(x) != 0;
-}
-// Check if Inf
-static inline bool is_inf_bits(uint32_t x) {
-  return exp_field(x) == 0xFFu && frac_field(x) == 0;
-}
-// Check if zero
-static inline bool is_zero_bits(uint32_t x) {
-  return exp_field(x) == 0 && frac_field(x) == 0;
-}
-// Check if subnormal
-static inline bool is_sub_bits(uint32_t x) {
-  return exp_field(x) == 0 && frac_field(x) != 0;
-}
-// We work only with qNaN
-static inline uint32_t qnan_const() { return 0x7FC00000u; }
-
-// Output structure
-struct RefOut {
-  uint32_t y;
-  bool invalid;
-  bool overflow;
-  bool underflow;
-  bool inexact;
-};
-
-// Helper function to generate signed zero
-static inline uint32_t pack_signed_zero(uint32_t sign) {
-  return (sign << 31);
+// Rounding mode driven on the DUT rm input, RefRm (fmul_ref.h)
+static int ROUND_MODE = RM_RNE;
+
+// --bench: time the phases of every random batch (RunStats::*_ns)
+static bool BENCH = false;
+// --stats: histogram of the checked random vectors (RunStats::hist)
+static bool STATS = false;
+// --oracle: second model the reference results are checked against
+static Oracle ORACLE = Oracle::None;
+
+static inline uint64_t bench_ns() {
+  if (!BENCH) return 0;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-// -------------------------------------------------------------------
-// Reference model, all NaNs are qNaN, subnormals are treated as zeros
-// -------------------------------------------------------------------
-static RefOut ref_model(uint32_t a, uint32_t b) {
-  RefOut o{};
-  o.y = 0;
-  o.invalid = o.overflow = o.underflow = o.inexact = false;
-
-  const uint32_t s = (sign_bit(a) ^ sign_bit(b)) & 1u;
-
-  // Any NaN input => constant qNaN
-  if (is_nan_bits(a) || is_nan_bits(b)) {
-    o.y = qnan_const();
-    return o;
-  }
-
-  // Treat subnormals as zero
-  const bool a_eff_zero = is_zero_bits(a) || is_sub_bits(a);
-  const bool b_eff_zero = is_zero_bits(b) || is_sub_bits(b);
-
-  const bool a_inf = is_inf_bits(a);
-  const bool b_inf = is_inf_bits(b);
-
-  // Inf * 0 => invalid + qNaN
-  if ((a_inf && b_eff_zero) || (b_inf && a_eff_zero)) {
-    o.invalid = true;
-    o.y = qnan_const();
-    return o;
-  }
-
-  // Inf * finite => Inf
-  if (a_inf || b_inf) {
-    o.y = (s << 31) | (0xFFu << 23);
-    return o;
-  }
-
-  // 0 * anything => signed zero
-  if (a_eff_zero || b_eff_zero) {
-    o.y = pack_signed_zero(s);
-    return o;
-  }
-
-  // ------------------------------------------------------------
-  // Normal finite multiply path 
-  // Inputs are normal because we threat subnormals as zeros
-  // ------------------------------------------------------------
-  const uint32_t expA_biased = exp_field(a);
-  const uint32_t expB_biased = exp_field(b);
-  const uint32_t fracA   = frac_field(a);
-  const uint32_t fracB   = frac_field(b);
-
-  // 24-bit significands with hidden 1
-  const uint32_t sigA = (1u << 23) | fracA; // [23:0]
-  const uint32_t sigB = (1u << 23) | fracB; // [23:0]
-
-  // Unbiased exponents
-  int expA_unbiased = (int)expA_biased - 127;
-  int expB_unbiased = (int)expB_biased - 127;
-  int expP_unbiased = expA_unbiased + expB_unbiased;
-
-  // 24x24 -> 48-bit product
-  uint64_t prod = (uint64_t)sigA * (uint64_t)sigB; // up to 48 bits
-
-  // Normalize into [1,2)
-  // Leading 1 should be at bit 46
-  // If prod[47]=1, it's in [2,4) => shift right 1 and increment exponent
-  if (prod & (1ULL << 47)) {
-    prod >>= 1;
-    expP_unbiased += 1;
-  }
-
-  // upper_bits = prod[46:23]  (24 bits: hidden 1 + 23 fraction bits)
-  // G = prod[22], R = prod[21], S = OR(prod[20:0])
-  const uint32_t upper_bits = (uint32_t)((prod >> 23) & 0xFFFFFFu);
-  const uint32_t G = (uint32_t)((prod >> 22) & 1u);
-  const uint32_t R = (uint32_t)((prod >> 21) & 1u);
-  const uint32_t low21 = (uint32_t)(prod & ((1u << 21) - 1u));
-  const uint32_t S = (low21 != 0) ? 1u : 0u;
-
-  // RN ties-to-even increment rule
-  const uint32_t LSB = upper_bits & 1u;
-  const uint32_t inc = G & (R | S | LSB);
-
-  // Add increment; may carry out to bit 24 (25th bit)
-  uint32_t upper_bits_rounded = upper_bits + inc;
-  int expR_unbiased = expP_unbiased;
-
-  // Carry-out means it became 10.xxxxx (25 bits). Renormalize by shifting right 1 and exp++
-  if (upper_bits_rounded & (1u << 24)) {
-    upper_bits_rounded >>= 1;
-    expR_unbiased += 1;
-  }
-
-  // Inexact if any discarded bits were nonzero
-  if (G | R | S) o.inexact = true;
-
-  // ------------------------------------------------------------
-  // Flush to zero and overflow handling
-  // ------------------------------------------------------------
-  if (expR_unbiased > 127) {
-    // Overflow => Inf
-    o.overflow = true;
-    o.inexact  = true;
-    o.y = (s << 31) | (0xFFu << 23);
-    return o;
-  }
-
-  if (expR_unbiased < -126) {
-    // Would be subnormal => flush to zero
-    o.underflow = true;
-    o.inexact   = true;
-    o.y = pack_signed_zero(s);
-    return o;
-  }
-
-  // Normal pack
-  const uint32_t exp_out = (uint32_t)(expR_unbiased + 127) & 0xFFu;
-  const uint32_t frac_out = upper_bits_rounded & 0x7FFFFFu; // drop hidden 1
-  o.y = (s << 31) | (exp_out << 23) | frac_out;
-
-  return o;
-}
+// Keeps multi-line case dumps from different --jobs threads apart
+static std::mutex PRINT_MUTEX;
 
+// Hex digits of a value and of its exponent and fraction fields
+static const int HEX_W = (RefFmt::WIDTH + 3) / 4;
+static const int HEX_E = (REF_EXP + 3) / 4;
+static const int HEX_M = (REF_MANT + 3) / 4;
 
 // -----------------------------------------------------------------
 // Pretty printing :)
 // -----------------------------------------------------------------
-static void print_fp(const char* label, uint32_t bits) {
-  uint32_t sign = (bits >> 31) & 0x1;
-  uint32_t exp  = (bits >> 23) & 0xFF;
-  uint32_t man  = bits & 0x7FFFFF;
+static void print_fp(const char* label, fp_word bits) {
+  const unsigned long long v    = bits;
+  const unsigned long long sign = sign_bit(bits);
+  const unsigned long long exp  = exp_field(bits);
+  const unsigned long long man  = frac_field(bits);
 
   char sgnc = sign ? '-' : '+'; // Treat sign bit as character - or +
 
   int unbiased;
-  uint32_t sig_int;             // integer significand (includes hidden 1 for normals)
-  const int sig_div_pow = 23;   // divide by 2^23 for binary32
+  unsigned long long sig_int;         // integer significand (includes hidden 1 for normals)
+  const int sig_div_pow = REF_MANT;   // divide by 2^MANT
 
   if (exp == 0) {
-    unbiased = -126;
+    unbiased = 1 - REF_BIAS;
     sig_int  = man; // subnormal or zero: 0.mantissa
   } else {
-    unbiased = (int)exp - 127;
-    sig_int  = (1u << 23) | man; // normal (and exp=255): 1.mantissa
+    unbiased = (int)exp - REF_BIAS;
+    sig_int  = (1ull << REF_MANT) | man; // normal (and all-ones exponent): 1.mantissa
   }
 
   if (is_nan_bits(bits)) {
     std::printf(
-      "  %-8s : 0x%08x  NaN"
-      "  | s=0x%x e=0x%02x m=0x%06x"
-      "  | sgn=%c ue=%d m=%9u / 2^%d\n",
-      label, bits, sign, exp, man,
+      "  %-8s : 0x%0*llx  NaN"
+      "  | s=0x%llx e=0x%0*llx m=0x%0*llx"
+      "  | sgn=%c ue=%d m=%9llu / 2^%d\n",
+      label, HEX_W, v, sign, HEX_E, exp, HEX_M, man,
       sgnc, unbiased, sig_int, sig_div_pow
     );
   }
   else if (is_inf_bits(bits)) {
     std::printf(
-      "  %-8s : 0x%08x  %sInf"
-      "  | s=0x%x e=0x%02x m=0x%06x"
-      "  | sgn=%c ue=%d m=%9u / 2^%d\n",
-      label, bits, (sign ? "-" : "+"), sign, exp, man,
+      "  %-8s : 0x%0*llx  %sInf"
+      "  | s=0x%llx e=0x%0*llx m=0x%0*llx"
+      "  | sgn=%c ue=%d m=%9llu / 2^%d\n",
+      label, HEX_W, v, (sign ? "-" : "+"), sign, HEX_E, exp, HEX_M, man,
       sgnc, unbiased, sig_int, sig_div_pow
     );
   }
   else {
-    float f = bits_to_f32(bits);
+    // Exact in a double for every format up to binary64
+    const double mag = std::ldexp((double)sig_int, unbiased - REF_MANT);
     std::printf(
-      "  %-8s : 0x%08x  %+.20e"
-      "  | s=0x%x e=0x%02x m=0x%06x"
-      "  | sgn=%c ue=%d m=%9u / 2^%d\n",
-      label, bits, f, sign, exp, man,
+      "  %-8s : 0x%0*llx  %+.20e"
+      "  | s=0x%llx e=0x%0*llx m=0x%0*llx"
+      "  | sgn=%c ue=%d m=%9llu / 2^%d\n",
+      label, HEX_W, v, sign ? -mag : mag, sign, HEX_E, exp, HEX_M, man,
       sgnc, unbiased, sig_int, sig_div_pow
     );
   }
 }
 
+// Section rule of a case dump, label centered
+static void print_rule(const char* label) {
+  static const char dashes[] = "------------------------------------------------------------";
+  const int w = 113 - (int)std::strlen(label);
+  std::printf(" %.*s %s %.*s \n", w / 2, dashes, label, w - w / 2, dashes);
+}
+
 static void print_case(const char* status, const char* tag,
-                       uint32_t a, uint32_t b,
-                       uint32_t y_dut, bool inv_dut, bool ovf_dut, bool unf_dut, bool inx_dut,
-                       uint32_t y_ref, bool inv_ref, bool ovf_ref, bool unf_ref, bool inx_ref) {
+                       fp_word a, fp_word b,
+                       fp_word y_dut, bool inv_dut, bool ovf_dut, bool unf_dut, bool inx_dut,
+                       fp_word y_ref, bool inv_ref, bool ovf_ref, bool unf_ref, bool inx_ref,
+                       const char* lhs = "DUT", const char* rhs = "REF") {
   std::printf("\n==================================================== %s [%s] ====================================================\n", status, tag);
 
   print_fp("a", a);
   print_fp("b", b);
 
-  std::printf("\n ------------------------------------------------------- DUT ------------------------------------------------------- \n");
+  std::printf("\n");
+  print_rule(lhs);
   print_fp("y", y_dut);
   std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
               (int)inv_dut, (int)ovf_dut, (int)unf_dut, (int)inx_dut);
 
-  std::printf("\n ------------------------------------------------------- REF ------------------------------------------------------- \n\n");
+  std::printf("\n");
+  print_rule(rhs);
+  std::printf("\n");
   print_fp("y", y_ref);
   std::printf("  flags    : invalid=%d overflow=%d underflow=%d inexact=%d\n",
               (int)inv_ref, (int)ovf_ref, (int)unf_ref, (int)inx_ref);
@@ -285,57 +249,127 @@ static void print_case(const char* status, const char* tag,
 }
 
 // -----------------------------------------------------------------
-// Evaluation + optional trace
+// Driver state: one model plus its trace and time
 // -----------------------------------------------------------------
-static inline void tick_eval(Vfmul* dut,
-                             VerilatedVcdC* tfp,
-                             vluint64_t& t) {
-  dut->eval();
-  if (tfp) tfp->dump(t);
-  t++;
-}
+struct Driver {
+  Vfmul* dut = nullptr;
+#if FMUL_TRACE
+  TraceFile* tfp = nullptr;
+#endif
+  vluint64_t t = 0;
+#ifdef FMUL_PIPE
+  // Random bubbles / out_ready stalls. Separate RNG for handshake timing so
+  // the operand stream is the same as in combinational mode for a --seed.
+  bool backpressure = false;
+  std::mt19937_64 stall_rng;
+  uint64_t cycles = 0;
+  bool hung = false;
+#endif
+#ifdef FMUL_STATS
+  FmulStats hw;  // what the DUT counters should read
+#endif
+};
 
 // -----------------------------------------------------------------
-// Single test
+// Evaluation + optional trace
 // -----------------------------------------------------------------
-static bool run_one(Vfmul* dut,
-                    VerilatedVcdC* tfp,
-                    vluint64_t& t,
-                    uint32_t a, uint32_t b,
-                    const char* tag,
-                    bool verbose_on_fail) {
-  dut->a = a;
-  dut->b = b;
+static inline bool tracing(const Driver& d) {
+#if FMUL_TRACE
+  return d.tfp != nullptr;
+#else
+  (void)d;
+  return false;
+#endif
+}
 
-  tick_eval(dut, tfp, t);
-  tick_eval(dut, tfp, t);
+static inline void tick_eval(Driver& d) {
+  d.dut->eval();
+#if FMUL_TRACE
+  if (d.tfp) d.tfp->dump(d.t);
+#endif
+  d.t++;
+}
+
+// Vectors per DUT beat: fmul_vec is built with -DFMUL_VEC=<LANES>
+#ifdef FMUL_VEC
+#ifndef FMUL_PIPE
+#error "FMUL_VEC builds drive fmul_vec through the fmul_pipe handshake, define FMUL_PIPE too"
+#endif
+static const size_t LANES = FMUL_VEC;
+static_assert(LANES >= 1 && LANES <= 32, "FMUL_VEC lane count must be in 1..32");
+#else
+static const size_t LANES = 1;
+#endif
+
+// Threads per model: verilator --threads T, built with -DFMUL_MODEL_THREADS=T
+#ifndef FMUL_MODEL_THREADS
+#define FMUL_MODEL_THREADS 1
+#endif
+static_assert(FMUL_MODEL_THREADS >= 1, "FMUL_MODEL_THREADS must be at least 1");
+static const unsigned MODEL_THREADS = FMUL_MODEL_THREADS;
+
+// Models that fill the hardware threads, MODEL_THREADS each (--jobs 0)
+static unsigned all_core_jobs() {
+  return std::max(1u, std::thread::hardware_concurrency() / MODEL_THREADS);
+}
 
-  uint32_t y_dut = dut->y;
-  bool inv_dut = dut->invalid;
-  bool ovf_dut = dut->overflow;
-  bool unf_dut = dut->underflow;
-  bool inx_dut = dut->inexact;
+// Size a private context for one model: one pool of MODEL_THREADS - 1
+// workers per context instead of Verilator's default of one per core
+static void set_model_threads(VerilatedContext& ctx) {
+#if FMUL_MODEL_THREADS > 1
+  ctx.threads(MODEL_THREADS);
+#else
+  (void)ctx;
+#endif
+}
 
-  RefOut r = ref_model(a, b);
+// fmul_stats wraps a single-lane fmul_pipe, -DFMUL_STATS=<CNT_W>
+#ifdef FMUL_STATS
+#if !defined(FMUL_PIPE) || defined(FMUL_VEC)
+#error "FMUL_STATS builds drive fmul_stats through the fmul_pipe handshake, define FMUL_PIPE and not FMUL_VEC"
+#endif
+static_assert(FMUL_STATS >= 1 && FMUL_STATS <= 64, "FMUL_STATS counter width must be in 1..64");
+#endif
+
+// DUT flag ports packed like the reference flags (FLAG_* in fmul_ref.h)
+static inline uint8_t sample_flags(const Vfmul* dut) {
+  return (uint8_t)((dut->invalid << 3) | (dut->overflow << 2) |
+                   (dut->underflow << 1) | dut->inexact);
+}
 
+// -----------------------------------------------------------------
+// Compare one DUT result against the reference model
+// -----------------------------------------------------------------
+static inline bool same_result(const RefOut& dut, const RefOut& ref) {
   // Check result bits
-  bool ok_y = (y_dut == r.y);
+  bool ok_y = (dut.y == ref.y);
 
   // Check flags (optionally)
   bool ok_flags = true;
   if (CHECK_FLAGS) {
-    ok_flags = (inv_dut == r.invalid) &&
-               (ovf_dut == r.overflow) &&
-               (unf_dut == r.underflow) &&
-               (inx_dut == r.inexact);
+    ok_flags = (dut.invalid == ref.invalid) &&
+               (dut.overflow == ref.overflow) &&
+               (dut.underflow == ref.underflow) &&
+               (dut.inexact == ref.inexact);
   }
 
-  bool ok = ok_y && ok_flags;
+  return ok_y && ok_flags;
+}
+
+static bool check_result(fp_word a, fp_word b,
+                         const RefOut& dut,
+                         const char* tag,
+                         bool verbose_on_fail) {
+  RefOut r = ref_model(a, b, ROUND_MODE);
+
+  bool ok_y = (dut.y == r.y);
+  bool ok = same_result(dut, r);
 
   if ((!ok && verbose_on_fail) || (ok && PRINT_OK)) {
+    std::lock_guard<std::mutex> lock(PRINT_MUTEX);
     print_case(ok ? "PASS" : "FAIL", tag,
                a, b,
-               y_dut, inv_dut, ovf_dut, unf_dut, inx_dut,
+               dut.y, dut.invalid, dut.overflow, dut.underflow, dut.inexact,
                r.y, r.invalid, r.overflow, r.underflow, r.inexact);
 
     if (!ok && !CHECK_FLAGS && !ok_y) {
@@ -346,108 +380,1929 @@ static bool run_one(Vfmul* dut,
     }
   }
 
-  tick_eval(dut, tfp, t);
-  tick_eval(dut, tfp, t);
+  return ok;
+}
+
+#ifndef FMUL_PIPE
+// -----------------------------------------------------------------
+// Batched driver: n operand pairs in, n DUT results out.
+// The DUT is combinational, so without tracing a single eval per
+// vector is enough. With tracing keep the settle/hold evals so every
+// vector gets its own span in the waveform.
+// -----------------------------------------------------------------
+static bool run_batch(Driver& d,
+                      const fp_word* a, const fp_word* b,
+                      fp_word* y, uint8_t* flags, size_t n) {
+  Vfmul* dut = d.dut;
+  dut->rm = (uint8_t)ROUND_MODE;
+
+  if (!tracing(d)) {
+    for (size_t i = 0; i < n; i++) {
+      dut->a = a[i];
+      dut->b = b[i];
+      dut->eval();
+      y[i] = dut->y;
+      flags[i] = sample_flags(dut);
+    }
+    d.t += n;
+    return true;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    dut->a = a[i];
+    dut->b = b[i];
+    tick_eval(d);
+    tick_eval(d);
+    y[i] = dut->y;
+    flags[i] = sample_flags(dut);
+    tick_eval(d);
+    tick_eval(d);
+  }
+  return true;
+}
+#else
+// -----------------------------------------------------------------
+// fmul_pipe: clocking and handshake
+// -----------------------------------------------------------------
+static inline void tick_clk(Driver& d) {
+  d.dut->clk = 0;
+  tick_eval(d);
+  d.dut->clk = 1;
+  tick_eval(d);
+}
+
+static void reset_pipe(Driver& d) {
+  d.dut->in_valid  = 0;
+  d.dut->out_ready = 0;
+  d.dut->rst_n     = 0;
+#ifdef FMUL_STATS
+  d.dut->csr_rd  = 0;
+  d.dut->csr_clr = 0;
+#endif
+  for (int i = 0; i < 4; i++) tick_clk(d);
+  d.dut->rst_n = 1;
+  tick_clk(d);
+}
+
+// Longest legal wait for a handshake before the pipe counts as hung
+static const int PIPE_TIMEOUT = 64;
+
+// -----------------------------------------------------------------
+// Lane access to packed Verilator ports: lane l is bits [W*l +: W],
+// W = RefFmt::WIDTH, of a CData/SData/IData/QData port (up to 64 bits)
+// or of a VlWide port of 32-bit words, where a lane may straddle words.
+// -----------------------------------------------------------------
+static const int LANE_BITS = RefFmt::WIDTH;
+
+template <typename P>
+static inline typename std::enable_if<std::is_integral<P>::value>::type
+set_lane(P& p, size_t l, fp_word v) {
+  const int sh = (int)(LANE_BITS * l);
+  p = (P)(((uint64_t)p & ~((uint64_t)RefFmt::MASK << sh)) | ((uint64_t)v << sh));
+}
+template <std::size_t N>
+static inline void set_lane(VlWide<N>& p, size_t l, fp_word v) {
+  for (int k = 0; k < LANE_BITS; ) {
+    const size_t bit = LANE_BITS * l + k;
+    const int off = (int)(bit % 32);
+    const int n = std::min(32 - off, LANE_BITS - k);
+    const uint32_t m = (uint32_t)(((1ull << n) - 1) << off);
+    p[bit / 32] = (p[bit / 32] & ~m) | ((uint32_t)((uint64_t)v >> k << off) & m);
+    k += n;
+  }
+}
+
+template <typename P>
+static inline typename std::enable_if<std::is_integral<P>::value, fp_word>::type
+get_lane(P p, size_t l) {
+  return (fp_word)(((uint64_t)p >> (LANE_BITS * l)) & RefFmt::MASK);
+}
+template <std::size_t N>
+static inline fp_word get_lane(const VlWide<N>& p, size_t l) {
+  uint64_t v = 0;
+  for (int k = 0; k < LANE_BITS; ) {
+    const size_t bit = LANE_BITS * l + k;
+    const int off = (int)(bit % 32);
+    const int n = std::min(32 - off, LANE_BITS - k);
+    v |= (((uint64_t)p[bit / 32] >> off) & ((1ull << n) - 1)) << k;
+    k += n;
+  }
+  return (fp_word)v;
+}
+
+// Flags of lane l, packed like sample_flags()
+static inline uint8_t sample_lane_flags(const Vfmul* dut, size_t l) {
+  return (uint8_t)((((dut->invalid >> l) & 1u) << 3) | (((dut->overflow >> l) & 1u) << 2) |
+                   (((dut->underflow >> l) & 1u) << 1) | ((dut->inexact >> l) & 1u));
+}
+
+// -----------------------------------------------------------------
+// Batched driver: stream n operand pairs through the pipe at one beat
+// of LANES vectors per cycle (or with random bubbles and back-pressure)
+// and collect the results in issue order. The last beat is padded with
+// copies of the last vector. Returns false if the pipe hangs, or for
+// fmul_vec if the any_*/sticky_* flag outputs disagree with the lanes.
+// -----------------------------------------------------------------
+static bool run_batch(Driver& d,
+                      const fp_word* a, const fp_word* b,
+                      fp_word* y, uint8_t* flags, size_t n) {
+  Vfmul* dut = d.dut;
+  dut->rm = (uint8_t)ROUND_MODE;
+  const size_t beats = (n + LANES - 1) / LANES;
+  size_t sent = 0, done = 0;
+  int idle = 0;
+#ifdef FMUL_VEC
+  uint8_t sticky = 0;
+  dut->sticky_clr = 1;
+#endif
+
+  while (done < beats) {
+    for (size_t l = 0; l < LANES; l++) {
+      const size_t i = std::min(sent * LANES + l, n - 1);
+      set_lane(dut->a, l, a[i]);
+      set_lane(dut->b, l, b[i]);
+    }
+    dut->in_valid  = sent < beats && (!d.backpressure || (d.stall_rng() & 3u) != 0);
+    dut->out_ready = !d.backpressure || (d.stall_rng() & 3u) != 0;
+
+    dut->clk = 0;
+    tick_eval(d);
+
+    // Sample both handshakes before the rising edge
+    bool fire_in  = dut->in_valid && dut->in_ready;
+    bool fire_out = dut->out_valid && dut->out_ready;
+    // OR over the lanes of the result on the output
+    uint8_t beat_flags = 0;
+    if (dut->out_valid) {
+      for (size_t l = 0; l < LANES; l++) beat_flags |= sample_lane_flags(dut, l);
+    }
+
+    if (fire_out) {
+      if (done == sent) {
+        std::printf("ERROR: out_valid with no vector in flight\n");
+        d.hung = true;
+        return false;
+      }
+      for (size_t l = 0; l < LANES; l++) {
+        const size_t i = done * LANES + l;
+        if (i >= n) break;
+        y[i] = get_lane(dut->y, l);
+        flags[i] = sample_lane_flags(dut, l);
+      }
+      done++;
+      idle = 0;
+    } else if (++idle == PIPE_TIMEOUT) {
+      std::printf("ERROR: no result for %d cycles (%zu beats in flight)\n",
+                  PIPE_TIMEOUT, sent - done);
+      d.hung = true;
+      return false;
+    }
+
+#ifdef FMUL_VEC
+    const uint8_t any = (uint8_t)((dut->any_invalid << 3) | (dut->any_overflow << 2) |
+                                  (dut->any_underflow << 1) | dut->any_inexact);
+    if (dut->out_valid && any != beat_flags) {
+      std::printf("ERROR: any_* flags 0x%x, OR over lanes is 0x%x\n", any, beat_flags);
+      return false;
+    }
+    sticky = (uint8_t)((dut->sticky_clr ? 0 : sticky) | (fire_out ? beat_flags : 0));
+#endif
+
+    if (fire_in) sent++;
+
+    dut->clk = 1;
+    tick_eval(d);
+    d.cycles++;
+
+#ifdef FMUL_VEC
+    dut->sticky_clr = 0;
+    const uint8_t st = (uint8_t)((dut->sticky_invalid << 3) | (dut->sticky_overflow << 2) |
+                                 (dut->sticky_underflow << 1) | dut->sticky_inexact);
+    if (st != sticky) {
+      std::printf("ERROR: sticky flags 0x%x, expected 0x%x\n", st, sticky);
+      return false;
+    }
+#endif
+  }
+
+  dut->in_valid  = 0;
+  dut->out_ready = 1;
+#ifdef FMUL_STATS
+  d.hw.sample(a, b, y, flags, n);
+#endif
+  return true;
+}
 
+#ifdef FMUL_STATS
+// -----------------------------------------------------------------
+// fmul_stats: read every counter through the CSR port, one read per
+// cycle, and compare with the histogram of the vectors this model
+// ran. Call with the pipe empty (after run_batch returned true).
+// -----------------------------------------------------------------
+static bool check_stats_csr(Driver& d) {
+  bool ok = true;
+  for (int k = 0; k < STAT_N; k++) {
+    d.dut->csr_rd = 1;
+    d.dut->csr_addr = (uint8_t)k;
+    tick_clk(d);
+    d.dut->csr_rd = 0;
+    const uint64_t hw = d.dut->csr_rdata;
+    const uint64_t sw = d.hw.sat(k, FMUL_STATS);
+    if (!d.dut->csr_rvalid || hw != sw) {
+      std::lock_guard<std::mutex> lock(PRINT_MUTEX);
+      std::printf("ERROR: stats CSR %d (%s) reads %llu%s, expected %llu\n", k, STAT_NAME[k],
+                  (unsigned long long)hw, d.dut->csr_rvalid ? "" : " without csr_rvalid",
+                  (unsigned long long)sw);
+      ok = false;
+    }
+  }
   return ok;
 }
 
+// Models whose counters disagreed, over all threads
+static std::atomic<unsigned> STATS_CSR_FAILS{0};
+#endif
+#endif
+
+// -----------------------------------------------------------------
+// Batch results, structure of arrays: y[] and one packed
+// {invalid, overflow, underflow, inexact} byte per vector
+// -----------------------------------------------------------------
+struct Results {
+  std::vector<fp_word> y;
+  std::vector<uint8_t> flags;
+  explicit Results(size_t n) : y(n), flags(n) {}
+  RefOut at(size_t i) const { return unpack_ref_flags(y[i], flags[i]); }
+};
+
+// Flag bits that take part in the compare
+static inline uint8_t check_mask() { return CHECK_FLAGS ? FLAG_ALL : 0; }
+
+// -----------------------------------------------------------------
+// --oracle: every batch of reference results (or vector file results)
+// is compared with an independent model (fmul_oracle.h), all flags
+// whatever --check-flags says. A disagreement is a reference model or
+// oracle bug, not a DUT one, and fails the run; the first few are
+// dumped.
+// -----------------------------------------------------------------
+struct OracleStats {
+  std::atomic<uint64_t> tests{0};
+  std::atomic<uint64_t> fails{0};
+  std::atomic<uint64_t> ns{0};  // --bench: time in oracle_batch(), summed over threads
+};
+static OracleStats ORACLE_ST;
+static const uint64_t ORACLE_MAX_DUMPS = 8;
+
+static void oracle_check(const fp_word* a, const fp_word* b, const fp_word* y,
+                         const uint8_t* flags, size_t n, uint8_t mask = FLAG_ALL) {
+  if (ORACLE == Oracle::None) return;
+  thread_local Results orc(0);
+  if (orc.y.size() < n) orc = Results(n);
+
+  const uint64_t t0 = bench_ns();
+  oracle_batch<RefFmt>(ORACLE, a, b, orc.y.data(), orc.flags.data(), n, ROUND_MODE, REF_SUBNORMAL);
+  if (BENCH) ORACLE_ST.ns += bench_ns() - t0;
+  ORACLE_ST.tests += n;
+
+  for (size_t i = 0; ; i++) {
+    i += first_mismatch(y + i, flags + i, orc.y.data() + i, orc.flags.data() + i, n - i, mask);
+    if (i >= n) break;
+    if (ORACLE_ST.fails++ < ORACLE_MAX_DUMPS) {
+      std::lock_guard<std::mutex> lock(PRINT_MUTEX);
+      const RefOut r = unpack_ref_flags(y[i], flags[i]);
+      const RefOut o = orc.at(i);
+      print_case("ORACLE", "reference and oracle disagree", a[i], b[i],
+                 r.y, r.invalid, r.overflow, r.underflow, r.inexact,
+                 o.y, o.invalid, o.overflow, o.underflow, o.inexact,
+                 "REF", oracle_name(ORACLE));
+    }
+  }
+}
+
+// -----------------------------------------------------------------
+// Batch check: reference results for the whole batch, then one
+// vector compare pass. Returns the index of the first mismatch, or n.
+// Specialized on the flag check and PASS printing; the instance for
+// the run is picked once by select_kernels().
+// -----------------------------------------------------------------
+typedef size_t (*CheckBatchFn)(const fp_word* a, const fp_word* b,
+                               const Results& dut, Results& ref, size_t n,
+                               uint64_t* ref_ns);
+
+struct Kernels {
+  RefBatchFn ref_batch = nullptr;     // reference for ROUND_MODE, REF_ISA
+  CheckBatchFn check_batch = nullptr;
+};
+static Kernels KERNELS;
+
+template <bool CHECK, bool PRINT>
+static size_t check_batch_k(const fp_word* a, const fp_word* b,
+                            const Results& dut, Results& ref, size_t n,
+                            uint64_t* ref_ns) {
+  const uint64_t t0 = ref_ns ? bench_ns() : 0;
+  KERNELS.ref_batch(a, b, ref.y.data(), ref.flags.data(), n);
+  if (ref_ns) *ref_ns += bench_ns() - t0;
+  oracle_check(a, b, ref.y.data(), ref.flags.data(), n);
+
+  size_t first_fail = first_mismatch(dut.y.data(), dut.flags.data(),
+                                     ref.y.data(), ref.flags.data(), n,
+                                     CHECK ? FLAG_ALL : 0);
+
+  if (PRINT) {
+    for (size_t i = 0; i < first_fail; i++) {
+      check_result(a[i], b[i], dut.at(i), "rand", /*verbose_on_fail=*/false);
+    }
+  }
+
+  return first_fail;
+}
+
+// Dispatch table for the options of this run; call after they are final
+static void select_kernels() {
+  static const CheckBatchFn table[2][2] = {
+    { check_batch_k<false, false>, check_batch_k<false, true> },
+    { check_batch_k<true,  false>, check_batch_k<true,  true> },
+  };
+  KERNELS.ref_batch = ref_batch_select(ROUND_MODE, REF_ISA);
+  KERNELS.check_batch = table[CHECK_FLAGS ? 1 : 0][PRINT_OK ? 1 : 0];
+}
+
+static inline size_t check_batch(const fp_word* a, const fp_word* b,
+                                 const Results& dut, Results& ref, size_t n,
+                                 uint64_t* ref_ns = nullptr) {
+  return KERNELS.check_batch(a, b, dut, ref, n, ref_ns);
+}
+
+// -----------------------------------------------------------------
+// Single test
+// -----------------------------------------------------------------
+static bool run_one(Driver& d,
+                    fp_word a, fp_word b,
+                    const char* tag,
+                    bool verbose_on_fail) {
+  fp_word y;
+  uint8_t flags;
+  if (!run_batch(d, &a, &b, &y, &flags, 1)) return false;
+  return check_result(a, b, unpack_ref_flags(y, flags), tag, verbose_on_fail);
+}
+
+// -----------------------------------------------------------------
+// --trace-window: drive the window again, oldest first, through a fresh
+// traced model in its own context (safe from any --jobs thread) and
+// write wave_fail_<index>.<ext>. The failing vector is the last one.
+// A pipelined DUT is reset first and streamed without back-pressure, so
+// the waveform shows the data of the window, not the original stalls.
+// -----------------------------------------------------------------
+static void dump_window(const TraceWindow<fp_word>& win, uint64_t fail_index) {
+#if FMUL_TRACE
+  std::vector<fp_word> a, b;
+  win.copy_out(a, b);
+  std::vector<fp_word> y(a.size());
+  std::vector<uint8_t> flags(a.size());
+
+  char path[64];
+  std::snprintf(path, sizeof path, "wave_fail_%llu.%s", (unsigned long long)fail_index, TRACE_EXT);
+
+  VerilatedContext ctx;
+  set_model_threads(ctx);
+  ctx.traceEverOn(true);
+  Driver d;
+  d.dut = new Vfmul(&ctx);
+  d.tfp = new TraceFile;
+  d.dut->trace(d.tfp, 99);
+  d.tfp->open(path);
+#ifdef FMUL_PIPE
+  reset_pipe(d);
+#endif
+  run_batch(d, a.data(), b.data(), y.data(), flags.data(), a.size());
+  d.tfp->close();
+  d.dut->final();
+  delete d.tfp;
+  delete d.dut;
+
+  std::lock_guard<std::mutex> lock(PRINT_MUTEX);
+  std::printf("Trace     : last %zu vectors up to index %llu written to %s\n", a.size(),
+              (unsigned long long)fail_index, path);
+#else
+  (void)win;
+  (void)fail_index;
+#endif
+}
+
+// -----------------------------------------------------------------
+// Random regression core: vectors [first, first + nvec) of the
+// stimulus stream, generated, driven and checked a batch at a time.
+// Stops at the first failing vector and returns it, or, with a FailLog
+// hook, logs every mismatch and stops once the shared FailBudget is
+// spent.
+// -----------------------------------------------------------------
+struct RunStats {
+  uint64_t tests = 0;
+  uint64_t fails = 0;
+  uint64_t stream_tests = 0;   // fmul_pipe only
+  uint64_t stream_cycles = 0;  // fmul_pipe only
+  uint64_t stim_ns = 0;        // --bench: time in the phases of run_random()
+  uint64_t dut_ns = 0;
+  uint64_t ref_ns = 0;
+  FmulStats hist;              // --stats: reference results of the checked vectors
+
+  void add(const RunStats& o) {
+    tests         += o.tests;
+    fails         += o.fails;
+    stream_tests  += o.stream_tests;
+    stream_cycles += o.stream_cycles;
+    stim_ns       += o.stim_ns;
+    dut_ns        += o.dut_ns;
+    ref_ns        += o.ref_ns;
+    hist.merge(o.hist);
+  }
+};
+
+struct BatchBuffers {
+  std::vector<fp_word> a, b;
+  Results dut, ref;
+  explicit BatchBuffers(size_t n) : a(n), b(n), dut(n), ref(n) {}
+  size_t size() const { return a.size(); }
+};
+
+struct FailCase {
+  bool hung = false;  // fmul_pipe stopped handshaking, a/b not meaningful
+  fp_word a = 0;
+  fp_word b = 0;
+  uint64_t index = 0; // stream index of the vector (replay with --start)
+  bool directed = false; // coverage-directed vector, not replayable by index
+};
+
+// Optional hooks of one random stream
+struct StreamHooks {
+  FmulCoverage* cov = nullptr;
+  CovDirector* dir = nullptr;  // needs cov for feedback
+  bool until_full = false;     // end the stream once every bin is hit
+  VecFileWriter* rec = nullptr; // --record: checked vectors with reference results
+  FailLog* log = nullptr;       // --max-fails: log mismatches and go on
+  FailBudget* budget = nullptr; // needs log, shared by all streams
+  TraceWindow<fp_word>* win = nullptr; // --trace-window: waveform of the first mismatch
+};
+
+static bool run_random(Driver& d,
+                       const StimGen& gen,
+                       uint64_t first,
+                       uint64_t nvec,
+                       BatchBuffers& buf,
+                       RunStats& st,
+                       FailCase& fail,
+                       const StreamHooks& ch = StreamHooks(),
+                       const std::atomic<bool>* stop = nullptr) {
+  for (uint64_t done = 0; done < nvec; ) {
+    if (stop && stop->load(std::memory_order_relaxed)) return true;
+    if (ch.until_full && ch.cov->full()) return true;
+    if (ch.budget && ch.budget->exhausted()) return false;
+
+    size_t n = (size_t)std::min<uint64_t>(buf.size(), nvec - done);
+    const uint64_t t0 = bench_ns();
+    gen.fill(first + done, buf.a.data(), buf.b.data(), n);
+    if (ch.dir) ch.dir->steer(*ch.cov, buf.a.data(), buf.b.data(), n);
+    const uint64_t t1 = bench_ns();
+
+#ifdef FMUL_PIPE
+    uint64_t cycles0 = d.cycles;
+#endif
+    if (!run_batch(d, buf.a.data(), buf.b.data(), buf.dut.y.data(), buf.dut.flags.data(), n)) {
+      st.fails++;
+      fail.hung = true;
+      fail.index = first + done;
+      if (ch.win && !ch.win->dumped) {
+        ch.win->push(buf.a.data(), buf.b.data(), n);
+        dump_window(*ch.win, fail.index);
+        ch.win->dumped = true;
+      }
+      return false;
+    }
+#ifdef FMUL_PIPE
+    st.stream_tests += n;
+    st.stream_cycles += d.cycles - cycles0;
+#endif
+    st.stim_ns += t1 - t0;
+    st.dut_ns += bench_ns() - t1;
+
+    size_t bad = check_batch(buf.a.data(), buf.b.data(), buf.dut, buf.ref, n,
+                             BENCH ? &st.ref_ns : nullptr);
+
+    // Window up to and including the first mismatch, then the rest
+    if (ch.win) {
+      const size_t m = (bad < n) ? bad + 1 : n;
+      ch.win->push(buf.a.data(), buf.b.data(), m);
+      if (bad < n && !ch.win->dumped) {
+        dump_window(*ch.win, first + done + bad);
+        ch.win->dumped = true;
+      }
+      ch.win->push(buf.a.data() + m, buf.b.data() + m, n - m);
+    }
+
+    // Continue-on-fail: log every mismatch of the batch until the
+    // budget runs out, the checked prefix ends at the last one logged
+    if (ch.log && bad < n) {
+      bool more = true;
+      size_t last = bad;
+      for (size_t i = bad; i < n && more; ) {
+        FailRecord r;
+        r.a = buf.a[i];
+        r.b = buf.b[i];
+        r.y_dut = buf.dut.y[i];
+        r.f_dut = buf.dut.flags[i];
+        r.y_ref = buf.ref.y[i];
+        r.f_ref = buf.ref.flags[i];
+        r.index = first + done + i;
+        ch.log->add(r);
+        st.fails++;
+        more = ch.budget->take();
+        last = i;
+        i++;
+        i += first_mismatch(buf.dut.y.data() + i, buf.dut.flags.data() + i,
+                            buf.ref.y.data() + i, buf.ref.flags.data() + i, n - i, check_mask());
+      }
+      bad = more ? n : last;
+      if (!more) {
+        st.tests += bad + 1;
+        if (STATS) {
+          st.hist.sample(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(),
+                         bad + 1);
+        }
+        if (ch.cov) ch.cov->sample(buf.a.data(), buf.b.data(), bad + 1);
+        if (ch.rec) {
+          ch.rec->append(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(), bad + 1);
+        }
+        return false;
+      }
+    }
+
+    st.tests += (bad < n) ? bad + 1 : n;
+    if (STATS) {
+      st.hist.sample(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(),
+                     (bad < n) ? bad + 1 : n);
+    }
+    if (ch.cov) ch.cov->sample(buf.a.data(), buf.b.data(), (bad < n) ? bad + 1 : n);
+    if (ch.rec) {
+      ch.rec->append(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(),
+                     (bad < n) ? bad + 1 : n);
+    }
+    if (bad < n) {
+      st.fails++;
+      fail.a = buf.a[bad];
+      fail.b = buf.b[bad];
+      fail.index = first + done + bad;
+      fail.directed = ch.dir && bad % CovDirector::DIRECT_EVERY == CovDirector::DIRECT_EVERY - 1;
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------
+// Sharded regression (--jobs N)
+//
+// The stimulus stream is cut into shards of `chunk` vectors. Shard k
+// jumps the counter-based generator straight to vector start + k *
+// chunk, so every vector depends only on --seed and its index, never on
+// the thread count or on which thread happened to pick it up. Idle
+// threads take the next unclaimed shard from a shared counter, each
+// thread owns its own VerilatedContext and model.
+//
+// shard_seed() derives the per-thread back-pressure stall streams of
+// fmul_pipe.
+// -----------------------------------------------------------------
+#ifdef FMUL_PIPE
+static uint64_t shard_seed(uint64_t seed, uint64_t shard) {
+  // splitmix64 finalizer over (seed, shard)
+  uint64_t z = seed + (shard + 1) * 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+#endif
+
+// -----------------------------------------------------------------
+// Thread pool of drivers: unit indices [first, last) are handed out
+// from a shared counter to `jobs` threads, each with its own
+// VerilatedContext and model. fn(tid, driver, unit) returns false to
+// stop all threads.
+// -----------------------------------------------------------------
+template <typename Fn>
+static void run_pool(unsigned jobs, bool backpressure, uint64_t seed,
+                     uint64_t first, uint64_t last,
+                     std::atomic<bool>& stop, Fn fn) {
+  std::atomic<uint64_t> next_unit{first};
+
+  auto worker = [&](unsigned tid) {
+    std::unique_ptr<VerilatedContext> ctx(new VerilatedContext);
+    set_model_threads(*ctx);
+    Driver d;
+    d.dut = new Vfmul(ctx.get());
+#ifdef FMUL_PIPE
+    d.backpressure = backpressure;
+    d.stall_rng.seed(shard_seed(seed ^ 0x5DEECE66Dull, tid));
+    reset_pipe(d);
+#else
+    (void)backpressure;
+    (void)seed;
+#endif
+
+    while (!stop.load(std::memory_order_relaxed)) {
+      uint64_t u = next_unit.fetch_add(1, std::memory_order_relaxed);
+      if (u >= last) break;
+      if (!fn(tid, d, u)) {
+        stop.store(true, std::memory_order_relaxed);
+        break;
+      }
+    }
+
+#ifdef FMUL_STATS
+    if (!d.hung && !check_stats_csr(d)) STATS_CSR_FAILS++;
+#endif
+    d.dut->final();
+    delete d.dut;
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned j = 0; j < jobs; j++) pool.emplace_back(worker, j);
+  for (auto& th : pool) th.join();
+}
+
+struct ShardResult {
+  RunStats st;
+  uint64_t shards = 0;
+  bool failed = false;
+  uint64_t fail_shard = 0;
+  FailCase fail;
+  FmulCoverage cov;  // --coverage: this thread's vectors
+};
+
+static void run_sharded(unsigned jobs, const StimGen& gen, uint64_t seed,
+                        uint64_t start, uint64_t nvec, uint64_t chunk, size_t batch,
+                        bool backpressure, bool coverage, bool directed,
+                        std::vector<FailLog>* logs, FailBudget* budget,
+                        size_t trace_window, std::vector<ShardResult>& res) {
+  std::atomic<bool> stop{false};
+  std::vector<BatchBuffers> bufs(jobs, BatchBuffers(batch));
+  res.assign(jobs, ShardResult());
+
+  // Directed vectors follow each thread's own coverage, so with --jobs
+  // they depend on which shards the thread ran
+  std::vector<std::unique_ptr<CovDirector>> dirs(jobs);
+  std::vector<StreamHooks> hooks(jobs);
+  std::vector<std::unique_ptr<TraceWindow<fp_word>>> wins(jobs);
+  for (unsigned j = 0; j < jobs; j++) {
+    if (trace_window) {
+      wins[j].reset(new TraceWindow<fp_word>(trace_window));
+      hooks[j].win = wins[j].get();
+    }
+    if (logs) {
+      hooks[j].log = &(*logs)[j];
+      hooks[j].budget = budget;
+    }
+    if (!coverage) continue;
+    if (directed) dirs[j].reset(new CovDirector(seed, j));
+    hooks[j].cov = &res[j].cov;
+    hooks[j].dir = dirs[j].get();
+  }
+  const uint64_t nshards = (nvec + chunk - 1) / chunk;
+
+  run_pool(jobs, backpressure, seed, 0, nshards, stop,
+           [&](unsigned tid, Driver& d, uint64_t k) {
+    ShardResult& r = res[tid];
+    uint64_t n = std::min<uint64_t>(chunk, nvec - k * chunk);
+    FailCase fail;
+    r.shards++;
+    if (!run_random(d, gen, start + k * chunk, n, bufs[tid], r.st, fail, hooks[tid], &stop)) {
+      r.failed = true;
+      r.fail_shard = k;
+      r.fail = fail;
+      return false;
+    }
+    return true;
+  });
+}
+
 // -----------------------------------------------------------------
-// Random generator
+// Vector file replay (--replay)
+//
+// Every block of the mapped file is one work unit: its a/b columns
+// are driven and the DUT results compared with its y/flags columns in
+// place. Flags are compared only where the file has them
+// (flag_mask) and --check-flags is set.
 // -----------------------------------------------------------------
-static uint32_t rand_bits(std::mt19937_64& rng) {
-  std::uniform_int_distribution<uint32_t> dist(0, 0xFFFFFFFFu);
-  uint32_t r = dist(rng);
+static bool replay_block(Driver& d, const VecFileReader& vf, uint64_t k,
+                         Results& dut, RunStats& st, FailCase& fail) {
+  const VecBlock blk = vf.block(k);
+  const uint64_t first = k * vf.header().block;
+
+#ifdef FMUL_PIPE
+  uint64_t cycles0 = d.cycles;
+#endif
+  if (!run_batch(d, blk.a, blk.b, dut.y.data(), dut.flags.data(), blk.n)) {
+    st.fails++;
+    fail.hung = true;
+    fail.index = first;
+    return false;
+  }
+#ifdef FMUL_PIPE
+  st.stream_tests += blk.n;
+  st.stream_cycles += d.cycles - cycles0;
+#endif
+
+  const uint8_t mask = check_mask() & vf.header().flag_mask;
+  size_t bad = first_mismatch(dut.y.data(), dut.flags.data(), blk.y, blk.flags, blk.n, mask);
+  oracle_check(blk.a, blk.b, blk.y, blk.flags, blk.n, vf.header().flag_mask & FLAG_ALL);
+
+  if (PRINT_OK) {
+    std::lock_guard<std::mutex> lock(PRINT_MUTEX);
+    for (size_t i = 0; i < bad; i++) {
+      const RefOut o = dut.at(i);
+      const RefOut g = unpack_ref_flags(blk.y[i], blk.flags[i]);
+      print_case("PASS", "replay", blk.a[i], blk.b[i],
+                 o.y, o.invalid, o.overflow, o.underflow, o.inexact,
+                 g.y, g.invalid, g.overflow, g.underflow, g.inexact);
+    }
+  }
+
+  st.tests += (bad < blk.n) ? bad + 1 : blk.n;
+  if (bad < blk.n) {
+    st.fails++;
+    fail.a = blk.a[bad];
+    fail.b = blk.b[bad];
+    fail.index = first + bad;
+    return false;
+  }
+  return true;
+}
+
+// Verbose dump of a replay failure against the file's expected result
+static void print_replay_fail(Driver& d, const VecFileReader& vf, uint64_t index) {
+  const VecBlock blk = vf.block(index / vf.header().block);
+  const size_t i = (size_t)(index % vf.header().block);
+  fp_word y;
+  uint8_t flags;
+  if (!run_batch(d, &blk.a[i], &blk.b[i], &y, &flags, 1)) return;
+
+  const RefOut o = unpack_ref_flags(y, flags);
+  const RefOut g = unpack_ref_flags(blk.y[i], blk.flags[i]);
+  print_case("FAIL", "replay (verbose, REF = file)", blk.a[i], blk.b[i],
+             o.y, o.invalid, o.overflow, o.underflow, o.inexact,
+             g.y, g.invalid, g.overflow, g.underflow, g.inexact);
+
+  const RefOut r = ref_model(blk.a[i], blk.b[i], ROUND_MODE);
+  const uint8_t mask = check_mask() & vf.header().flag_mask;
+  const bool ref_agrees = r.y == g.y && ((pack_ref_flags(r) ^ blk.flags[i]) & mask) == 0;
+  std::printf("NOTE: built-in reference model %s the file for this vector.\n",
+              ref_agrees ? "agrees with" : "DISAGREES with");
+}
+
+// -----------------------------------------------------------------
+// Exhaustive tile sweep (--sweep)
+//
+// The tile [a_lo, a_hi] x [b_lo, b_hi] is enumerated row by row: a is
+// fixed per work unit and b runs over `chunk` consecutive values, so
+// every batch is one a against a contiguous run of b. Unit u covers
+// row u / units_per_row. Units finish out of order across threads;
+// the checkpoint stores the completed prefix only, so a resumed job
+// redoes at most the units that were in flight.
+//
+// Mismatches do not stop the sweep. The per-tile summary is one JSON
+// line with order-independent totals (vector count, failures, sum of a
+// hash of every DUT result), so a coordinator can merge tiles by
+// adding fields, and two sweeps of the same tile can be compared by
+// their dut_hash.
+// -----------------------------------------------------------------
+static const size_t SWEEP_MAX_FAILS = 16;  // failing pairs kept per tile
+
+struct SweepTile {
+  uint64_t a_lo = 0, a_hi = 0;
+  uint64_t b_lo = 0, b_hi = 0;
+  uint64_t chunk = 0;
+
+  uint64_t rows() const { return a_hi - a_lo + 1; }
+  uint64_t cols() const { return b_hi - b_lo + 1; }
+  uint64_t units_per_row() const { return (cols() + chunk - 1) / chunk; }
+  uint64_t units() const { return rows() * units_per_row(); }
+};
+
+struct SweepStats {
+  uint64_t tests = 0;
+  uint64_t fails = 0;
+  uint64_t dut_hash = 0;
+  std::vector<std::pair<fp_word, fp_word>> first_fails;
+
+  void merge(const SweepStats& o) {
+    tests += o.tests;
+    fails += o.fails;
+    dut_hash += o.dut_hash;
+    for (const auto& f : o.first_fails) {
+      if (first_fails.size() == SWEEP_MAX_FAILS) break;
+      first_fails.push_back(f);
+    }
+  }
+};
+
+static inline uint64_t splitmix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// splitmix64 of (a, b, y, flags); summed over the tile. Formats wider
+// than 32 bits hash a and y first so no operand bits are lost.
+static inline uint64_t result_hash(fp_word a, fp_word b, fp_word y, uint8_t flags) {
+  if (RefFmt::WIDTH > 32) {
+    return splitmix64(splitmix64(a) ^ b ^ ((splitmix64(y) << 4 | flags) * 0x9E3779B97F4A7C15ull));
+  }
+  return splitmix64((((uint64_t)a << 32) | b) ^ ((((uint64_t)y << 4) | flags) * 0x9E3779B97F4A7C15ull));
+}
+
+static bool sweep_unit(Driver& d, const SweepTile& tile, uint64_t u,
+                       BatchBuffers& buf, SweepStats& st) {
+  const uint64_t upr = tile.units_per_row();
+  const fp_word a = (fp_word)(tile.a_lo + u / upr);
+  const uint64_t b0 = (uint64_t)tile.b_lo + (u % upr) * tile.chunk;
+  const uint64_t b1 = std::min<uint64_t>(b0 + tile.chunk, (uint64_t)tile.b_hi + 1);
+
+  for (uint64_t bb = b0; bb < b1; ) {
+    size_t n = (size_t)std::min<uint64_t>(buf.size(), b1 - bb);
+    for (size_t i = 0; i < n; i++) {
+      buf.a[i] = a;
+      buf.b[i] = (fp_word)(bb + i);
+    }
+    if (!run_batch(d, buf.a.data(), buf.b.data(), buf.dut.y.data(), buf.dut.flags.data(), n)) return false;
+    KERNELS.ref_batch(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(), n);
+    oracle_check(buf.a.data(), buf.b.data(), buf.ref.y.data(), buf.ref.flags.data(), n);
+
+    for (size_t i = 0; i < n; i++) {
+      st.dut_hash += result_hash(buf.a[i], buf.b[i], buf.dut.y[i], buf.dut.flags[i]);
+    }
+
+    // Skip over matching runs with the vector compare
+    for (size_t i = 0; ; i++) {
+      i += first_mismatch(buf.dut.y.data() + i, buf.dut.flags.data() + i,
+                          buf.ref.y.data() + i, buf.ref.flags.data() + i, n - i, check_mask());
+      if (i >= n) break;
+      st.fails++;
+      if (st.first_fails.size() < SWEEP_MAX_FAILS) st.first_fails.emplace_back(buf.a[i], buf.b[i]);
+    }
+    st.tests += n;
+    bb += n;
+  }
+  return true;
+}
+
+// Completed-prefix tracker shared by the sweep threads
+class SweepProgress {
+ public:
+  SweepProgress(const SweepTile& tile, const std::string& ckpt_path, double ckpt_every_s)
+      : tile_(tile), path_(ckpt_path), every_s_(ckpt_every_s),
+        last_write_(std::chrono::steady_clock::now()) {}
+
+  uint64_t done_units() const { return done_; }
+  const SweepStats& stats() const { return st_; }
+
+  // Load a checkpoint written for the same tile. Returns false if the
+  // file exists but does not match.
+  bool load() {
+    if (path_.empty()) return true;
+    FILE* f = std::fopen(path_.c_str(), "r");
+    if (!f) return true;
+
+    unsigned long long a_lo, a_hi, b_lo, b_hi, chunk, done, tests, fails, hash;
+    int check_flags, rm;
+    bool ok = std::fscanf(f, "fmul_sweep_checkpoint 2 tile %llx %llx %llx %llx chunk %llu "
+                             "check_flags %d rm %d done %llu tests %llu fails %llu hash %llx",
+                          &a_lo, &a_hi, &b_lo, &b_hi, &chunk, &check_flags, &rm,
+                          &done, &tests, &fails, &hash) == 11 &&
+              a_lo == tile_.a_lo && a_hi == tile_.a_hi &&
+              b_lo == tile_.b_lo && b_hi == tile_.b_hi && chunk == tile_.chunk &&
+              (check_flags != 0) == CHECK_FLAGS && rm == ROUND_MODE && done <= tile_.units();
+
+    unsigned long long fa, fb;
+    while (ok && std::fscanf(f, " fail %llx %llx", &fa, &fb) == 2) {
+      st_.first_fails.emplace_back((fp_word)fa, (fp_word)fb);
+    }
+    std::fclose(f);
+    if (!ok) return false;
+
+    done_ = done;
+    st_.tests = tests;
+    st_.fails = fails;
+    st_.dut_hash = hash;
+    return true;
+  }
+
+  void complete(uint64_t u, SweepStats&& st) {
+    std::lock_guard<std::mutex> lock(mu_);
+    pending_.emplace(u, std::move(st));
+    while (!pending_.empty() && pending_.begin()->first == done_) {
+      st_.merge(pending_.begin()->second);
+      pending_.erase(pending_.begin());
+      done_++;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (!path_.empty() && std::chrono::duration<double>(now - last_write_).count() >= every_s_) {
+      write_locked();
+      last_write_ = now;
+    }
+  }
+
+  void write() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!path_.empty()) write_locked();
+  }
+
+ private:
+  // Write to a temp file and rename, so a kill mid-write keeps the old one
+  void write_locked() {
+    std::string tmp = path_ + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) {
+      std::printf("WARNING: cannot write checkpoint %s\n", tmp.c_str());
+      return;
+    }
+    std::fprintf(f, "fmul_sweep_checkpoint 2\ntile %0*llx %0*llx %0*llx %0*llx\nchunk %llu\n"
+                    "check_flags %d\nrm %d\ndone %llu\ntests %llu\nfails %llu\nhash %016llx\n",
+                 HEX_W, (unsigned long long)tile_.a_lo, HEX_W, (unsigned long long)tile_.a_hi,
+                 HEX_W, (unsigned long long)tile_.b_lo, HEX_W, (unsigned long long)tile_.b_hi,
+                 (unsigned long long)tile_.chunk, CHECK_FLAGS ? 1 : 0, ROUND_MODE,
+                 (unsigned long long)done_,
+                 (unsigned long long)st_.tests, (unsigned long long)st_.fails,
+                 (unsigned long long)st_.dut_hash);
+    for (const auto& fl : st_.first_fails) {
+      std::fprintf(f, "fail %0*llx %0*llx\n", HEX_W, (unsigned long long)fl.first,
+                   HEX_W, (unsigned long long)fl.second);
+    }
+    std::fclose(f);
+    std::rename(tmp.c_str(), path_.c_str());
+  }
+
+  SweepTile tile_;
+  std::string path_;
+  double every_s_;
+  std::chrono::steady_clock::time_point last_write_;
+
+  std::mutex mu_;
+  uint64_t done_ = 0;
+  SweepStats st_;
+  std::map<uint64_t, SweepStats> pending_;
+};
+
+static bool parse_tile(const char* spec, SweepTile& tile) {
+  // a_lo:a_hi:b_lo:b_hi, decimal or 0x-prefixed hex, values of the format
+  unsigned long long v[4];
+  const char* p = spec;
+  for (int i = 0; i < 4; i++) {
+    char* end = nullptr;
+    v[i] = std::strtoull(p, &end, 0);
+    if (end == p || v[i] > RefFmt::MASK) return false;
+    if (i < 3 && *end != ':') return false;
+    if (i == 3 && *end != '\0') return false;
+    p = end + 1;
+  }
+  tile.a_lo = v[0];
+  tile.a_hi = v[1];
+  tile.b_lo = v[2];
+  tile.b_hi = v[3];
+  // hi + 1 must not wrap (binary64 bounds)
+  return tile.a_lo <= tile.a_hi && tile.b_lo <= tile.b_hi &&
+         tile.a_hi != ~0ull && tile.b_hi != ~0ull;
+}
+
+// Set from SIGINT/SIGTERM so a pre-empted sweep writes its checkpoint
+static std::atomic<bool> SWEEP_STOP{false};
+
+static void sweep_signal(int) { SWEEP_STOP.store(true); }
+
+static void write_sweep_summary(const std::string& path, const SweepTile& tile,
+                                const SweepStats& st, bool complete, double seconds) {
+  FILE* f = path.empty() ? stdout : std::fopen(path.c_str(), "a");
+  if (!f) {
+    std::printf("WARNING: cannot open summary file %s\n", path.c_str());
+    f = stdout;
+  }
+  std::fprintf(f, "{\"tile\":[\"0x%0*llx\",\"0x%0*llx\",\"0x%0*llx\",\"0x%0*llx\"],"
+                  "\"complete\":%s,\"check_flags\":%s,\"rm\":\"%s\",\"vectors\":%llu,\"fails\":%llu,"
+                  "\"dut_hash\":\"0x%016llx\",\"seconds\":%.3f,\"first_fails\":[",
+               HEX_W, (unsigned long long)tile.a_lo, HEX_W, (unsigned long long)tile.a_hi,
+               HEX_W, (unsigned long long)tile.b_lo, HEX_W, (unsigned long long)tile.b_hi,
+               complete ? "true" : "false", CHECK_FLAGS ? "true" : "false", ref_rm_name(ROUND_MODE),
+               (unsigned long long)st.tests, (unsigned long long)st.fails,
+               (unsigned long long)st.dut_hash, seconds);
+  for (size_t i = 0; i < st.first_fails.size(); i++) {
+    std::fprintf(f, "%s[\"0x%0*llx\",\"0x%0*llx\"]", i ? "," : "",
+                 HEX_W, (unsigned long long)st.first_fails[i].first,
+                 HEX_W, (unsigned long long)st.first_fails[i].second);
+  }
+  std::fprintf(f, "]}\n");
+  if (f != stdout) std::fclose(f);
+}
+
+// -----------------------------------------------------------------
+// --bench report: one JSON line per run. Phase times are summed over
+// the threads, so with --jobs the ns/vector figures are per-thread cost
+// and vectors_per_s is the aggregate rate.
+// -----------------------------------------------------------------
+struct BenchConfig {
+  std::string path;   // "-" for stdout
+  std::string label;  // build configuration, set by bench_verilator.sh
+  size_t batch = 0;
+  unsigned jobs = 0;
+  bool trace = false;
+  size_t trace_window = 0;
+};
+
+static const char* bench_dut_name() {
+#if defined(FMUL_VEC)
+  return "fmul_vec";
+#elif defined(FMUL_PIPE)
+  return "fmul_pipe";
+#else
+  return "fmul";
+#endif
+}
+
+// String value for a JSON line, quotes and backslashes escaped
+static std::string json_escape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out;
+}
+
+// Peak resident set of the process in KiB (ru_maxrss is KiB on Linux)
+static long bench_peak_rss_kb() {
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+  return ru.ru_maxrss;
+}
+
+static void write_bench(const BenchConfig& bc, const RunStats& st, double seconds) {
+  const double n = st.tests ? (double)st.tests : 1.0;
+  const double vps = seconds > 0 ? (double)st.tests / seconds : 0.0;
+  const long rss = bench_peak_rss_kb();
+  const bool simd = REF_BATCH_SIMD;
+
+  const double oracle_ns = (double)ORACLE_ST.ns.load() / n;
+
+  std::printf("Bench     : %.3e vectors/s, DUT %.1f ns/vector, ref %.1f ns/vector, "
+              "stimulus %.1f ns/vector, peak RSS %ld KiB\n",
+              vps, (double)st.dut_ns / n, (double)st.ref_ns / n, (double)st.stim_ns / n, rss);
+  if (ORACLE != Oracle::None) {
+    std::printf("Bench     : oracle %s %.1f ns/vector\n", oracle_name(ORACLE), oracle_ns);
+  }
+
+  FILE* f = bc.path == "-" ? stdout : std::fopen(bc.path.c_str(), "a");
+  if (!f) {
+    std::printf("WARNING: cannot open bench file %s\n", bc.path.c_str());
+    f = stdout;
+  }
+  const std::string label = json_escape(bc.label);
+  std::fprintf(f, "{\"bench\":\"tb_fmul\",\"label\":\"%s\",\"time\":%lld,\"dut\":\"%s\","
+                  "\"lanes\":%zu,\"exp\":%d,\"mant\":%d,\"rm\":\"%s\",\"subnormal\":%s,"
+                  "\"batch\":%zu,\"jobs\":%u,\"model_threads\":%u,\"trace\":%s,\"trace_window\":%zu,\"check_flags\":%s,\"ref_isa\":\"%s\","
+                  "\"vectors\":%llu,\"fails\":%llu,\"seconds\":%.6f,\"vectors_per_s\":%.1f,"
+                  "\"dut_ns_per_vector\":%.3f,\"ref_ns_per_vector\":%.3f,"
+                  "\"stim_ns_per_vector\":%.3f,\"oracle\":\"%s\",\"oracle_ns_per_vector\":%.3f,"
+                  "\"peak_rss_kb\":%ld}\n",
+               label.c_str(), (long long)std::time(nullptr), bench_dut_name(), LANES,
+               REF_EXP, REF_MANT, ref_rm_name(ROUND_MODE), REF_SUBNORMAL ? "true" : "false",
+               bc.batch, bc.jobs ? bc.jobs : 1u, MODEL_THREADS, bc.trace ? "true" : "false", bc.trace_window,
+               CHECK_FLAGS ? "true" : "false", ref_isa_name(simd ? REF_ISA : RefIsa::Scalar),
+               (unsigned long long)st.tests, (unsigned long long)st.fails, seconds, vps,
+               (double)st.dut_ns / n, (double)st.ref_ns / n, (double)st.stim_ns / n,
+               oracle_name(ORACLE), oracle_ns, rss);
+  if (f != stdout) std::fclose(f);
+}
+
+// -----------------------------------------------------------------
+// Regression database (--db DIR), see fmul_regdb.h
+//
+// The minimized failures of earlier runs with this format, rounding
+// mode and subnormal handling are driven before anything else, so a
+// regression shows up within the first vectors. Every failing pair the
+// run finds is shrunk on the main model and merged into that corpus,
+// and one JSON line per run goes to DIR/runs.jsonl.
+// -----------------------------------------------------------------
+static const size_t REGDB_MAX_DUMPS = 8;    // corpus failures dumped
+static const size_t REGDB_MAX_SHRINK = 16;  // failing pairs minimized per run
+
+struct RegDbRun {
+  std::string dir;
+  std::string label;          // --db-label, run_verilator.sh passes the build directory
+  const char* mode = "random";
+  std::string source;         // --sweep tile or --replay file
+  uint64_t seed = 0;
+  uint64_t start = 0, n = 0;  // random: stream indices [start, start + n)
+  unsigned jobs = 0;
+  uint64_t tests = 0, fails = 0;
+  double seconds = 0;
+  uint64_t corpus_vectors = 0, corpus_fails = 0;
+  long corpus_added = 0;
+  const FmulCoverage* cov = nullptr;  // random runs
+  std::vector<RegPair> found, minimized;
+};
+
+// Drives the corpus, returns false if the DUT hung; failing pairs are
+// appended to `failing`
+static bool corpus_replay(Driver& d, const std::vector<RegPair>& pairs, RunStats& st,
+                          std::vector<RegPair>& failing) {
+  const size_t n = pairs.size();
+  std::vector<fp_word> a(n), b(n);
+  Results dut(n), ref(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = pairs[i].first;
+    b[i] = pairs[i].second;
+  }
+  if (!run_batch(d, a.data(), b.data(), dut.y.data(), dut.flags.data(), n)) {
+    st.fails++;
+    return false;
+  }
+  KERNELS.ref_batch(a.data(), b.data(), ref.y.data(), ref.flags.data(), n);
+  oracle_check(a.data(), b.data(), ref.y.data(), ref.flags.data(), n);
+
+  for (size_t i = 0; ; i++) {
+    i += first_mismatch(dut.y.data() + i, dut.flags.data() + i, ref.y.data() + i,
+                        ref.flags.data() + i, n - i, check_mask());
+    if (i >= n) break;
+    if (failing.size() < REGDB_MAX_DUMPS) {
+      char tag[48];
+      std::snprintf(tag, sizeof tag, "corpus entry %zu", i);
+      const RefOut o = dut.at(i);
+      const RefOut r = ref.at(i);
+      print_case("FAIL", tag, a[i], b[i],
+                 o.y, o.invalid, o.overflow, o.underflow, o.inexact,
+                 r.y, r.invalid, r.overflow, r.underflow, r.inexact);
+    }
+    failing.push_back(pairs[i]);
+    st.fails++;
+  }
+  st.tests += n;
+  return true;
+}
+
+// Minimizes a failing pair on the main model; false if it does not fail
+// against the built-in reference (a --replay file may disagree with it)
+static bool regdb_shrink(Driver& d, const RegPair& p, RegPair& out) {
+  Results dut(0), ref(0);
+  auto eval = [&](const fp_word* a, const fp_word* b, uint8_t* sig, size_t n) {
+    if (dut.y.size() < n) {
+      dut = Results(n);
+      ref = Results(n);
+    }
+    if (!run_batch(d, a, b, dut.y.data(), dut.flags.data(), n)) return false;
+    KERNELS.ref_batch(a, b, ref.y.data(), ref.flags.data(), n);
+    for (size_t i = 0; i < n; i++) {
+      sig[i] = regdb_fail_sig(dut.y[i], dut.flags[i], ref.y[i], ref.flags[i], check_mask());
+    }
+    return true;
+  };
+  uint8_t sig = 0;
+  if (!eval(&p.first, &p.second, &sig, 1) || !sig) return false;
+  out = shrink_failure(p, sig, eval);
+  return true;
+}
 
-  std::uniform_int_distribution<int> sel(0, 11);
-  switch (sel(rng)) {
-    case 0: return 0x00000000u; // +0
-    case 1: return 0x80000000u; // -0
-    case 2: return 0x7F800000u; // +Inf
-    case 3: return 0xFF800000u; // -Inf
-    case 4: return 0x7FC00001u; // NaN
-    case 5: return (r & 0x807FFFFFu); // exp=0 (subnormal/zero)
-    case 6: return (r & 0x807FFFFFu) | (1u << 23); // exp=1
-    case 7: return (r & 0x807FFFFFu) | (254u << 23); // exp=254
-    default: return r;
+static void write_regdb_run(const RegDbRun& r) {
+  const std::string path = r.dir + "/runs.jsonl";
+  FILE* f = std::fopen(path.c_str(), "a");
+  if (!f) {
+    std::printf("WARNING: cannot open run database %s\n", path.c_str());
+    return;
   }
+  std::fprintf(f, "{\"run\":\"tb_fmul\",\"label\":\"%s\",\"time\":%lld,\"dut\":\"%s\",\"lanes\":%zu,"
+                  "\"exp\":%d,\"mant\":%d,\"bias\":%d,\"rm\":\"%s\",\"subnormal\":%s,\"check_flags\":%s,"
+                  "\"ref_isa\":\"%s\",\"oracle\":\"%s\",\"mode\":\"%s\",\"source\":\"%s\","
+                  "\"seed\":%llu,\"stream\":[%llu,%llu],\"jobs\":%u,\"model_threads\":%u,"
+                  "\"vectors\":%llu,\"fails\":%llu,\"seconds\":%.6f,\"vectors_per_s\":%.1f,"
+                  "\"corpus\":{\"vectors\":%llu,\"fails\":%llu,\"added\":%ld},\"coverage\":",
+               json_escape(r.label).c_str(), (long long)std::time(nullptr), bench_dut_name(), LANES,
+               REF_EXP, REF_MANT, REF_BIAS, ref_rm_name(ROUND_MODE), REF_SUBNORMAL ? "true" : "false",
+               CHECK_FLAGS ? "true" : "false",
+               ref_isa_name(REF_BATCH_SIMD ? REF_ISA : RefIsa::Scalar), oracle_name(ORACLE),
+               r.mode, json_escape(r.source).c_str(), (unsigned long long)r.seed,
+               (unsigned long long)r.start, (unsigned long long)(r.start + r.n),
+               r.jobs ? r.jobs : 1u, MODEL_THREADS, (unsigned long long)r.tests,
+               (unsigned long long)r.fails, r.seconds,
+               r.seconds > 0 ? (double)r.tests / r.seconds : 0.0,
+               (unsigned long long)r.corpus_vectors, (unsigned long long)r.corpus_fails,
+               r.corpus_added);
+  if (r.cov) {
+    std::fprintf(f, "{\"vectors\":%llu,\"covered\":%d,\"hits\":[",
+                 (unsigned long long)r.cov->vectors, r.cov->covered);
+    for (int k = 0; k < COV_NBINS; k++) {
+      std::fprintf(f, "%s%llu", k ? "," : "", (unsigned long long)r.cov->hits[k]);
+    }
+    std::fprintf(f, "]}");
+  } else {
+    std::fprintf(f, "null");
+  }
+  std::fprintf(f, ",\"fail_vectors\":[");
+  for (size_t i = 0; i < r.found.size(); i++) {
+    std::fprintf(f, "%s[\"0x%0*llx\",\"0x%0*llx\",\"0x%0*llx\",\"0x%0*llx\"]", i ? "," : "",
+                 HEX_W, (unsigned long long)r.found[i].first,
+                 HEX_W, (unsigned long long)r.found[i].second,
+                 HEX_W, (unsigned long long)r.minimized[i].first,
+                 HEX_W, (unsigned long long)r.minimized[i].second);
+  }
+  std::fprintf(f, "]}\n");
+  std::fclose(f);
 }
 
 int main(int argc, char** argv) {
   Verilated::commandArgs(argc, argv);
 
   bool do_trace = false;
+  size_t trace_window = 0;   // --trace-window K, 0: off
   uint64_t nrand = 200000;
   uint64_t seed  = 0xC001D00Du;
+  size_t batch   = 4096;
+  unsigned jobs  = 0;        // 0: single serial random stream
+  uint64_t chunk = 65536;
+  bool backpressure = false;
+  const char* sweep_spec = nullptr;
+  bool exhaustive = false;
+  std::string ckpt_path, summary_path;
+  double ckpt_every = 60.0;
+  uint64_t start = 0;        // first stimulus stream index
+  std::string replay_path, record_path;
+  bool log_fails = false;     // --max-fails given
+  uint64_t max_fails = 1;
+  bool coverage = false;
+  bool cov_directed = false;
+  bool until_covered = false;
+  StimWeights weights;
+  BenchConfig bench;
+  RegDbRun db;
 
   // Args:
   //  --n <N>           random tests
-  //  --trace           enable wave.vcd
+  //  --rm <M>          rounding mode: rne (default), rtz, rdn, rup, rmm
+  //  --trace           enable wave.vcd (wave.fst in an FST build)
+  //  --trace-window <K>  keep the last K vectors of each random stream and write
+  //                    wave_fail_<index>.<vcd|fst> for its first mismatch only
   //  --print-ok        print PASS cases too
   //  --check-flags     check invalid/overflow/underflow/inexact
-  //  --seed <S>        RNG seed
+  //  --seed <S>        stimulus stream seed
+  //  --start <I>       first stimulus stream index (replays from vector I)
+  //  --stim-weights <W0,...,W8>
+  //                    class weights: +0,-0,+inf,-inf,nan,exp0,exp1,exp254,uniform
+  //  --coverage        sample functional coverage of the random vectors (fmul_cov.h)
+  //  --cov-directed    also steer half of every batch at the least-hit bins
+  //  --until-covered   stop the random run at full coverage (--n is the cap, serial only)
+  //  --batch <B>       vectors per driver/check batch
+  //  --jobs <J>        sharded run on J threads (0 = all hardware threads)
+  //  --chunk <C>       vectors per shard with --jobs
+  //  --backpressure    fmul_pipe only: random input bubbles and out_ready stalls
+  //  --ref-isa <I>     batched reference kernel: scalar, avx2, avx512 (default: best supported)
+  //  --oracle <O>      also check every reference batch against an independent model:
+  //                    host (host FPU) or softfloat (SoftFloat build, fmul_oracle.h)
+  //  --sweep <A_LO:A_HI:B_LO:B_HI>
+  //                    exhaustive sweep of the tile instead of random tests
+  //  --checkpoint <F>  sweep progress file, resumed from when it exists
+  //  --checkpoint-every <S>  seconds between checkpoint writes (default 60)
+  //  --summary <F>     append the sweep summary JSON line to F (default stdout)
+  //  --exhaustive      sweep every operand pair (formats of at most 16 bits),
+  //                    --jobs defaults to all hardware threads
+  //  --max-fails <K>   random tests go on after a mismatch until K failing vectors
+  //                    (0 = no limit), one verbose dump per failure class at the end
+  //  --replay <F>      check the DUT against vector file F instead of random tests
+  //  --record <F>      write the random vectors and reference results to F (serial run)
+  //  --bench <F>       time the random run, append the JSON report line to F (- = stdout)
+  //  --bench-label <S> free-form label stored in the report (build options, revision)
+  //  --stats           histogram of the checked random vectors over the fmul_stats counters
+  //  --db <DIR>        regression database: replay DIR's corpus of minimized failures first,
+  //                    add this run's failures to it, append the run to DIR/runs.jsonl
+  //  --db-label <S>    free-form label stored in the run record (build configuration)
   for (int i = 1; i < argc; i++) {
     std::string arg = argv[i];
     if (arg == "--trace") do_trace = true;
+    else if (arg == "--trace-window" && i + 1 < argc) trace_window = std::strtoull(argv[++i], nullptr, 10);
     else if (arg == "--print-ok") PRINT_OK = true;
     else if (arg == "--check-flags") CHECK_FLAGS = true;
+    else if (arg == "--backpressure") backpressure = true;
+    else if (arg == "--coverage") coverage = true;
+    else if (arg == "--stats") STATS = true;
+    else if (arg == "--cov-directed") coverage = cov_directed = true;
+    else if (arg == "--until-covered") coverage = until_covered = true;
     else if (arg == "--n" && i + 1 < argc) nrand = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--rm" && i + 1 < argc) {
+      std::string rm = argv[++i];
+      ROUND_MODE = -1;
+      for (int m = RM_RNE; m <= RM_RMM; m++) {
+        if (rm == ref_rm_name(m)) ROUND_MODE = m;
+      }
+      if (ROUND_MODE < 0) {
+        std::printf("ERROR: bad --rm '%s', expected rne, rtz, rdn, rup or rmm\n", rm.c_str());
+        return 2;
+      }
+    }
     else if (arg == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--start" && i + 1 < argc) start = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--stim-weights" && i + 1 < argc) {
+      if (!weights.parse(argv[++i])) {
+        std::printf("ERROR: bad --stim-weights '%s', expected %d comma-separated weights\n",
+                    argv[i], (int)STIM_NCLASS);
+        return 2;
+      }
+    }
+    else if (arg == "--batch" && i + 1 < argc) batch = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--chunk" && i + 1 < argc) chunk = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--sweep" && i + 1 < argc) sweep_spec = argv[++i];
+    else if (arg == "--exhaustive") exhaustive = true;
+    else if (arg == "--checkpoint" && i + 1 < argc) ckpt_path = argv[++i];
+    else if (arg == "--checkpoint-every" && i + 1 < argc) ckpt_every = std::strtod(argv[++i], nullptr);
+    else if (arg == "--summary" && i + 1 < argc) summary_path = argv[++i];
+    else if (arg == "--max-fails" && i + 1 < argc) {
+      max_fails = std::strtoull(argv[++i], nullptr, 10);
+      log_fails = true;
+    }
+    else if (arg == "--replay" && i + 1 < argc) replay_path = argv[++i];
+    else if (arg == "--record" && i + 1 < argc) record_path = argv[++i];
+    else if (arg == "--bench" && i + 1 < argc) {
+      bench.path = argv[++i];
+      BENCH = true;
+    }
+    else if (arg == "--bench-label" && i + 1 < argc) bench.label = argv[++i];
+    else if (arg == "--db" && i + 1 < argc) db.dir = argv[++i];
+    else if (arg == "--db-label" && i + 1 < argc) db.label = argv[++i];
+    else if (arg == "--ref-isa" && i + 1 < argc) {
+      std::string isa = argv[++i];
+      RefIsa want = isa == "avx512" ? RefIsa::Avx512 : isa == "avx2" ? RefIsa::Avx2 : RefIsa::Scalar;
+      if ((int)want > (int)ref_isa_best()) {
+        std::printf("NOTE: --ref-isa %s not supported on this host, using %s\n",
+                    isa.c_str(), ref_isa_name(ref_isa_best()));
+        want = ref_isa_best();
+      }
+      REF_ISA = want;
+    }
+    else if (arg == "--oracle" && i + 1 < argc) {
+      if (!oracle_parse(argv[++i], ORACLE)) {
+        std::printf("ERROR: bad --oracle '%s', expected host, softfloat or none\n", argv[i]);
+        return 2;
+      }
+    }
+    else if (arg == "--jobs" && i + 1 < argc) {
+      jobs = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+      if (jobs == 0) jobs = all_core_jobs();
+    }
+  }
+  if (batch == 0) batch = 1;
+
+  // --exhaustive: the whole operand space as one sweep tile
+  char full_tile[64];
+  if (exhaustive) {
+    if (sweep_spec) {
+      std::printf("ERROR: --exhaustive and --sweep are exclusive\n");
+      return 2;
+    }
+    if (RefFmt::WIDTH > 16) {
+      std::printf("ERROR: --exhaustive needs a format of at most 16 bits, this build is %d bits\n",
+                  RefFmt::WIDTH);
+      return 2;
+    }
+    std::snprintf(full_tile, sizeof full_tile, "0:0x%llx:0:0x%llx",
+                  (unsigned long long)RefFmt::MASK, (unsigned long long)RefFmt::MASK);
+    sweep_spec = full_tile;
+    if (!jobs) jobs = all_core_jobs();
+  }
+  // Verilator workers spin while they wait for their mtasks, so more
+  // threads than the host has slow every model down
+  const unsigned hw_threads = std::thread::hardware_concurrency();
+  if (hw_threads && std::max(1u, jobs) * MODEL_THREADS > hw_threads) {
+    std::printf("NOTE: %u model%s x %u model threads oversubscribe %u hardware threads\n",
+                std::max(1u, jobs), jobs > 1 ? "s" : "", MODEL_THREADS, hw_threads);
+  }
+  if (until_covered && jobs) {
+    std::printf("NOTE: --until-covered needs a serial run, ignored with --jobs.\n");
+    until_covered = false;
+  }
+  if (chunk == 0) chunk = 1;
+
+  if (BENCH && (sweep_spec || !replay_path.empty())) {
+    std::printf("ERROR: --bench times random runs only (no --sweep/--exhaustive/--replay)\n");
+    return 2;
+  }
+  if (STATS && (sweep_spec || !replay_path.empty())) {
+    std::printf("ERROR: --stats counts random runs only (no --sweep/--exhaustive/--replay)\n");
+    return 2;
   }
 
-  auto* dut = new Vfmul;
+  if (!FMUL_TRACE && (do_trace || trace_window)) {
+    std::printf("NOTE: built without tracing (FMUL_TRACE=0), --trace/--trace-window ignored.\n");
+    do_trace = false;
+    trace_window = 0;
+  }
+  if (trace_window && (sweep_spec || !replay_path.empty())) {
+    std::printf("NOTE: --trace-window applies to random runs only, ignored.\n");
+    trace_window = 0;
+  }
+  if ((jobs || sweep_spec) && do_trace) {
+    std::printf("NOTE: --trace is not supported with --jobs/--sweep, tracing disabled.\n");
+    do_trace = false;
+  }
 
-  VerilatedVcdC* tfp = nullptr;
-  vluint64_t t = 0;
+  VecFileReader replay;
+  if (!replay_path.empty()) {
+    std::string err;
+    if (!replay.open(replay_path, err)) {
+      std::printf("ERROR: %s\n", err.c_str());
+      return 2;
+    }
+    const VecFileHeader& h = replay.header();
+    if (h.exp != REF_EXP || h.mant != REF_MANT || h.bias != REF_BIAS) {
+      std::printf("ERROR: %s holds EXP=%d MANT=%d BIAS=%d vectors, DUT is EXP=%d MANT=%d BIAS=%d\n",
+                  replay_path.c_str(), h.exp, h.mant, h.bias, REF_EXP, REF_MANT, REF_BIAS);
+      return 2;
+    }
+    if (h.subnormal != (REF_SUBNORMAL ? VECFILE_SUBNORMAL_GRADUAL : VECFILE_SUBNORMAL_FTZ)) {
+      std::printf("ERROR: %s holds %s results, DUT is built for %s\n", replay_path.c_str(),
+                  h.subnormal ? "gradual underflow" : "DAZ/FTZ",
+                  REF_SUBNORMAL ? "gradual underflow" : "DAZ/FTZ");
+      return 2;
+    }
+    if (h.rounding > VECFILE_RM_RMM) {
+      std::printf("ERROR: %s uses unknown rounding mode %d\n", replay_path.c_str(), h.rounding);
+      return 2;
+    }
+    // The file's expected results are for its rounding mode
+    if (h.rounding != ROUND_MODE) {
+      std::printf("NOTE: %s was recorded with --rm %s, replaying in that mode\n",
+                  replay_path.c_str(), ref_rm_name(h.rounding));
+      ROUND_MODE = h.rounding;
+    }
+  }
+
+  VecFileWriter record;
+  if (!record_path.empty()) {
+    std::string err;
+    if (jobs || sweep_spec || !replay_path.empty()) {
+      std::printf("ERROR: --record needs a serial random run (no --jobs/--sweep/--replay)\n");
+      return 2;
+    }
+    if (!record.open(record_path, nrand, REF_EXP, REF_MANT, REF_BIAS, (uint8_t)ROUND_MODE,
+                     REF_SUBNORMAL ? VECFILE_SUBNORMAL_GRADUAL : VECFILE_SUBNORMAL_FTZ,
+                     FLAG_ALL, err)) {
+      std::printf("ERROR: %s\n", err.c_str());
+      return 2;
+    }
+  }
+
+  if (!db.dir.empty()) {
+    std::string err;
+    if (!regdb_open_dir(db.dir, err)) {
+      std::printf("ERROR: %s\n", err.c_str());
+      return 2;
+    }
+  }
+
+  SweepTile tile;
+  if (sweep_spec) {
+    if (!parse_tile(sweep_spec, tile)) {
+      std::printf("ERROR: bad --sweep tile '%s', expected A_LO:A_HI:B_LO:B_HI\n", sweep_spec);
+      return 2;
+    }
+    tile.chunk = chunk;
+    if ((unsigned __int128)tile.rows() * tile.units_per_row() > ~0ull) {
+      std::printf("ERROR: tile has more than 2^64 work units, raise --chunk\n");
+      return 2;
+    }
+  }
 
+  // After --replay has fixed the rounding mode
+  if (ORACLE != Oracle::None) {
+    if (const char* why = oracle_unsupported<RefFmt>(ORACLE, ROUND_MODE, REF_SUBNORMAL)) {
+      std::printf("NOTE: --oracle %s cannot check this configuration (%s), disabled.\n",
+                  oracle_name(ORACLE), why);
+      ORACLE = Oracle::None;
+    }
+  }
+
+  select_kernels();
+
+  Driver d;
+  d.dut = new Vfmul;
+
+#if FMUL_TRACE
   if (do_trace) {
+    char path[32];
+    std::snprintf(path, sizeof path, "wave.%s", TRACE_EXT);
     Verilated::traceEverOn(true);
-    tfp = new VerilatedVcdC;
-    dut->trace(tfp, 99);
-    tfp->open("wave.vcd");
+    d.tfp = new TraceFile;
+    d.dut->trace(d.tfp, 99);
+    d.tfp->open(path);
   }
+#endif
 
-  uint64_t tests = 0, fails = 0;
+#ifdef FMUL_PIPE
+  d.backpressure = backpressure;
+  d.stall_rng.seed(seed ^ 0x5DEECE66Dull);
+  reset_pipe(d);
+#else
+  (void)backpressure;
+#endif
 
-  auto check = [&](uint32_t a, uint32_t b, const char* tag, bool verbose_on_fail) {
+  uint64_t tests = 0, fails = 0;
+  uint64_t sweep_vectors = 0;  // --sweep: vectors checked by this run (not resumed ones)
+  double sweep_secs = 0;
+  bool incomplete = false;  // interrupted --sweep: exit 3 so it is not taken as a pass
+  RunStats st;              // random tests
+  FmulCoverage cov;         // random tests, --coverage or --db
+  const bool sample_cov = coverage || !db.dir.empty();
+
+  auto check = [&](fp_word a, fp_word b, const char* tag, bool verbose_on_fail) {
     tests++;
-    bool ok = run_one(dut, tfp, t, a, b, tag, verbose_on_fail);
+    bool ok = run_one(d, a, b, tag, verbose_on_fail);
     if (!ok) fails++;
   };
 
-  // Directed tests
-  check(0x7F800000u, 0x00000000u, "Inf*0", true);
-  check(0x7FC00001u, 0x3F800000u, "NaN*1", true);
-  check(0x00000001u, 0x3F800000u, "subnormal input DAZ", true);
-  check(0x00800000u, 0x3F000000u, "min_norm*0.5 => FTZ", true);
-  check(0x7F7FFFFFu, 0x40000000u, "max_finite*2 => overflow", true);
-
-  // Random tests
-  std::mt19937_64 rng(seed);
-  for (uint64_t i = 0; i < nrand; i++) {
-    uint32_t a = rand_bits(rng);
-    uint32_t b = rand_bits(rng);
-    tests++;
-    bool ok = run_one(dut, tfp, t, a, b, "rand", /*verbose_on_fail=*/false);
-    if (!ok) {
-      fails++;
+  // Directed tests, values of the build format (0x3F800000 = 1.0 in binary32)
+  auto pow2 = [](int e) { return (fp_word)((uint64_t)(e + REF_BIAS) << REF_MANT); };
+  const fp_word min_norm   = pow2(1 - REF_BIAS);
+  const fp_word max_finite = (fp_word)(RefFmt::INF - 1u);
+  check(RefFmt::INF, 0, "Inf*0", true);
+  check((fp_word)(RefFmt::QNAN | 1u), pow2(0), "NaN*1", true);
+  check(1, pow2(0), REF_SUBNORMAL ? "min_subnormal*1" : "subnormal input DAZ", true);
+  check(min_norm, pow2(-1), REF_SUBNORMAL ? "min_norm*0.5 => subnormal" : "min_norm*0.5 => FTZ", true);
+  if (REF_SUBNORMAL) {
+    check(1, pow2(-1), "min_subnormal*0.5 => underflow", true);
+    check((fp_word)(min_norm - 1u), pow2(REF_MANT), "max_subnormal*2^MANT => normal", true);
+  }
+  check(max_finite, pow2(1), "max_finite*2 => overflow", true);
+
+  // --db: earlier failures first. Without --max-fails a failing entry
+  // ends the run like any other first failure.
+  const auto run_t0 = std::chrono::steady_clock::now();
+  const std::string corpus_path = db.dir.empty() ? "" : regdb_corpus_path(db.dir, ROUND_MODE);
+  bool corpus_stop = false;
+  if (!db.dir.empty()) {
+    std::vector<RegPair> corpus;
+    std::string err;
+    if (!regdb_load_corpus(corpus_path, corpus, err)) {
+      std::printf("WARNING: %s, corpus not replayed\n", err.c_str());
+      corpus.clear();
+    }
+    if (!corpus.empty()) {
+      RunStats cst;
+      std::vector<RegPair> bad;
+      const bool hung = !corpus_replay(d, corpus, cst, bad);
+      std::printf("Corpus    : %s, %zu vectors, %zu failing%s\n", corpus_path.c_str(),
+                  corpus.size(), bad.size(), hung ? ", DUT hung" : "");
+      tests += cst.tests;
+      fails += cst.fails;
+      db.corpus_vectors = corpus.size();
+      db.corpus_fails = cst.fails;
+      db.found = bad;
+      corpus_stop = hung || (!bad.empty() && !log_fails);
+      if (corpus_stop && !hung) {
+        std::printf("First failing vector: corpus entry, a=0x%0*llx b=0x%0*llx\n",
+                    HEX_W, (unsigned long long)bad.front().first,
+                    HEX_W, (unsigned long long)bad.front().second);
+        run_one(d, bad.front().first, bad.front().second, "corpus (verbose)",
+                /*verbose_on_fail=*/true);
+      }
+    }
+  }
+
+  if (corpus_stop) {
+    std::printf("NOTE: run skipped after the corpus failure (--max-fails goes on)\n");
+    db.mode = "corpus";
+  } else if (!replay_path.empty()) {
+    // Vector file replay
+    const VecFileHeader& h = replay.header();
+    std::printf("Replaying %s: %llu vectors, EXP=%d MANT=%d BIAS=%d, flag mask 0x%x\n",
+                replay_path.c_str(), (unsigned long long)h.count, h.exp, h.mant, h.bias,
+                h.flag_mask);
+    if (CHECK_FLAGS && (h.flag_mask & FLAG_ALL) != FLAG_ALL) {
+      std::printf("NOTE: file has only some flags, checking mask 0x%x\n", h.flag_mask & FLAG_ALL);
+    }
+
+    FailCase fail;
+    bool failed = false;
+    if (!jobs) {
+      Results buf(h.block);
+      for (uint64_t k = 0; k < replay.blocks() && !failed; k++) {
+        failed = !replay_block(d, replay, k, buf, st, fail);
+      }
+    } else {
+      std::atomic<bool> stop{false};
+      std::vector<ShardResult> res(jobs);
+      std::vector<Results> bufs(jobs, Results(h.block));
+      run_pool(jobs, backpressure, seed, 0, replay.blocks(), stop,
+               [&](unsigned tid, Driver& dd, uint64_t k) {
+        ShardResult& r = res[tid];
+        r.shards++;
+        if (!replay_block(dd, replay, k, bufs[tid], r.st, r.fail)) {
+          r.failed = true;
+          r.fail_shard = k;
+          return false;
+        }
+        return true;
+      });
+
+      // Report the failure from the lowest block
+      const ShardResult* first = nullptr;
+      for (const ShardResult& r : res) {
+        st.add(r.st);
+        if (r.failed && (!first || r.fail_shard < first->fail_shard)) first = &r;
+      }
+      if (first) {
+        failed = true;
+        fail = first->fail;
+      }
+    }
+
+    tests += st.tests;
+    fails += st.fails;
+    if (failed && !fail.hung) {
+      std::printf("First failing vector: record %llu of %s\n",
+                  (unsigned long long)fail.index, replay_path.c_str());
+      print_replay_fail(d, replay, fail.index);
+      db.found.emplace_back(fail.a, fail.b);
+    }
+    db.mode = "replay";
+    db.source = replay_path;
+  } else if (sweep_spec) {
+    // Exhaustive tile sweep
+    SweepProgress prog(tile, ckpt_path, ckpt_every);
+    if (!prog.load()) {
+      std::printf("ERROR: checkpoint %s does not match this tile/--chunk/--check-flags\n",
+                  ckpt_path.c_str());
+      return 2;
+    }
+    if (prog.done_units()) {
+      std::printf("Resuming sweep at unit %llu of %llu\n",
+                  (unsigned long long)prog.done_units(), (unsigned long long)tile.units());
+    }
+
+    std::signal(SIGINT, sweep_signal);
+    std::signal(SIGTERM, sweep_signal);
+
+    const uint64_t resumed_tests = prog.stats().tests;
+    unsigned nthreads = jobs ? jobs : 1;
+    std::vector<BatchBuffers> bufs(nthreads, BatchBuffers(batch));
+    std::atomic<bool> hung{false};
+    auto t0 = std::chrono::steady_clock::now();
+
+    run_pool(nthreads, backpressure, seed, prog.done_units(), tile.units(), SWEEP_STOP,
+             [&](unsigned tid, Driver& dd, uint64_t u) {
+      SweepStats ust;
+      if (!sweep_unit(dd, tile, u, bufs[tid], ust)) {
+        hung.store(true);
+        return false;
+      }
+      prog.complete(u, std::move(ust));
+      return true;
+    });
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    bool complete = prog.done_units() == tile.units();
+    prog.write();
+    write_sweep_summary(summary_path, tile, prog.stats(), complete, secs);
+    sweep_vectors = prog.stats().tests - resumed_tests;
+    sweep_secs = secs;
+    if (!complete) {
+      std::printf("Sweep stopped at unit %llu of %llu%s\n",
+                  (unsigned long long)prog.done_units(), (unsigned long long)tile.units(),
+                  ckpt_path.empty() ? "" : ", resume with the same --checkpoint");
+    }
+
+    tests += prog.stats().tests;
+    fails += prog.stats().fails + (hung.load() ? 1 : 0);
+    incomplete = !complete;
+
+    if (!prog.stats().first_fails.empty()) {
+      const auto& f = prog.stats().first_fails.front();
+      run_one(d, f.first, f.second, "sweep (verbose)", /*verbose_on_fail=*/true);
+    }
+    for (const auto& f : prog.stats().first_fails) db.found.push_back(f);
+    db.mode = exhaustive ? "exhaustive" : "sweep";
+    db.source = sweep_spec;
+  } else {
+    // Random tests
+    FailCase fail;
+    bool failed = false;
+
+    StimGen gen(seed, weights);
+    FailBudget budget;
+    budget.limit = max_fails;
+    std::vector<FailLog> logs(log_fails ? std::max(1u, jobs) : 0);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    if (!jobs) {
+      BatchBuffers buf(batch);
+      std::unique_ptr<CovDirector> dir;
+      StreamHooks ch;
+      if (log_fails) {
+        ch.log = &logs[0];
+        ch.budget = &budget;
+      }
+      if (sample_cov) {
+        if (cov_directed) dir.reset(new CovDirector(seed, 0));
+        ch.cov = &cov;
+        ch.dir = dir.get();
+        ch.until_full = until_covered;
+      }
+      if (!record_path.empty()) ch.rec = &record;
+      std::unique_ptr<TraceWindow<fp_word>> win;
+      if (trace_window) {
+        win.reset(new TraceWindow<fp_word>(trace_window));
+        ch.win = win.get();
+      }
+      failed = !run_random(d, gen, start, nrand, buf, st, fail, ch);
+    } else {
+      std::vector<ShardResult> res;
+      run_sharded(jobs, gen, seed, start, nrand, chunk, batch, backpressure,
+                  sample_cov, cov_directed, log_fails ? &logs : nullptr, &budget,
+                  trace_window, res);
+
+      // Aggregate, and report the failure from the lowest shard so the
+      // printed case is the same whichever thread found it first
+      const ShardResult* first = nullptr;
+      for (unsigned j = 0; j < jobs; j++) {
+        const ShardResult& r = res[j];
+        std::printf("Thread %2u : %llu shards, %llu tests, %llu failures\n", j,
+                    (unsigned long long)r.shards, (unsigned long long)r.st.tests,
+                    (unsigned long long)r.st.fails);
+        st.add(r.st);
+        if (sample_cov) cov.merge(r.cov);
+        if (r.failed && (!first || r.fail_shard < first->fail_shard)) first = &r;
+      }
+
+      if (first && (!log_fails || first->fail.hung)) {
+        failed = true;
+        fail = first->fail;
+        std::printf("First failure in shard %llu\n", (unsigned long long)first->fail_shard);
+      }
+    }
+
+    if (BENCH) {
+      bench.batch = batch;
+      bench.jobs = jobs;
+      bench.trace = do_trace;
+      bench.trace_window = trace_window;
+      write_bench(bench, st,
+                  std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+
+    if (log_fails && !fail.hung) {
+      // Continue-on-fail report: one verbose dump per failure class
+      failed = false;
+      uint64_t dropped = 0;
+      for (const FailLog& log : logs) dropped += log.dropped();
+      std::vector<FailClass> classes = merge_fail_logs(logs);
+
+      for (size_t k = 0; k < classes.size(); k++) {
+        const FailRecord& r = classes[k].first;
+        const RefOut o = unpack_ref_flags(r.y_dut, r.f_dut);
+        const RefOut g = unpack_ref_flags(r.y_ref, r.f_ref);
+        char tag[64];
+        std::snprintf(tag, sizeof tag, "class %zu, %llu hits, first at index %llu", k + 1,
+                      (unsigned long long)classes[k].count, (unsigned long long)r.index);
+        print_case("FAIL", tag, r.a, r.b,
+                   o.y, o.invalid, o.overflow, o.underflow, o.inexact,
+                   g.y, g.invalid, g.overflow, g.underflow, g.inexact);
+      }
+
+      if (!classes.empty() || dropped) {
+        std::printf("\nFailure classes (%zu, %llu failing vectors%s):\n", classes.size(),
+                    (unsigned long long)st.fails,
+                    budget.exhausted() ? ", stopped at --max-fails" : "");
+        for (size_t k = 0; k < classes.size(); k++) {
+          std::printf("  %3zu  %10llu  %s\n", k + 1, (unsigned long long)classes[k].count,
+                      fail_class_name(classes[k].first).c_str());
+        }
+        for (const FailClass& c : classes) db.found.emplace_back(c.first.a, c.first.b);
+        if (dropped) {
+          std::printf("  NOTE: %llu classes beyond the per-thread log size were counted but not kept\n",
+                      (unsigned long long)dropped);
+        }
+      }
+    }
+
+    if (failed && !fail.hung && fail.directed) {
+      std::printf("First failing vector: coverage-directed, a=0x%0*llx b=0x%0*llx\n",
+                  HEX_W, (unsigned long long)fail.a, HEX_W, (unsigned long long)fail.b);
+    } else if (failed && !fail.hung) {
+      std::printf("First failing vector: index %llu (replay with --seed %llu --start %llu --n 1)\n",
+                  (unsigned long long)fail.index, (unsigned long long)seed,
+                  (unsigned long long)fail.index);
+    }
+
+    tests += st.tests;
+    fails += st.fails;
+
+    if (failed && !fail.hung) {
       // Re-run once verbose so you see full numeric info
-      run_one(dut, tfp, t, a, b, "rand (verbose)", /*verbose_on_fail=*/true);
-      break;
+      run_one(d, fail.a, fail.b, "rand (verbose)", /*verbose_on_fail=*/true);
+      db.found.emplace_back(fail.a, fail.b);
     }
+    db.seed = seed;
+    db.start = start;
+    db.n = nrand;
+    db.cov = &cov;
   }
 
-  if (tfp) {
-    tfp->close();
-    delete tfp;
+  if (!db.dir.empty()) {
+    // Shrink this run's failures and merge them into the corpus
+    db.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_t0).count();
+    db.jobs = jobs;
+    db.tests = tests;
+    db.fails = fails;
+    std::vector<RegPair> found;
+    found.swap(db.found);
+    for (const RegPair& p : found) {
+      RegPair m;
+      if (db.found.size() == REGDB_MAX_SHRINK) break;
+#ifdef FMUL_PIPE
+      if (d.hung) break;
+#endif
+      if (std::find(db.found.begin(), db.found.end(), p) != db.found.end()) continue;
+      if (!regdb_shrink(d, p, m)) continue;
+      db.found.push_back(p);
+      db.minimized.push_back(m);
+      if (m == p) continue;
+      std::printf("Minimized : a=0x%0*llx b=0x%0*llx -> a=0x%0*llx b=0x%0*llx\n",
+                  HEX_W, (unsigned long long)p.first, HEX_W, (unsigned long long)p.second,
+                  HEX_W, (unsigned long long)m.first, HEX_W, (unsigned long long)m.second);
+    }
+
+    RegDbLock lock(db.dir);
+    if (!db.minimized.empty()) {
+      std::string err;
+      db.corpus_added = regdb_merge_corpus(corpus_path, db.minimized, ROUND_MODE, err);
+      if (db.corpus_added < 0) {
+        std::printf("WARNING: %s, corpus not updated\n", err.c_str());
+        db.corpus_added = 0;
+      }
+    }
+    write_regdb_run(db);
   }
 
+#ifdef FMUL_STATS
+  if (!d.hung && !check_stats_csr(d)) STATS_CSR_FAILS++;
+  fails += STATS_CSR_FAILS.load();
+#endif
+  fails += ORACLE_ST.fails.load();
+
+#if FMUL_TRACE
+  if (d.tfp) {
+    d.tfp->close();
+    delete d.tfp;
+  }
+#endif
+
   std::printf("\n---------------------------------------------------------------------------------------------------------------------\n");
   std::printf("Tests run : %llu\n", (unsigned long long)tests);
   std::printf("Failures  : %llu\n", (unsigned long long)fails);
   std::printf("Flag check: %s\n", CHECK_FLAGS ? "ENABLED (--check-flags)" : "DISABLED");
+  std::printf("Format    : EXP=%d MANT=%d BIAS=%d\n", REF_EXP, REF_MANT, REF_BIAS);
+  std::printf("Subnormal : %s\n", REF_SUBNORMAL ? "gradual underflow" : "DAZ/FTZ");
+  std::printf("Rounding  : %s\n", ref_rm_name(ROUND_MODE));
+  std::printf("Models    : %u x %u thread%s\n", jobs ? jobs : 1u, MODEL_THREADS,
+              MODEL_THREADS > 1 ? "s" : "");
+  std::printf("Ref model : %s\n",
+              ref_isa_name(REF_BATCH_SIMD ? REF_ISA : RefIsa::Scalar));
+  if (ORACLE != Oracle::None) {
+    std::printf("Oracle    : %s, %llu vectors, %llu disagreements with the reference",
+                oracle_name(ORACLE), (unsigned long long)ORACLE_ST.tests.load(),
+                (unsigned long long)ORACLE_ST.fails.load());
+    if (oracle_redone().load()) {
+      std::printf(" (%llu chunks rechecked per vector)", (unsigned long long)oracle_redone().load());
+    }
+    std::printf("\n");
+  }
+  if (!db.dir.empty()) {
+    std::printf("Database  : %s, corpus %llu vectors replayed (%llu failing), %ld added\n",
+                db.dir.c_str(), (unsigned long long)db.corpus_vectors,
+                (unsigned long long)db.corpus_fails, db.corpus_added);
+  }
+  if (sweep_spec) {
+    std::printf("Throughput: %.3e vectors/s (%.1f s on %u thread%s)\n",
+                sweep_secs > 0 ? (double)sweep_vectors / sweep_secs : 0.0, sweep_secs,
+                jobs ? jobs : 1u, jobs > 1 ? "s" : "");
+  }
+  if (coverage) cov.print();
+  if (STATS) st.hist.print();
+#ifdef FMUL_STATS
+  std::printf("Stats CSR : %s, %d-bit counters\n",
+              STATS_CSR_FAILS.load() ? "MISMATCH" : "match the driven vectors", FMUL_STATS);
+#endif
+#ifdef FMUL_PIPE
+  std::printf("Stream    : %llu results in %llu cycles (%.3f results/cycle)%s\n",
+              (unsigned long long)st.stream_tests, (unsigned long long)st.stream_cycles,
+              st.stream_cycles ? (double)st.stream_tests / (double)st.stream_cycles : 0.0,
+              backpressure ? ", with back-pressure" : "");
+#endif
   std::printf("---------------------------------------------------------------------------------------------------------------------\n");
 
-  delete dut;
-  return (fails == 0) ? 0 : 1;
+  delete d.dut;
+  if (fails) return 1;
+  return incomplete ? 3 : 0;
 }
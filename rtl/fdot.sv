@@ -0,0 +1,346 @@
+`timescale 1ns / 1ps
+
+// Floating-point dot product with an exact accumulator.
+//
+// A stream of beats, each LANES operand pairs, ends with the beat that
+// has in_last set; the result is the sum of every product of the stream,
+// rounded once in the mode rm of that last beat. Products are not
+// rounded: each lane's significand product (pom_mant of fmul_mult) is
+// shifted to its exponent in a fixed-point accumulator wide enough to
+// hold any product of the format exactly (Kulisch style), so the sum is
+// exact and the result does not depend on the order of the products,
+// neither across lanes nor across beats.
+//
+//   per lane: fmul_unpack -> fmul_mult     | product register
+//   all lanes: align, add into accumulator | sum register (last beat)
+//   normalize -> fmul_round -> fmul_pack   | result register
+//
+// Throughput is one beat per cycle, streams follow each other without a
+// gap; a stream's result leaves three cycles after its last beat.
+//
+// Same conventions as fmul: DAZ on the operands, FTZ on the result, one
+// constant qNaN. A NaN operand gives qNaN; an Inf * 0 product, or
+// products of both infinite signs, give qNaN with invalid; otherwise an
+// infinite product gives Inf. An exact zero sum is -0 when every product
+// is a zero with sign bit set, +0 otherwise (-0 for RDN when products
+// cancel or zeros of both signs meet).
+//
+// The accumulator has 2*MANT+2 + 2^(EXP+1)-6 magnitude bits (the widest
+// product at the largest exponent), CARRY_W carry bits and a sign: 571
+// bits for binary32, 539 for bfloat16, 97 for binary16. A stream may
+// hold at most 2^CARRY_W products (2^CARRY_W / LANES beats) before it
+// can overflow.
+
+module fdot #(
+    parameter LANES = 4,
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter MULT_IMPL = 0,   // significand multiplier, see fmul_mult.sv
+    parameter DSP_W = 17,
+    parameter CARRY_W = 16     // log2 of the longest stream, in products
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] a,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] b,
+    input  logic [2:0] rm,      // rounding mode, taken from the last beat
+    input  logic in_last,       // last beat of the stream
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [EXP + MANT:0] y,
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact
+);
+
+    import fmul_rm_pkg::*;
+
+    localparam W      = 1 + EXP + MANT;
+    localparam SH_MAX = (1 << (EXP + 1)) - 6;       // exp_a + exp_b - 2, both normal
+    localparam ACC_W  = 2*MANT + 2 + SH_MAX + CARRY_W + 1;
+    localparam LW     = $clog2(ACC_W);
+    localparam EW     = $clog2(ACC_W + BIAS + 2*MANT) + 2;
+
+    generate
+        if (LANES < 1) begin : g_bad_lanes
+            $error("fdot: LANES must be at least 1");
+        end
+    endgenerate
+
+    // Product of one lane, the classification of fmul_unpack kept
+    typedef struct packed {
+        logic nan;        // NaN operand or Inf * 0
+        logic invalid;    // Inf * 0
+        logic inf;
+        logic zero;       // zero or flushed operand
+        logic sign;
+        logic [EXP:0] shift;            // weight of pom_mant bit 0 above the accumulator LSB
+        logic [2*MANT+1:0] pom_mant;
+    } prod_t;
+
+    typedef struct packed {
+        prod_t [LANES - 1:0] lane;
+        logic [2:0] rm;
+        logic last;
+    } beat_t;
+
+    // Special cases seen so far in the stream
+    typedef struct packed {
+        logic nan;
+        logic invalid;
+        logic inf_pos;
+        logic inf_neg;
+        logic finite;     // a nonzero finite product
+        logic zero_pos;
+        logic zero_neg;
+    } state_t;
+
+    typedef struct packed {
+        logic [ACC_W - 1:0] acc;
+        state_t st;
+        logic [2:0] rm;
+    } sum_t;
+
+    typedef struct packed {
+        logic [EXP + MANT:0] y;
+        logic invalid;
+        logic overflow;
+        logic underflow;
+        logic inexact;
+    } pack_t;
+
+    beat_t  s1_d, s1_q;
+    sum_t   s2_d, s2_q;
+    pack_t  s3_d, s3_q;
+
+    // ---------------------------------------------------------------
+    // Step 1: unpack and multiply, every lane
+    // ---------------------------------------------------------------
+    genvar l;
+    generate
+        for (l = 0; l < LANES; l++) begin : g_lane
+            logic [W - 1:0] a_l, b_l;
+            logic p_special, p_nan, p_inf, p_invalid;
+            logic signed [EXP+1:0] exp_work;
+            logic [MANT:0] sig_a, sig_b;
+
+            assign a_l = a[l*W +: W];
+            assign b_l = b[l*W +: W];
+
+            fmul_unpack #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS)) u_unpack (
+                .a        (a_l),
+                .b        (b_l),
+                .sign_c   (s1_d.lane[l].sign),
+                .special  (p_special),
+                .spec_nan (p_nan),
+                .spec_inf (p_inf),
+                .invalid  (p_invalid),
+                .exp_work (exp_work),
+                .sig_a    (sig_a),
+                .sig_b    (sig_b)
+            );
+
+            fmul_mult #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_mult (
+                .sig_a    (sig_a),
+                .sig_b    (sig_b),
+                .pom_mant (s1_d.lane[l].pom_mant)
+            );
+
+            assign s1_d.lane[l].nan     = p_nan;
+            assign s1_d.lane[l].invalid = p_invalid;
+            assign s1_d.lane[l].inf     = p_inf;
+            assign s1_d.lane[l].zero    = p_special && !p_nan && !p_inf;
+
+            // Both exponents are at least 1 unless the lane is special
+            assign s1_d.lane[l].shift = p_special ? '0 :
+                {1'b0, a_l[MANT +: EXP]} + {1'b0, b_l[MANT +: EXP]} - (EXP+1)'(2);
+        end
+    endgenerate
+
+    assign s1_d.rm   = rm;
+    assign s1_d.last = in_last;
+
+    // ---------------------------------------------------------------
+    // Step 2: align the products and add them into the accumulator.
+    // A LANES+1 input sum, mapped to a carry-save tree and one
+    // carry-propagate adder by synthesis.
+    // ---------------------------------------------------------------
+    logic [ACC_W - 1:0] acc_q, acc_d;
+    state_t st_q, st_d;
+
+    always_comb begin
+        acc_d = acc_q;
+        st_d  = st_q;
+        for (int k = 0; k < LANES; k++) begin
+            if (!s1_q.lane[k].nan && !s1_q.lane[k].inf && !s1_q.lane[k].zero) begin
+                if (s1_q.lane[k].sign)
+                    acc_d = acc_d - (ACC_W'(s1_q.lane[k].pom_mant) << s1_q.lane[k].shift);
+                else
+                    acc_d = acc_d + (ACC_W'(s1_q.lane[k].pom_mant) << s1_q.lane[k].shift);
+                st_d.finite = 1'b1;
+            end
+            st_d.nan      |= s1_q.lane[k].nan;
+            st_d.invalid  |= s1_q.lane[k].invalid;
+            st_d.inf_pos  |= s1_q.lane[k].inf && !s1_q.lane[k].sign;
+            st_d.inf_neg  |= s1_q.lane[k].inf && s1_q.lane[k].sign;
+            st_d.zero_pos |= s1_q.lane[k].zero && !s1_q.lane[k].sign;
+            st_d.zero_neg |= s1_q.lane[k].zero && s1_q.lane[k].sign;
+        end
+    end
+
+    assign s2_d.acc = acc_d;
+    assign s2_d.st  = st_d;
+    assign s2_d.rm  = s1_q.rm;
+
+    // ---------------------------------------------------------------
+    // Step 3: normalize the sum to a pom_mant in [1,2), the bits below
+    // it folded into the sticky position, round and pack
+    // ---------------------------------------------------------------
+    logic sign_s, sum_zero;
+    logic [ACC_W - 1:0] mag, mag_norm;
+    logic [LW - 1:0] lead;
+    logic [2*MANT+1:0] pom_s;
+    logic signed [EW - 1:0] exp_s;
+    logic signed [EXP+1:0] exp_sat;
+    logic [MANT - 1:0] mant_c;
+    logic signed [EXP+1:0] exp_round;
+    logic round_inexact;
+    logic spec_nan, spec_inf, spec_invalid, spec_sign, special;
+
+    assign sign_s   = s2_q.acc[ACC_W - 1];
+    assign mag      = sign_s ? -s2_q.acc : s2_q.acc;
+    assign sum_zero = ~|s2_q.acc;
+
+    always_comb begin
+        lead = '0;
+        for (int k = 0; k < ACC_W; k++) begin
+            if (mag[k]) lead = LW'(k);
+        end
+    end
+
+    assign mag_norm = mag << (LW'(ACC_W - 1) - lead);
+    assign pom_s    = {1'b0, mag_norm[ACC_W - 1 -: 2*MANT],
+                       mag_norm[ACC_W - 1 - 2*MANT] | (|mag_norm[ACC_W - 2 - 2*MANT:0])};
+
+    // Biased exponent of the leading one; far out of range it is clamped
+    // to values that still overflow or flush after a rounding carry
+    assign exp_s   = $signed({1'b0, lead}) + 2 - BIAS - 2*MANT;
+    assign exp_sat = (exp_s > (1 << EXP)) ? (EXP+2)'(1 << EXP) :
+                     (exp_s < -1)         ? -(EXP+2)'(1) : exp_s[EXP+1:0];
+
+    fmul_round #(.EXP(EXP), .MANT(MANT)) u_round (
+        .pom_mant  (pom_s),
+        .exp_work  (exp_sat),
+        .sign_c    (sign_s),
+        .rm        (s2_q.rm),
+        .mant_c    (mant_c),
+        .exp_round (exp_round),
+        .inexact   (round_inexact)
+    );
+
+    assign spec_nan     = s2_q.st.nan || (s2_q.st.inf_pos && s2_q.st.inf_neg);
+    assign spec_invalid = s2_q.st.invalid || (s2_q.st.inf_pos && s2_q.st.inf_neg);
+    assign spec_inf     = s2_q.st.inf_pos || s2_q.st.inf_neg;
+    assign special      = spec_nan || spec_inf || sum_zero;
+
+    always_comb begin
+        if (spec_inf)
+            spec_sign = s2_q.st.inf_neg;
+        else if (s2_q.st.finite || (s2_q.st.zero_pos && s2_q.st.zero_neg))
+            spec_sign = (s2_q.rm == RM_RDN);
+        else
+            spec_sign = s2_q.st.zero_neg;
+    end
+
+    fmul_pack #(.EXP(EXP), .MANT(MANT)) u_pack (
+        .sign_c        (special ? spec_sign : sign_s),
+        .special       (special),
+        .spec_nan      (spec_nan),
+        .spec_inf      (spec_inf),
+        .spec_invalid  (spec_invalid),
+        .exp_work      (exp_round),
+        .mant_c        (mant_c),
+        .rm            (s2_q.rm),
+        .round_inexact (round_inexact),
+        .tiny          (1'b0),
+        .y             (s3_d.y),
+        .invalid       (s3_d.invalid),
+        .overflow      (s3_d.overflow),
+        .underflow     (s3_d.underflow),
+        .inexact       (s3_d.inexact)
+    );
+
+    assign y         = s3_q.y;
+    assign invalid   = s3_q.invalid;
+    assign overflow  = s3_q.overflow;
+    assign underflow = s3_q.underflow;
+    assign inexact   = s3_q.inexact;
+
+    // ---------------------------------------------------------------
+    // Stage registers and accumulator
+    // ---------------------------------------------------------------
+    logic [3:0] vld;
+    logic [3:0] rdy;
+    logic beat_ready, beat_fire;
+
+    assign vld[0]   = in_valid;
+    assign in_ready = rdy[0];
+
+    fmul_pipe_reg #(.WIDTH($bits(beat_t))) u_reg1 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[0]),
+        .in_ready  (rdy[0]),
+        .in_data   (s1_d),
+        .out_valid (vld[1]),
+        .out_ready (beat_ready),
+        .out_data  (s1_q)
+    );
+
+    // A beat is added every cycle; the last one also needs room in the
+    // sum register, which takes the complete stream
+    assign beat_ready = !s1_q.last || rdy[1];
+    assign beat_fire  = vld[1] && beat_ready;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            acc_q <= '0;
+            st_q  <= '0;
+        end else if (beat_fire) begin
+            acc_q <= s1_q.last ? '0 : acc_d;
+            st_q  <= s1_q.last ? '0 : st_d;
+        end
+    end
+
+    fmul_pipe_reg #(.WIDTH($bits(sum_t))) u_reg2 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[1] && s1_q.last),
+        .in_ready  (rdy[1]),
+        .in_data   (s2_d),
+        .out_valid (vld[2]),
+        .out_ready (rdy[2]),
+        .out_data  (s2_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(pack_t))) u_reg3 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[2]),
+        .in_ready  (rdy[2]),
+        .in_data   (s3_d),
+        .out_valid (vld[3]),
+        .out_ready (rdy[3]),
+        .out_data  (s3_q)
+    );
+
+    assign out_valid = vld[3];
+    assign rdy[3]    = out_ready;
+
+endmodule
@@ -0,0 +1,140 @@
+`timescale 1ns / 1ps
+
+module ffma #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter MULT_IMPL = 0,   // significand multiplier, see fmul_mult.sv
+    parameter DSP_W = 17
+)(
+    input  logic [EXP + MANT:0] a,
+    input  logic [EXP + MANT:0] b,
+    input  logic [EXP + MANT:0] c,
+    output logic [EXP + MANT:0] y,   // a*b + c, rounded once
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact
+);
+
+    // Fully combinational: the datapath steps from fmul_stages.sv and
+    // ffma_stages.sv chained back to back. ffma_pipe registers the same steps.
+
+    logic sign_p, sign_c, sign_s;
+    logic p_special, p_nan, p_inf, p_invalid;
+    logic special, spec_nan, spec_inf, spec_sign, spec_invalid;
+    logic p_zero, c_zero;
+    logic [MANT:0] sig_a;
+    logic [MANT:0] sig_b;
+    logic [2*MANT+1:0] pom_mant;
+    logic [3*MANT+4:0] c_al;
+    logic c_sticky;
+    logic [3*MANT+6:0] sum;
+    logic [$clog2(3*MANT+8) - 1:0] lz_pred;
+    logic sum_zero;
+    logic [2*MANT+1:0] pom_norm;
+    logic round_inexact;
+    logic [MANT - 1:0] mant_c;
+
+    logic signed [EXP+1:0] exp_work;
+    logic signed [EXP+1:0] exp_base;
+    logic signed [EXP+1:0] exp_norm;
+    logic signed [EXP+1:0] exp_round;
+
+    fmul_unpack #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS)) u_unpack (
+        .a        (a),
+        .b        (b),
+        .sign_c   (sign_p),
+        .special  (p_special),
+        .spec_nan (p_nan),
+        .spec_inf (p_inf),
+        .invalid  (p_invalid),
+        .exp_work (exp_work),
+        .sig_a    (sig_a),
+        .sig_b    (sig_b)
+    );
+
+    ffma_addend #(.EXP(EXP), .MANT(MANT)) u_addend (
+        .c         (c),
+        .sign_p    (sign_p),
+        .p_special (p_special),
+        .p_nan     (p_nan),
+        .p_inf     (p_inf),
+        .p_invalid (p_invalid),
+        .sign_c    (sign_c),
+        .special   (special),
+        .spec_nan  (spec_nan),
+        .spec_inf  (spec_inf),
+        .spec_sign (spec_sign),
+        .invalid   (spec_invalid),
+        .p_zero    (p_zero),
+        .c_zero    (c_zero)
+    );
+
+    fmul_mult #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_mult (
+        .sig_a    (sig_a),
+        .sig_b    (sig_b),
+        .pom_mant (pom_mant)
+    );
+
+    ffma_align #(.EXP(EXP), .MANT(MANT)) u_align (
+        .c        (c),
+        .c_zero   (c_zero),
+        .p_zero   (p_zero),
+        .exp_work (exp_work),
+        .c_al     (c_al),
+        .c_sticky (c_sticky),
+        .exp_base (exp_base)
+    );
+
+    ffma_add #(.MANT(MANT)) u_add (
+        .sign_p   (sign_p),
+        .sign_c   (sign_c),
+        .p_zero   (p_zero),
+        .pom_mant (pom_mant),
+        .c_al     (c_al),
+        .c_sticky (c_sticky),
+        .sum      (sum),
+        .lz_pred  (lz_pred),
+        .sign_s   (sign_s),
+        .sum_zero (sum_zero)
+    );
+
+    ffma_norm #(.EXP(EXP), .MANT(MANT)) u_norm (
+        .sum      (sum),
+        .lz_pred  (lz_pred),
+        .exp_base (exp_base),
+        .pom_norm (pom_norm),
+        .exp_norm (exp_norm),
+        .inexact  (round_inexact)
+    );
+
+    fmul_round #(.EXP(EXP), .MANT(MANT)) u_round (
+        .pom_mant  (pom_norm),
+        .exp_work  (exp_norm),
+        .sign_c    (sign_s),
+        .rm        (fmul_rm_pkg::RM_RNE),
+        .mant_c    (mant_c),
+        .exp_round (exp_round),
+        .inexact   ()
+    );
+
+    ffma_pack #(.EXP(EXP), .MANT(MANT)) u_pack (
+        .sign_s        (sign_s),
+        .special       (special),
+        .spec_nan      (spec_nan),
+        .spec_inf      (spec_inf),
+        .spec_sign     (spec_sign),
+        .spec_invalid  (spec_invalid),
+        .sum_zero      (sum_zero),
+        .round_inexact (round_inexact),
+        .exp_work      (exp_round),
+        .mant_c        (mant_c),
+        .y             (y),
+        .invalid       (invalid),
+        .overflow      (overflow),
+        .underflow     (underflow),
+        .inexact       (inexact)
+    );
+
+endmodule
@@ -0,0 +1,355 @@
+`timescale 1ns / 1ps
+
+// Pipelined fused multiply-add.
+//
+// Same datapath steps as ffma (see ffma_stages.sv) with STAGES pipeline
+// registers placed between them, using the fmul_pipe valid/ready slices.
+// Latency is STAGES cycles, throughput is one result per cycle.
+//
+// Register placement (bit k = register after step k):
+//
+//   STAGES | unpack | mult/align | add/lza | norm | round | pack
+//   -------+--------+------------+---------+------+-------+-----
+//      1   |        |            |         |      |       |  x
+//      2   |        |     x      |         |      |       |  x
+//      3   |   x    |     x      |         |      |       |  x
+//      4   |   x    |     x      |    x    |      |       |  x
+//      5   |   x    |     x      |    x    |      |   x   |  x
+//      6   |   x    |     x      |    x    |  x   |   x   |  x
+
+module ffma_pipe #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter STAGES = 4,
+    parameter MULT_IMPL = 0,   // significand multiplier, see fmul_mult.sv
+    parameter DSP_W = 17
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [EXP + MANT:0] a,
+    input  logic [EXP + MANT:0] b,
+    input  logic [EXP + MANT:0] c,
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [EXP + MANT:0] y,
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact
+);
+
+    localparam LZW = $clog2(3*MANT+8);
+
+    localparam logic [5:0] REG_MASK = (STAGES == 1) ? 6'b100000 :
+                                      (STAGES == 2) ? 6'b100010 :
+                                      (STAGES == 3) ? 6'b100011 :
+                                      (STAGES == 4) ? 6'b100111 :
+                                      (STAGES == 5) ? 6'b110111 :
+                                                      6'b111111;
+
+    generate
+        if (STAGES < 1 || STAGES > 6) begin : g_bad_stages
+            $error("ffma_pipe: STAGES must be in 1..6");
+        end
+    endgenerate
+
+    // Special-case decision, carried along until pack
+    typedef struct packed {
+        logic special;
+        logic spec_nan;
+        logic spec_inf;
+        logic spec_sign;
+        logic spec_invalid;
+    } ctl_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic sign_p;
+        logic sign_c;
+        logic p_zero;
+        logic c_zero;
+        logic signed [EXP+1:0] exp_work;
+        logic [MANT:0] sig_a;
+        logic [MANT:0] sig_b;
+        logic [EXP + MANT:0] c;
+    } unpack_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic sign_p;
+        logic sign_c;
+        logic p_zero;
+        logic signed [EXP+1:0] exp_base;
+        logic [2*MANT+1:0] pom_mant;
+        logic [3*MANT+4:0] c_al;
+        logic c_sticky;
+    } mult_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_base;
+        logic [3*MANT+6:0] sum;
+        logic [LZW - 1:0] lz_pred;
+        logic sign_s;
+        logic sum_zero;
+    } add_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic sign_s;
+        logic sum_zero;
+        logic inexact;
+        logic signed [EXP+1:0] exp_work;
+        logic [2*MANT+1:0] pom_mant;
+    } norm_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic sign_s;
+        logic sum_zero;
+        logic inexact;
+        logic signed [EXP+1:0] exp_work;
+        logic [MANT - 1:0] mant_c;
+    } round_t;
+
+    typedef struct packed {
+        logic [EXP + MANT:0] y;
+        logic invalid;
+        logic overflow;
+        logic underflow;
+        logic inexact;
+    } pack_t;
+
+    // _d: step output, _q: after (optional) stage register
+    unpack_t s1_d, s1_q;
+    mult_t   s2_d, s2_q;
+    add_t    s3_d, s3_q;
+    norm_t   s4_d, s4_q;
+    round_t  s5_d, s5_q;
+    pack_t   s6_d, s6_q;
+
+    logic p_special, p_nan, p_inf, p_invalid;
+
+    // ---------------------------------------------------------------
+    // Step 1: unpack / classify
+    // ---------------------------------------------------------------
+    fmul_unpack #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS)) u_unpack (
+        .a        (a),
+        .b        (b),
+        .sign_c   (s1_d.sign_p),
+        .special  (p_special),
+        .spec_nan (p_nan),
+        .spec_inf (p_inf),
+        .invalid  (p_invalid),
+        .exp_work (s1_d.exp_work),
+        .sig_a    (s1_d.sig_a),
+        .sig_b    (s1_d.sig_b)
+    );
+
+    ffma_addend #(.EXP(EXP), .MANT(MANT)) u_addend (
+        .c         (c),
+        .sign_p    (s1_d.sign_p),
+        .p_special (p_special),
+        .p_nan     (p_nan),
+        .p_inf     (p_inf),
+        .p_invalid (p_invalid),
+        .sign_c    (s1_d.sign_c),
+        .special   (s1_d.ctl.special),
+        .spec_nan  (s1_d.ctl.spec_nan),
+        .spec_inf  (s1_d.ctl.spec_inf),
+        .spec_sign (s1_d.ctl.spec_sign),
+        .invalid   (s1_d.ctl.spec_invalid),
+        .p_zero    (s1_d.p_zero),
+        .c_zero    (s1_d.c_zero)
+    );
+
+    assign s1_d.c = c;
+
+    // ---------------------------------------------------------------
+    // Step 2: significand multiply, addend alignment beside it
+    // ---------------------------------------------------------------
+    assign s2_d.ctl    = s1_q.ctl;
+    assign s2_d.sign_p = s1_q.sign_p;
+    assign s2_d.sign_c = s1_q.sign_c;
+    assign s2_d.p_zero = s1_q.p_zero;
+
+    fmul_mult #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_mult (
+        .sig_a    (s1_q.sig_a),
+        .sig_b    (s1_q.sig_b),
+        .pom_mant (s2_d.pom_mant)
+    );
+
+    ffma_align #(.EXP(EXP), .MANT(MANT)) u_align (
+        .c        (s1_q.c),
+        .c_zero   (s1_q.c_zero),
+        .p_zero   (s1_q.p_zero),
+        .exp_work (s1_q.exp_work),
+        .c_al     (s2_d.c_al),
+        .c_sticky (s2_d.c_sticky),
+        .exp_base (s2_d.exp_base)
+    );
+
+    // ---------------------------------------------------------------
+    // Step 3: add, leading-zero anticipation
+    // ---------------------------------------------------------------
+    assign s3_d.ctl      = s2_q.ctl;
+    assign s3_d.exp_base = s2_q.exp_base;
+
+    ffma_add #(.MANT(MANT)) u_add (
+        .sign_p   (s2_q.sign_p),
+        .sign_c   (s2_q.sign_c),
+        .p_zero   (s2_q.p_zero),
+        .pom_mant (s2_q.pom_mant),
+        .c_al     (s2_q.c_al),
+        .c_sticky (s2_q.c_sticky),
+        .sum      (s3_d.sum),
+        .lz_pred  (s3_d.lz_pred),
+        .sign_s   (s3_d.sign_s),
+        .sum_zero (s3_d.sum_zero)
+    );
+
+    // ---------------------------------------------------------------
+    // Step 4: normalize
+    // ---------------------------------------------------------------
+    assign s4_d.ctl      = s3_q.ctl;
+    assign s4_d.sign_s   = s3_q.sign_s;
+    assign s4_d.sum_zero = s3_q.sum_zero;
+
+    ffma_norm #(.EXP(EXP), .MANT(MANT)) u_norm (
+        .sum      (s3_q.sum),
+        .lz_pred  (s3_q.lz_pred),
+        .exp_base (s3_q.exp_base),
+        .pom_norm (s4_d.pom_mant),
+        .exp_norm (s4_d.exp_work),
+        .inexact  (s4_d.inexact)
+    );
+
+    // ---------------------------------------------------------------
+    // Step 5: round
+    // ---------------------------------------------------------------
+    assign s5_d.ctl      = s4_q.ctl;
+    assign s5_d.sign_s   = s4_q.sign_s;
+    assign s5_d.sum_zero = s4_q.sum_zero;
+    assign s5_d.inexact  = s4_q.inexact;
+
+    fmul_round #(.EXP(EXP), .MANT(MANT)) u_round (
+        .pom_mant  (s4_q.pom_mant),
+        .exp_work  (s4_q.exp_work),
+        .sign_c    (s4_q.sign_s),
+        .rm        (fmul_rm_pkg::RM_RNE),
+        .mant_c    (s5_d.mant_c),
+        .exp_round (s5_d.exp_work),
+        .inexact   ()
+    );
+
+    // ---------------------------------------------------------------
+    // Step 6: overflow / FTZ checks and pack
+    // ---------------------------------------------------------------
+    ffma_pack #(.EXP(EXP), .MANT(MANT)) u_pack (
+        .sign_s        (s5_q.sign_s),
+        .special       (s5_q.ctl.special),
+        .spec_nan      (s5_q.ctl.spec_nan),
+        .spec_inf      (s5_q.ctl.spec_inf),
+        .spec_sign     (s5_q.ctl.spec_sign),
+        .spec_invalid  (s5_q.ctl.spec_invalid),
+        .sum_zero      (s5_q.sum_zero),
+        .round_inexact (s5_q.inexact),
+        .exp_work      (s5_q.exp_work),
+        .mant_c        (s5_q.mant_c),
+        .y             (s6_d.y),
+        .invalid       (s6_d.invalid),
+        .overflow      (s6_d.overflow),
+        .underflow     (s6_d.underflow),
+        .inexact       (s6_d.inexact)
+    );
+
+    assign y         = s6_q.y;
+    assign invalid   = s6_q.invalid;
+    assign overflow  = s6_q.overflow;
+    assign underflow = s6_q.underflow;
+    assign inexact   = s6_q.inexact;
+
+    // ---------------------------------------------------------------
+    // Stage registers
+    // ---------------------------------------------------------------
+    logic [6:0] vld;
+    logic [6:0] rdy;
+
+    assign vld[0]   = in_valid;
+    assign in_ready = rdy[0];
+
+    fmul_pipe_reg #(.WIDTH($bits(unpack_t)), .EN(REG_MASK[0])) u_reg1 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[0]),
+        .in_ready  (rdy[0]),
+        .in_data   (s1_d),
+        .out_valid (vld[1]),
+        .out_ready (rdy[1]),
+        .out_data  (s1_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(mult_t)), .EN(REG_MASK[1])) u_reg2 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[1]),
+        .in_ready  (rdy[1]),
+        .in_data   (s2_d),
+        .out_valid (vld[2]),
+        .out_ready (rdy[2]),
+        .out_data  (s2_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(add_t)), .EN(REG_MASK[2])) u_reg3 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[2]),
+        .in_ready  (rdy[2]),
+        .in_data   (s3_d),
+        .out_valid (vld[3]),
+        .out_ready (rdy[3]),
+        .out_data  (s3_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(norm_t)), .EN(REG_MASK[3])) u_reg4 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[3]),
+        .in_ready  (rdy[3]),
+        .in_data   (s4_d),
+        .out_valid (vld[4]),
+        .out_ready (rdy[4]),
+        .out_data  (s4_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(round_t)), .EN(REG_MASK[4])) u_reg5 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[4]),
+        .in_ready  (rdy[4]),
+        .in_data   (s5_d),
+        .out_valid (vld[5]),
+        .out_ready (rdy[5]),
+        .out_data  (s5_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH($bits(pack_t)), .EN(REG_MASK[5])) u_reg6 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[5]),
+        .in_ready  (rdy[5]),
+        .in_data   (s6_d),
+        .out_valid (vld[6]),
+        .out_ready (rdy[6]),
+        .out_data  (s6_q)
+    );
+
+    assign out_valid = vld[6];
+    assign rdy[6]    = out_ready;
+
+endmodule
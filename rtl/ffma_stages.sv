@@ -0,0 +1,301 @@
+`timescale 1ns / 1ps
+
+// Datapath steps of the fused multiply-add y = a*b + c.
+//
+// The product side is fmul's: fmul_unpack classifies a and b and adds
+// their exponents, fmul_mult forms the 2*MANT+2 bit significand product.
+// The addend is aligned against the product while it is being formed, the
+// sum is taken at full width, normalized with a leading-zero anticipator
+// and rounded once by fmul_round. Same conventions as fmul: DAZ/FTZ,
+// constant qNaN, round to nearest even.
+//
+//   fmul_unpack + ffma_addend -> fmul_mult + ffma_align -> ffma_add
+//                             -> ffma_norm -> fmul_round -> ffma_pack
+//
+// Sum window (RW = 3*MANT+7 bits, one unit = one product LSB / 2):
+//
+//   bit  RW-1        carry out of an effective addition
+//        3*MANT+5    addend MSB when it is not shifted (product far below)
+//        2*MANT+2:1  product
+//        0           sticky of the addend bits shifted below the product
+//
+// An addend MANT+4 or more binades above the product stays at the top and
+// the product only contributes to the sticky bits, an addend below the
+// window collapses into bit 0. Either way rounding is exact.
+
+// -------------------------------------------------------------------
+// Classify c, combine with the product classification
+// -------------------------------------------------------------------
+module ffma_addend #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [EXP + MANT:0] c,
+    // from fmul_unpack
+    input  logic sign_p,
+    input  logic p_special,  // product is NaN, Inf or (DAZ) zero
+    input  logic p_nan,
+    input  logic p_inf,
+    input  logic p_invalid,  // Inf * 0
+    output logic sign_c,
+    output logic special,    // result decided by classification
+    output logic spec_nan,   // special result is qNaN
+    output logic spec_inf,   // special result is Inf (otherwise zero)
+    output logic spec_sign,  // sign of a special Inf or zero
+    output logic invalid,
+    output logic p_zero,     // product is zero, the result is c
+    output logic c_zero      // c is zero (or DAZ subnormal)
+);
+
+    logic [EXP - 1:0] exp_c;
+    logic [MANT - 1:0] mant_c;
+    logic c_isInf, c_isNaN;
+
+    assign sign_c = c[EXP + MANT];
+    assign exp_c  = c[EXP + MANT - 1:MANT];
+    assign mant_c = c[MANT - 1:0];
+
+    assign c_zero  = (exp_c == 0);
+    assign c_isInf = (exp_c == {EXP{1'b1}}) && (mant_c == 0);
+    assign c_isNaN = (exp_c == {EXP{1'b1}}) && (mant_c != 0);
+
+    always_comb begin
+        special   = 0;
+        spec_nan  = 0;
+        spec_inf  = 0;
+        spec_sign = 0;
+        invalid   = 0;
+        p_zero    = 0;
+
+        if (p_nan || c_isNaN) begin
+        // NaN operand or Inf * 0 -> NaN, inv flag only for Inf * 0
+            special  = 1;
+            spec_nan = 1;
+            invalid  = p_invalid;
+        end else if (p_inf && c_isInf && (sign_p != sign_c)) begin
+        // Inf - Inf -> NaN, inv flag
+            special  = 1;
+            spec_nan = 1;
+            invalid  = 1;
+        end else if (p_inf) begin
+            special   = 1;
+            spec_inf  = 1;
+            spec_sign = sign_p;
+        end else if (c_isInf) begin
+            special   = 1;
+            spec_inf  = 1;
+            spec_sign = sign_c;
+        end else if (p_special && c_zero) begin
+        // 0 + 0 -> -0 only if both are -0
+            special   = 1;
+            spec_sign = sign_p & sign_c;
+        end else if (p_special) begin
+        // 0 + c -> c, through the datapath with the product zeroed
+            p_zero = 1;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// Align the addend to the product, runs beside fmul_mult
+// -------------------------------------------------------------------
+module ffma_align #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [EXP + MANT:0] c,
+    input  logic c_zero,
+    input  logic p_zero,
+    input  logic signed [EXP+1:0] exp_work,  // product exponent
+    output logic [3*MANT+4:0] c_al,          // addend, sum window bits [RW-2:1]
+    output logic c_sticky,                   // addend bits below the window
+    output logic signed [EXP+1:0] exp_base   // exponent of the window
+);
+
+    localparam SMAX = 3*MANT + 5;            // addend entirely below the window
+    localparam XW   = EXP + 4;
+
+    logic [EXP - 1:0] exp_c;
+    logic [MANT:0] sig_c;
+    logic signed [XW - 1:0] shift;
+    logic [$clog2(SMAX + 1) - 1:0] shift_cl;
+    logic [4*MANT+5:0] c_ext;
+
+    assign exp_c = c[EXP + MANT - 1:MANT];
+    assign sig_c = c_zero ? '0 : {1'b1, c[MANT - 1:0]};
+
+    // Right shift that puts the addend next to the product, 0 keeps it
+    // MANT+4 binades above the product
+    assign shift = XW'(exp_work) - XW'($signed({1'b0, exp_c})) + XW'(MANT + 4);
+
+    always_comb begin
+        if (c_zero) begin
+            shift_cl = SMAX;
+            exp_base = exp_work;
+        end else if (p_zero || shift <= 0) begin
+            // addend on top, the window follows its exponent
+            shift_cl = 0;
+            exp_base = $signed({2'b0, exp_c}) - (MANT + 4);
+        end else if (shift >= SMAX) begin
+            shift_cl = SMAX;
+            exp_base = exp_work;
+        end else begin
+            shift_cl = shift[$clog2(SMAX + 1) - 1:0];
+            exp_base = exp_work;
+        end
+    end
+
+    assign c_ext    = {sig_c, {(3*MANT+5){1'b0}}} >> shift_cl;
+    assign c_al     = c_ext[4*MANT+5:MANT+1];
+    assign c_sticky = |c_ext[MANT:0];
+
+endmodule
+
+// -------------------------------------------------------------------
+// Sum magnitude and leading-zero anticipation
+// -------------------------------------------------------------------
+module ffma_add #(
+    parameter MANT = 23
+)(
+    input  logic sign_p,
+    input  logic sign_c,
+    input  logic p_zero,
+    input  logic [2*MANT+1:0] pom_mant,     // product from fmul_mult
+    input  logic [3*MANT+4:0] c_al,
+    input  logic c_sticky,
+    output logic [3*MANT+6:0] sum,          // |a*b + c| in the sum window
+    output logic [$clog2(3*MANT+8) - 1:0] lz_pred,
+    output logic sign_s,
+    output logic sum_zero                   // exact cancellation
+);
+
+    localparam RW = 3*MANT + 7;
+
+    logic [RW - 1:0] x, z, big, small, lead;
+    logic sub, x_ge_z;
+
+    assign x   = p_zero ? '0 : {{(MANT+4){1'b0}}, pom_mant, 1'b0};
+    assign z   = {1'b0, c_al, c_sticky};
+    assign sub = sign_p ^ sign_c;
+
+    assign x_ge_z = (x >= z);
+    assign big    = x_ge_z ? x : z;
+    assign small  = x_ge_z ? z : x;
+
+    assign sum      = sub ? (big - small) : (x + z);
+    assign sum_zero = sub && (x == z);
+    assign sign_s   = (sub && !x_ge_z) ? sign_c : sign_p;
+
+    // Leading-one indicator from the operands, in parallel with the adder:
+    // the sum has its leading one at the top set bit of lead or one below.
+    // Subtraction uses the borrow pattern of big - small, addition is x | z
+    // moved up one place for the carry.
+    assign lead = sub ? ((big ^ small) & ~((~big & small) << 1)) : ((x | z) << 1);
+
+    always_comb begin
+        lz_pred = RW;
+        for (int k = 0; k < RW; k++) begin
+            if (lead[k]) lz_pred = RW - 1 - k;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// Normalize by the anticipated count plus a one-bit correction, and
+// hand the significand to fmul_round in the layout of a product
+// -------------------------------------------------------------------
+module ffma_norm #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [3*MANT+6:0] sum,
+    input  logic [$clog2(3*MANT+8) - 1:0] lz_pred,
+    input  logic signed [EXP+1:0] exp_base,
+    output logic [2*MANT+1:0] pom_norm,     // leading 1 at bit 2*MANT
+    output logic signed [EXP+1:0] exp_norm,
+    output logic inexact                    // guard or sticky bits set
+);
+
+    localparam RW = 3*MANT + 7;
+
+    logic [RW - 1:0] sum_sh, sum_n;
+    logic corr;
+    logic sticky;
+
+    assign sum_sh = sum << lz_pred;
+    assign corr   = !sum_sh[RW - 1];
+    assign sum_n  = corr ? (sum_sh << 1) : sum_sh;
+
+    assign exp_norm = exp_base + (MANT + 5) - $signed({1'b0, lz_pred}) - $signed({1'b0, corr});
+
+    // {0, 1.mantissa, guard, zeros, sticky}: fmul_round sees the same
+    // guard/sticky/LSB as from the full sum
+    assign sticky   = |sum_n[2*MANT+4:0];
+    assign pom_norm = {1'b0, sum_n[RW - 1:2*MANT+5], {(MANT-2){1'b0}}, sticky};
+    assign inexact  = sum_n[2*MANT+5] | sticky;
+
+endmodule
+
+// -------------------------------------------------------------------
+// Overflow / flush-to-zero checks and result packing
+// -------------------------------------------------------------------
+module ffma_pack #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic sign_s,
+    input  logic special,
+    input  logic spec_nan,
+    input  logic spec_inf,
+    input  logic spec_sign,
+    input  logic spec_invalid,
+    input  logic sum_zero,
+    input  logic round_inexact,
+    input  logic signed [EXP+1:0] exp_work,
+    input  logic [MANT - 1:0] mant_c,
+    output logic [EXP + MANT:0] y,
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact
+);
+
+    localparam logic signed [EXP+1:0] EXP_MAX = (1 << EXP) - 1;
+
+    always_comb begin
+        invalid   = 0;
+        overflow  = 0;
+        underflow = 0;
+        inexact   = 0;
+        y         = 0;
+
+        if (special) begin
+            invalid = spec_invalid;
+            if (spec_nan) begin
+                // constant qNaN
+                y = {1'b0, {EXP{1'b1}}, 1'b1, {(MANT-1){1'b0}}};
+            end else if (spec_inf) begin
+                y = {spec_sign, {EXP{1'b1}}, {MANT{1'b0}}};
+            end else begin
+                y = {spec_sign, {EXP{1'b0}}, {MANT{1'b0}}};
+            end
+        end else if (sum_zero) begin
+            // exact cancellation rounds to +0
+            y = {1'b0, {EXP{1'b0}}, {MANT{1'b0}}};
+        end else if (exp_work >= EXP_MAX) begin
+            y = {sign_s, {EXP{1'b1}}, {MANT{1'b0}}};
+            overflow = 1;
+            inexact = 1;
+        end else if (exp_work <= 0) begin
+            y = {sign_s, {EXP{1'b0}}, {MANT{1'b0}}};
+            underflow = 1;
+            inexact = 1;
+        end else begin
+            y = {sign_s, exp_work[EXP-1:0], mant_c};
+            inexact = round_inexact;
+        end
+    end
+
+endmodule
@@ -3,10 +3,16 @@
 module fmul #(
     parameter EXP = 8,
     parameter MANT = 23,
-    parameter BIAS = 127  
+    parameter BIAS = 127,
+    parameter MULT_IMPL = 0,   // significand multiplier, see fmul_mult.sv
+    parameter DSP_W = 17,
+    parameter FAST_ROUND = 0,  // injection rounding, see fmul_stages.sv
+    parameter SUBNORMAL_SUPPORT = 0,  // gradual underflow instead of DAZ/FTZ
+    parameter OPERAND_ISOLATION = 0   // multiplier operands gated for special cases
 )(
     input  logic [EXP + MANT:0] a,
     input  logic [EXP + MANT:0] b,
+    input  logic [2:0] rm,           // rounding mode, see fmul_rm_pkg
     output logic [EXP + MANT:0] y,
     output logic invalid,
     output logic overflow,
@@ -14,152 +20,157 @@ module fmul #(
     output logic inexact
 );
 
-    localparam DATA_WIDTH = 1 + EXP + MANT;
+    // Fully combinational: the datapath steps from fmul_stages.sv chained
+    // back to back. fmul_pipe registers the same steps.
 
     logic sign_c;
-    logic [EXP - 1:0] exp_a;
-    logic [EXP - 1:0] exp_b;
-    logic [EXP - 1:0] exp_c;
-    logic [2*MANT+1:0] pom_mant;
-    logic [MANT - 1:0] mant_a;
-    logic [MANT - 1:0] mant_b;
+    logic special, spec_nan, spec_inf, spec_invalid;
+    logic [MANT:0] sig_a_u, sig_a_n, sig_a;
+    logic [MANT:0] sig_b_u, sig_b_n, sig_b;
+    logic [2*MANT+1:0] pom_norm;
     logic [MANT - 1:0] mant_c;
+    logic round_inexact;
+    logic tiny;
 
-    logic a_isZero, a_isSub, a_isNaN, a_isInf;
-    logic b_isZero, b_isSub, b_isNaN, b_isInf;
-
-    logic [MANT:0] mant_pom;
-    
+    logic signed [EXP+1:0] exp_unpack;
     logic signed [EXP+1:0] exp_work;
+    logic signed [EXP+1:0] exp_norm;
+    logic signed [EXP+1:0] exp_round;
 
-    assign sign_c = a[DATA_WIDTH - 1] ^ b[DATA_WIDTH - 1]; 
-    assign exp_a  = a[DATA_WIDTH - 2:MANT];
-    assign exp_b  = b[DATA_WIDTH - 2:MANT];
-    assign mant_a = a[MANT - 1:0];
-    assign mant_b = b[MANT - 1:0];
-    
-    always_comb begin
-    
-        invalid = 0;
-        overflow = 0;
-        underflow = 0;
-        inexact = 0;
-        y = 0;
-   
-        exp_work = 0;
-        pom_mant = 0;
-        mant_pom = 0;
-        y = 0;
-        a_isZero = 0;
-        a_isSub  = 0;
-        a_isInf  = 0;
-        a_isNaN  = 0;
-        b_isZero = 0;
-        b_isSub  = 0;
-        b_isInf  = 0;
-        b_isNaN  = 0;
-
-        exp_c    = 0;
-        mant_c   = 0;
-        pom_mant = 0;   // added
-        mant_pom = 0;   // added
-        y      = 0;   // added
-
-        if (exp_a == 0 && mant_a == 0) begin
-            a_isZero = 1;
-        end else if (exp_a == 0 && mant_a != 0) begin
-            a_isSub = 1;
-        end else if (exp_a == {EXP{1'b1}} && mant_a == 0) begin
-            a_isInf = 1;
-        end else if (exp_a == {EXP{1'b1}} && mant_a != 0) begin
-            a_isNaN = 1;
-        end
-        
-        if (exp_b == 0 && mant_b == 0) begin
-            b_isZero = 1;
-        end else if (exp_b == 0 && mant_b != 0) begin
-            b_isSub = 1;
-        end else if (exp_b == {EXP{1'b1}} && mant_b == 0) begin
-            b_isInf = 1;
-        end else if (exp_b == {EXP{1'b1}} && mant_b != 0) begin
-            b_isNaN = 1;
+    fmul_unpack #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_unpack (
+        .a        (a),
+        .b        (b),
+        .sign_c   (sign_c),
+        .special  (special),
+        .spec_nan (spec_nan),
+        .spec_inf (spec_inf),
+        .invalid  (spec_invalid),
+        .exp_work (exp_unpack),
+        .sig_a    (sig_a_u),
+        .sig_b    (sig_b_u)
+    );
+
+    fmul_subnorm_in #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_subnorm_in (
+        .sig_a    (sig_a_u),
+        .sig_b    (sig_b_u),
+        .exp_work (exp_unpack),
+        .sig_a_n  (sig_a_n),
+        .sig_b_n  (sig_b_n),
+        .exp_n    (exp_work)
+    );
+
+    fmul_isolate #(.MANT(MANT), .EN(OPERAND_ISOLATION)) u_isolate (
+        .gate    (special),
+        .sig_a   (sig_a_n),
+        .sig_b   (sig_b_n),
+        .sig_a_o (sig_a),
+        .sig_b_o (sig_b)
+    );
+
+    generate
+        if (FAST_ROUND && SUBNORMAL_SUPPORT) begin : g_bad_fast_subnorm
+            $error("fmul: FAST_ROUND rounds at the normal LSB only, not with SUBNORMAL_SUPPORT");
         end
-        
-        if (a_isNaN || b_isNaN) begin
-        // at least one is NaN -> c = NaN
-          //  invalid = 1;  
-            exp_c = {EXP{1'b1}};
-            mant_c[MANT-1]   = 1'b1; 
-            mant_c[MANT-2:0] = 0;
-            y = {1'b0, exp_c, mant_c};
-        end else if (((a_isZero || a_isSub) && b_isInf) || (a_isInf && (b_isZero || b_isSub))) begin
-        // 0 * infinity  or  subnormal * infinity -> c = NaN, inv flag
-            invalid = 1;
-            exp_c = {EXP{1'b1}};
-            mant_c[MANT-1]   = 1'b1;
-            mant_c[MANT-2:0] = 0;
-            y = {1'b0, exp_c, mant_c};
-        end else if (a_isInf || b_isInf) begin
-         // one is infinite -> c = inf
-            exp_c = {EXP{1'b1}};
-            mant_c = 0;
-            y = {sign_c, exp_c, mant_c};
-        end else if (a_isZero || b_isZero || a_isSub || b_isSub) begin
-        //zero or subnormal -> c = zero
-            exp_c = 0;
-            mant_c = 0;
-            y = {sign_c, exp_c, mant_c};
-        end else begin
-            //exp_c = exp_a + exp_b - BIAS;
-            exp_work = $signed({1'b0, exp_a}) + $signed({1'b0, exp_b}) - BIAS;
-            pom_mant = {1'b1, mant_a} * {1'b1, mant_b};
-
-            if (pom_mant[2*MANT+1] == 1'b1) begin
-                pom_mant = pom_mant >> 1;
-                exp_work = exp_work + 1;
-            end
-
-            if (pom_mant[MANT - 1] == 1'b0) begin
-                mant_c = pom_mant[2*MANT - 1:MANT];
-            end else begin
-                if (|pom_mant[MANT - 2:0]) begin
-                    mant_pom = {1'b0, pom_mant[2*MANT - 1:MANT]} + 1'b1;
-                    if (mant_pom[MANT] == 1'b1) begin
-                        mant_c = {MANT{1'b0}};
-                        exp_work = exp_work + 1;;
-                    end else begin
-                        mant_c = mant_pom[MANT-1:0];
-                    end
-                end else begin
-                    if (pom_mant[MANT] == 1'b1) begin
-                        mant_pom = {1'b0, pom_mant[2*MANT - 1:MANT]} + 1'b1;
-                        if (mant_pom[MANT] == 1'b1) begin
-                            mant_c = {MANT{1'b0}};
-                            exp_work = exp_work + 1;;
-                        end else begin
-                            mant_c = mant_pom[MANT-1:0];
-                        end
-                    end else begin
-                        mant_c = pom_mant[2*MANT - 1:MANT];
-                    end
-                end
-            end
-            
-            if (exp_work >= 255) begin
-                y = {sign_c, {EXP{1'b1}}, {MANT{1'b0}}};
-                overflow = 1;
-                inexact = 1;
-            end else if (exp_work <= 0) begin
-                y = {sign_c, {EXP{1'b0}}, {MANT{1'b0}}};
-                underflow = 1;
-                inexact = 1;
-            end else begin
-                exp_c = exp_work[EXP-1:0];
-                y = {sign_c, exp_c, mant_c};
-            end
+
+        if (FAST_ROUND) begin : g_fast
+            logic [2*MANT+1:0] pom_lo;
+            logic [2*MANT+1:0] pom_hi;
+            logic tie_lo, tie_hi, tie;
+            logic inexact_lo, inexact_hi;
+
+            fmul_mult_inj #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_mult (
+                .sig_a      (sig_a),
+                .sig_b      (sig_b),
+                .sign_c     (sign_c),
+                .rm         (rm),
+                .pom_lo     (pom_lo),
+                .pom_hi     (pom_hi),
+                .tie_lo     (tie_lo),
+                .tie_hi     (tie_hi),
+                .inexact_lo (inexact_lo),
+                .inexact_hi (inexact_hi)
+            );
+
+            fmul_norm_inj #(.EXP(EXP), .MANT(MANT)) u_norm (
+                .pom_lo     (pom_lo),
+                .pom_hi     (pom_hi),
+                .tie_lo     (tie_lo),
+                .tie_hi     (tie_hi),
+                .inexact_lo (inexact_lo),
+                .inexact_hi (inexact_hi),
+                .exp_work   (exp_work),
+                .pom_norm   (pom_norm),
+                .exp_norm   (exp_norm),
+                .tie        (tie),
+                .inexact    (round_inexact)
+            );
+
+            fmul_round_inj #(.EXP(EXP), .MANT(MANT)) u_round (
+                .pom_mant  (pom_norm),
+                .exp_work  (exp_norm),
+                .tie       (tie),
+                .rm        (rm),
+                .mant_c    (mant_c),
+                .exp_round (exp_round)
+            );
+
+            assign tiny = 1'b0;
+        end else begin : g_exact
+            logic [2*MANT+1:0] pom_mant;
+            logic [2*MANT+1:0] pom_full;
+            logic signed [EXP+1:0] exp_full;
+
+            fmul_mult #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_mult (
+                .sig_a    (sig_a),
+                .sig_b    (sig_b),
+                .pom_mant (pom_mant)
+            );
+
+            fmul_norm #(.EXP(EXP), .MANT(MANT)) u_norm (
+                .pom_mant (pom_mant),
+                .exp_work (exp_work),
+                .pom_norm (pom_full),
+                .exp_norm (exp_full)
+            );
+
+            fmul_subnorm_out #(.EXP(EXP), .MANT(MANT), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_subnorm_out (
+                .pom_norm (pom_full),
+                .exp_norm (exp_full),
+                .sign_c   (sign_c),
+                .rm       (rm),
+                .pom_den  (pom_norm),
+                .exp_den  (exp_norm),
+                .tiny     (tiny)
+            );
+
+            fmul_round #(.EXP(EXP), .MANT(MANT)) u_round (
+                .pom_mant  (pom_norm),
+                .exp_work  (exp_norm),
+                .sign_c    (sign_c),
+                .rm        (rm),
+                .mant_c    (mant_c),
+                .exp_round (exp_round),
+                .inexact   (round_inexact)
+            );
         end
-        
-         
-    end 
+    endgenerate
+
+    fmul_pack #(.EXP(EXP), .MANT(MANT), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_pack (
+        .sign_c        (sign_c),
+        .special       (special),
+        .spec_nan      (spec_nan),
+        .spec_inf      (spec_inf),
+        .spec_invalid  (spec_invalid),
+        .exp_work      (exp_round),
+        .mant_c        (mant_c),
+        .rm            (rm),
+        .round_inexact (round_inexact),
+        .tiny          (tiny),
+        .y             (y),
+        .invalid       (invalid),
+        .overflow      (overflow),
+        .underflow     (underflow),
+        .inexact       (inexact)
+    );
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,235 @@
+`timescale 1ns / 1ps
+
+// Significand multiplier implementations, selected by MULT_IMPL.
+//
+//   MULT_IMPL | partial products                  | reduction
+//   ----------+-----------------------------------+--------------------
+//       0     | sig_a * sig_b, left to synthesis  | -
+//       1     | radix-4 Booth, MANT/2+2 rows      | Wallace tree
+//       2     | radix-4 Booth, MANT/2+2 rows      | Dadda tree
+//       3     | DSP_W x DSP_W tiles (DSP slices)  | Wallace tree
+//
+// The multiplier is split into three parts so a pipeline register can be
+// placed at any level of the tree (fmul_pipe TREE_REG):
+//
+//   fmul_mult_pp -> fmul_mult_tree (levels 0..L) -> fmul_mult_cpa
+//
+// Partial products are PW = 2*MANT+2 bit rows whose sum modulo 2^PW is the
+// product. The trees work on whole rows with 3:2 carry-save adders: Wallace
+// compresses every group of three rows on each level, Dadda reduces each
+// level only down to the next height of 2, 3, 4, 6, 9, 13, 19, 28, ...
+// and leaves the other rows alone. The constant-zero bits of the shifted
+// rows are removed by synthesis. The last two rows go to one carry-propagate
+// adder.
+//
+// DSP tiles: the significands are cut into DSP_W bit pieces (17 fits the
+// unsigned operand of an 18x18 signed slice), one inferred product per pair
+// of pieces. For binary32 that is 17x17, 17x7 and 7x17 on three slices and a
+// 7x7 corner small enough for fabric.
+
+package fmul_mult_pkg;
+
+    // Partial product rows of a MANT+1 bit significand multiply
+    function automatic int mult_pp_rows(input int impl, input int mant, input int dsp_w);
+        if (impl == 1 || impl == 2) begin
+            // one row per Booth digit, plus the row of negate corrections
+            return (mant + 1) / 2 + 2;
+        end else if (impl == 3) begin
+            return ((mant + dsp_w) / dsp_w) * ((mant + dsp_w) / dsp_w);
+        end
+        return 1;
+    endfunction
+
+    // 3:2 compressors used on a tree level that starts with rows rows
+    function automatic int mult_csa_count(input int impl, input int rows);
+        int d;
+        if (rows <= 2) return 0;
+        if (impl == 2) begin
+            d = 2;
+            while (d * 3 / 2 < rows) d = d * 3 / 2;
+            return rows - d;
+        end
+        return rows / 3;
+    endfunction
+
+    // Rows left after level tree levels
+    function automatic int mult_rows_at(input int impl, input int rows0, input int level);
+        int rows;
+        rows = rows0;
+        for (int l = 0; l < level; l++) rows -= mult_csa_count(impl, rows);
+        return rows;
+    endfunction
+
+    // Tree levels down to two rows
+    function automatic int mult_levels(input int impl, input int rows0);
+        int rows, levels;
+        rows   = rows0;
+        levels = 0;
+        while (rows > 2) begin
+            rows -= mult_csa_count(impl, rows);
+            levels++;
+        end
+        return levels;
+    endfunction
+
+endpackage
+
+// -------------------------------------------------------------------
+// Partial product generation
+// -------------------------------------------------------------------
+module fmul_mult_pp #(
+    parameter MANT = 23,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17
+)(
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    output logic [fmul_mult_pkg::mult_pp_rows(MULT_IMPL, MANT, DSP_W)*(2*MANT+2) - 1:0] rows
+);
+
+    localparam N  = MANT + 1;
+    localparam PW = 2*MANT + 2;
+
+    generate
+        if (MULT_IMPL == 1 || MULT_IMPL == 2) begin : g_booth
+            // Digit k recodes b bits 2k+1, 2k, 2k-1 into {-2..2}; the zero
+            // padding on top keeps the unsigned multiplier positive
+            localparam ND = N/2 + 1;
+
+            logic [2*ND:0] b_ext;
+            logic [ND - 1:0] neg;
+            logic [PW - 1:0] corr;
+
+            assign b_ext = {{(2*ND - N){1'b0}}, sig_b, 1'b0};
+
+            for (genvar k = 0; k < ND; k++) begin : g_digit
+                logic d0, d1, d2, one, two;
+                logic [PW - 1:0] mag;
+
+                assign {d2, d1, d0} = b_ext[2*k +: 3];
+                assign one    = d1 ^ d0;
+                assign two    = (d2 & ~d1 & ~d0) | (~d2 & d1 & d0);
+                assign neg[k] = d2 & ~(d1 & d0);
+                assign mag    = one ? PW'(sig_a) : two ? (PW'(sig_a) << 1) : '0;
+
+                // -x = ~x + 1, the +1 goes into the correction row
+                assign rows[k*PW +: PW] = (neg[k] ? ~mag : mag) << (2*k);
+            end
+
+            always_comb begin
+                corr = '0;
+                for (int k = 0; k < ND; k++) corr[2*k] = neg[k];
+            end
+
+            assign rows[ND*PW +: PW] = corr;
+        end else if (MULT_IMPL == 3) begin : g_dsp
+            localparam T = (N + DSP_W - 1) / DSP_W;
+
+            logic [T*DSP_W - 1:0] a_p;
+            logic [T*DSP_W - 1:0] b_p;
+
+            assign a_p = (T*DSP_W)'(sig_a);
+            assign b_p = (T*DSP_W)'(sig_b);
+
+            for (genvar i = 0; i < T; i++) begin : g_a
+                for (genvar j = 0; j < T; j++) begin : g_b
+                    logic [2*DSP_W - 1:0] p;
+
+                    assign p = a_p[i*DSP_W +: DSP_W] * b_p[j*DSP_W +: DSP_W];
+                    assign rows[(i*T + j)*PW +: PW] = PW'(p) << (DSP_W*(i + j));
+                end
+            end
+        end else begin : g_infer
+            assign rows = sig_a * sig_b;
+        end
+    endgenerate
+
+endmodule
+
+// -------------------------------------------------------------------
+// Carry-save reduction from tree level FROM to level TO
+// -------------------------------------------------------------------
+module fmul_mult_tree #(
+    parameter MANT = 23,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17,
+    parameter FROM = 0,
+    parameter TO = 0
+)(
+    input  logic [fmul_mult_pkg::mult_rows_at(MULT_IMPL, fmul_mult_pkg::mult_pp_rows(MULT_IMPL, MANT, DSP_W), FROM)*(2*MANT+2) - 1:0] rows_i,
+    output logic [fmul_mult_pkg::mult_rows_at(MULT_IMPL, fmul_mult_pkg::mult_pp_rows(MULT_IMPL, MANT, DSP_W), TO)*(2*MANT+2) - 1:0] rows_o
+);
+
+    import fmul_mult_pkg::*;
+
+    localparam PW    = 2*MANT + 2;
+    localparam ROWS0 = mult_pp_rows(MULT_IMPL, MANT, DSP_W);
+
+    generate
+        if (FROM < 0 || TO < FROM || TO > mult_levels(MULT_IMPL, ROWS0)) begin : g_bad_levels
+            $error("fmul_mult_tree: need 0 <= FROM <= TO <= tree levels");
+        end
+
+        if (TO == FROM) begin : g_pass
+            assign rows_o = rows_i;
+        end else begin : g_tree
+            // lvl[l].r holds the rows entering level l
+            for (genvar l = FROM; l <= TO; l++) begin : lvl
+                localparam NI = mult_rows_at(MULT_IMPL, ROWS0, l);
+                logic [NI*PW - 1:0] r;
+            end
+
+            assign lvl[FROM].r = rows_i;
+            assign rows_o      = lvl[TO].r;
+
+            for (genvar l = FROM; l < TO; l++) begin : g_level
+                localparam NI = mult_rows_at(MULT_IMPL, ROWS0, l);
+                localparam NC = mult_csa_count(MULT_IMPL, NI);
+
+                for (genvar k = 0; k < NC; k++) begin : g_csa
+                    logic [PW - 1:0] x, y, z;
+
+                    assign x = lvl[l].r[(3*k)*PW +: PW];
+                    assign y = lvl[l].r[(3*k + 1)*PW +: PW];
+                    assign z = lvl[l].r[(3*k + 2)*PW +: PW];
+
+                    assign lvl[l + 1].r[(2*k)*PW +: PW]     = x ^ y ^ z;
+                    assign lvl[l + 1].r[(2*k + 1)*PW +: PW] = ((x & y) | (x & z) | (y & z)) << 1;
+                end
+
+                // Rows without a compressor on this level pass through
+                if (NI > 3*NC) begin : g_pass_rows
+                    assign lvl[l + 1].r[2*NC*PW +: (NI - 3*NC)*PW] = lvl[l].r[NI*PW - 1:3*NC*PW];
+                end
+            end
+        end
+    endgenerate
+
+endmodule
+
+// -------------------------------------------------------------------
+// Final carry-propagate add of the last one or two rows. inj is added in
+// the same adder (rounding injection, see fmul_inj), '0 for a plain product.
+// -------------------------------------------------------------------
+module fmul_mult_cpa #(
+    parameter MANT = 23,
+    parameter ROWS = 2
+)(
+    input  logic [ROWS*(2*MANT+2) - 1:0] rows_i,
+    input  logic [2*MANT+1:0] inj,
+    output logic [2*MANT+1:0] pom_mant
+);
+
+    localparam PW = 2*MANT + 2;
+
+    generate
+        if (ROWS == 1) begin : g_one
+            assign pom_mant = rows_i + inj;
+        end else if (ROWS == 2) begin : g_two
+            assign pom_mant = rows_i[PW - 1:0] + rows_i[2*PW - 1:PW] + inj;
+        end else begin : g_bad_rows
+            $error("fmul_mult_cpa: ROWS must be 1 or 2");
+        end
+    endgenerate
+
+endmodule
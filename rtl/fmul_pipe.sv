@@ -0,0 +1,594 @@
+`timescale 1ns / 1ps
+
+// Pipelined floating-point multiplier.
+//
+// Same datapath steps as fmul (see fmul_stages.sv) with STAGES pipeline
+// registers placed between them. Latency is STAGES cycles, throughput is one
+// result per cycle. Every stage register is a valid/ready slice, so bubbles
+// are collapsed and out_ready back-pressure stalls only the stages that are
+// actually full.
+//
+// LANES > 1 replicates the datapath over packed operand buses, lane i in bits
+// [i*W +: W]. All lanes share one valid/ready chain, so they move through the
+// pipeline together (see fmul_vec).
+//
+// Register placement (bit k = register after step k):
+//
+//   STAGES | unpack | mult | norm | round | pack
+//   -------+--------+------+------+-------+-----
+//      1   |        |      |      |       |  x
+//      2   |        |  x   |      |       |  x
+//      3   |   x    |  x   |      |       |  x
+//      4   |   x    |  x   |      |   x   |  x
+//      5   |   x    |  x   |  x   |   x   |  x
+//
+// TREE_REG >= 0 adds one more register inside the multiplier, after that
+// many levels of its reduction tree (0: right after the partial products,
+// see fmul_mult.sv for MULT_IMPL and the level count). Latency is then
+// STAGES + 1 cycles. -1 (default) leaves the multiplier unsplit.
+//
+// FAST_ROUND = 1 uses the injection-rounding steps (fmul_mult_inj,
+// fmul_norm_inj, fmul_round_inj) in the same register slots; the tie flags
+// and inexact flags from fmul_tie travel with the tree rows.
+//
+// SUBNORMAL_SUPPORT = 1 adds the fmul_subnorm_in and fmul_subnorm_out steps,
+// each followed by its own register so the leading-zero shift and the
+// denormalizing shift do not lengthen a stage of the normal path. Latency
+// is then 2 cycles more.
+//
+// rm is sampled with a and b and travels with the operands, so every
+// transaction can use its own rounding mode (shared by all lanes).
+//
+// Low power, results unchanged:
+//  - OPERAND_ISOLATION = 1 gates the multiplier operands to zero for a
+//    special case and while no valid operands are at the multiplier
+//    (fmul_isolate), so zeros, NaN/Inf and bubbles do not toggle the tree
+//  - CLOCK_GATE = 1 clocks the data of every stage register through a
+//    clock gate (fmul_clk_gate) enabled by the load condition, so idle
+//    stages are not clocked while in_valid is low. The data registers load
+//    only valid entries either way, which a synthesis tool can map to
+//    clock gates itself; CLOCK_GATE makes the gating explicit in the RTL.
+
+module fmul_pipe #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter STAGES = 3,
+    parameter LANES = 1,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17,
+    parameter TREE_REG = -1,
+    parameter FAST_ROUND = 0,
+    parameter SUBNORMAL_SUPPORT = 0,
+    parameter OPERAND_ISOLATION = 0,
+    parameter CLOCK_GATE = 0
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] a,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] b,
+    input  logic [2:0] rm,
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [LANES*(1 + EXP + MANT) - 1:0] y,
+    output logic [LANES - 1:0] invalid,
+    output logic [LANES - 1:0] overflow,
+    output logic [LANES - 1:0] underflow,
+    output logic [LANES - 1:0] inexact
+);
+
+    import fmul_mult_pkg::*;
+
+    localparam W = 1 + EXP + MANT;
+
+    // Multiplier tree, split at TREE_SPLIT levels for the optional register
+    localparam PW          = 2*MANT + 2;
+    localparam TREE_ROWS0  = mult_pp_rows(MULT_IMPL, MANT, DSP_W);
+    localparam TREE_LEVELS = mult_levels(MULT_IMPL, TREE_ROWS0);
+    localparam TREE_SPLIT  = (TREE_REG < 0) ? TREE_LEVELS : TREE_REG;
+    localparam TREE_MID    = mult_rows_at(MULT_IMPL, TREE_ROWS0, TREE_SPLIT);
+    localparam TREE_ROWS   = mult_rows_at(MULT_IMPL, TREE_ROWS0, TREE_LEVELS);
+
+    localparam logic [4:0] REG_MASK = (STAGES == 1) ? 5'b10000 :
+                                      (STAGES == 2) ? 5'b10010 :
+                                      (STAGES == 3) ? 5'b10011 :
+                                      (STAGES == 4) ? 5'b11011 :
+                                                      5'b11111;
+
+    generate
+        if (STAGES < 1 || STAGES > 5) begin : g_bad_stages
+            $error("fmul_pipe: STAGES must be in 1..5");
+        end
+        if (LANES < 1) begin : g_bad_lanes
+            $error("fmul_pipe: LANES must be at least 1");
+        end
+        if (TREE_REG > TREE_LEVELS) begin : g_bad_tree_reg
+            $error("fmul_pipe: TREE_REG is beyond the last level of the multiplier tree");
+        end
+        if (FAST_ROUND && SUBNORMAL_SUPPORT) begin : g_bad_fast_subnorm
+            $error("fmul_pipe: FAST_ROUND rounds at the normal LSB only, not with SUBNORMAL_SUPPORT");
+        end
+    endgenerate
+
+    // Special-case decision, carried along until pack
+    typedef struct packed {
+        logic sign_c;
+        logic special;
+        logic spec_nan;
+        logic spec_inf;
+        logic spec_invalid;
+        logic [2:0] rm;
+    } ctl_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_work;
+        logic [MANT:0] sig_a;
+        logic [MANT:0] sig_b;
+    } unpack_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_work;
+        logic [TREE_MID*PW - 1:0] rows;
+        logic tie_lo;
+        logic tie_hi;
+        logic inexact_lo;
+        logic inexact_hi;
+    } tree_t;
+
+    // FAST_ROUND: pom_mant/pom_hi are the two injected sums, otherwise
+    // pom_mant is the product and pom_hi is unused
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_work;
+        logic [2*MANT+1:0] pom_mant;
+        logic [2*MANT+1:0] pom_hi;
+        logic tie_lo;
+        logic tie_hi;
+        logic inexact_lo;
+        logic inexact_hi;
+    } mult_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_work;
+        logic [2*MANT+1:0] pom_mant;
+        logic tie;
+        logic inexact;   // FAST_ROUND only
+        logic tiny;      // set by fmul_subnorm_out
+    } norm_t;
+
+    typedef struct packed {
+        ctl_t ctl;
+        logic signed [EXP+1:0] exp_work;
+        logic [MANT - 1:0] mant_c;
+        logic inexact;
+        logic tiny;
+    } round_t;
+
+    typedef struct packed {
+        logic [EXP + MANT:0] y;
+        logic invalid;
+        logic overflow;
+        logic underflow;
+        logic inexact;
+    } pack_t;
+
+    // _d: step output, _q: after (optional) stage register, one entry per lane
+    unpack_t [LANES - 1:0] s1_d, s1_q;
+    unpack_t [LANES - 1:0] si_d, si_q;   // subnormal inputs normalized
+    tree_t   [LANES - 1:0] st_d, st_q;
+    mult_t   [LANES - 1:0] s2_d, s2_q;
+    norm_t   [LANES - 1:0] s3_d, s3_q;
+    norm_t   [LANES - 1:0] so_d, so_q;   // tiny results denormalized
+    round_t  [LANES - 1:0] s4_d, s4_q;
+    pack_t   [LANES - 1:0] s5_d, s5_q;
+
+    // vld[k]/rdy[k]: handshake between stage register k and k+1 in datapath
+    // order: unpack, subnorm_in, tree, mult, norm, subnorm_out, round, pack
+    logic [8:0] vld;
+    logic [8:0] rdy;
+
+    assign vld[0]   = in_valid;
+    assign in_ready = rdy[0];
+
+    // ---------------------------------------------------------------
+    // Datapath steps, one copy per lane
+    // ---------------------------------------------------------------
+    generate
+        for (genvar i = 0; i < LANES; i++) begin : g_lane
+            // Step 1: unpack / classify
+            fmul_unpack #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_unpack (
+                .a        (a[i*W +: W]),
+                .b        (b[i*W +: W]),
+                .sign_c   (s1_d[i].ctl.sign_c),
+                .special  (s1_d[i].ctl.special),
+                .spec_nan (s1_d[i].ctl.spec_nan),
+                .spec_inf (s1_d[i].ctl.spec_inf),
+                .invalid  (s1_d[i].ctl.spec_invalid),
+                .exp_work (s1_d[i].exp_work),
+                .sig_a    (s1_d[i].sig_a),
+                .sig_b    (s1_d[i].sig_b)
+            );
+
+            assign s1_d[i].ctl.rm = rm;
+
+            // Subnormal inputs: leading-zero normalize
+            assign si_d[i].ctl = s1_q[i].ctl;
+
+            fmul_subnorm_in #(.EXP(EXP), .MANT(MANT), .BIAS(BIAS), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_subnorm_in (
+                .sig_a    (s1_q[i].sig_a),
+                .sig_b    (s1_q[i].sig_b),
+                .exp_work (s1_q[i].exp_work),
+                .sig_a_n  (si_d[i].sig_a),
+                .sig_b_n  (si_d[i].sig_b),
+                .exp_n    (si_d[i].exp_work)
+            );
+
+            // Step 2: significand multiply, partial products and the
+            // tree levels before TREE_SPLIT, then the rest of the tree
+            logic [TREE_ROWS0*PW - 1:0] pp;
+            logic [TREE_ROWS*PW - 1:0] sum_rows;
+            logic [MANT:0] sig_a_m, sig_b_m;
+
+            assign st_d[i].ctl      = si_q[i].ctl;
+            assign st_d[i].exp_work = si_q[i].exp_work;
+
+            fmul_isolate #(.MANT(MANT), .EN(OPERAND_ISOLATION)) u_isolate (
+                .gate    (si_q[i].ctl.special || !vld[2]),
+                .sig_a   (si_q[i].sig_a),
+                .sig_b   (si_q[i].sig_b),
+                .sig_a_o (sig_a_m),
+                .sig_b_o (sig_b_m)
+            );
+
+            fmul_mult_pp #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_pp (
+                .sig_a (sig_a_m),
+                .sig_b (sig_b_m),
+                .rows  (pp)
+            );
+
+            fmul_mult_tree #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W),
+                             .FROM(0), .TO(TREE_SPLIT)) u_tree_lo (
+                .rows_i (pp),
+                .rows_o (st_d[i].rows)
+            );
+
+            assign s2_d[i].ctl      = st_q[i].ctl;
+            assign s2_d[i].exp_work = st_q[i].exp_work;
+
+            fmul_mult_tree #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W),
+                             .FROM(TREE_SPLIT), .TO(TREE_LEVELS)) u_tree_hi (
+                .rows_i (st_q[i].rows),
+                .rows_o (sum_rows)
+            );
+
+            fmul_tie #(.MANT(MANT)) u_tie (
+                .sig_a      (sig_a_m),
+                .sig_b      (sig_b_m),
+                .tie_lo     (st_d[i].tie_lo),
+                .tie_hi     (st_d[i].tie_hi),
+                .inexact_lo (st_d[i].inexact_lo),
+                .inexact_hi (st_d[i].inexact_hi)
+            );
+
+            assign s2_d[i].tie_lo     = st_q[i].tie_lo;
+            assign s2_d[i].tie_hi     = st_q[i].tie_hi;
+            assign s2_d[i].inexact_lo = st_q[i].inexact_lo;
+            assign s2_d[i].inexact_hi = st_q[i].inexact_hi;
+
+            // Step 3: normalize, then shift tiny results to the subnormal
+            // position
+            assign s3_d[i].ctl  = s2_q[i].ctl;
+            assign s3_d[i].tiny = 1'b0;
+
+            assign so_d[i].ctl     = s3_q[i].ctl;
+            assign so_d[i].tie     = s3_q[i].tie;
+            assign so_d[i].inexact = s3_q[i].inexact;
+
+            fmul_subnorm_out #(.EXP(EXP), .MANT(MANT), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_subnorm_out (
+                .pom_norm (s3_q[i].pom_mant),
+                .exp_norm (s3_q[i].exp_work),
+                .sign_c   (s3_q[i].ctl.sign_c),
+                .rm       (s3_q[i].ctl.rm),
+                .pom_den  (so_d[i].pom_mant),
+                .exp_den  (so_d[i].exp_work),
+                .tiny     (so_d[i].tiny)
+            );
+
+            // Step 4: round
+            assign s4_d[i].ctl  = so_q[i].ctl;
+            assign s4_d[i].tiny = so_q[i].tiny;
+
+            if (FAST_ROUND) begin : g_fast
+                logic [PW - 1:0] inj_lo, inj_hi;
+
+                fmul_inj #(.MANT(MANT)) u_inj (
+                    .sign_c (st_q[i].ctl.sign_c),
+                    .rm     (st_q[i].ctl.rm),
+                    .inj_lo (inj_lo),
+                    .inj_hi (inj_hi)
+                );
+
+                fmul_mult_cpa #(.MANT(MANT), .ROWS(TREE_ROWS)) u_cpa_lo (
+                    .rows_i   (sum_rows),
+                    .inj      (inj_lo),
+                    .pom_mant (s2_d[i].pom_mant)
+                );
+
+                fmul_mult_cpa #(.MANT(MANT), .ROWS(TREE_ROWS)) u_cpa_hi (
+                    .rows_i   (sum_rows),
+                    .inj      (inj_hi),
+                    .pom_mant (s2_d[i].pom_hi)
+                );
+
+                fmul_norm_inj #(.EXP(EXP), .MANT(MANT)) u_norm (
+                    .pom_lo     (s2_q[i].pom_mant),
+                    .pom_hi     (s2_q[i].pom_hi),
+                    .tie_lo     (s2_q[i].tie_lo),
+                    .tie_hi     (s2_q[i].tie_hi),
+                    .inexact_lo (s2_q[i].inexact_lo),
+                    .inexact_hi (s2_q[i].inexact_hi),
+                    .exp_work   (s2_q[i].exp_work),
+                    .pom_norm   (s3_d[i].pom_mant),
+                    .exp_norm   (s3_d[i].exp_work),
+                    .tie        (s3_d[i].tie),
+                    .inexact    (s3_d[i].inexact)
+                );
+
+                fmul_round_inj #(.EXP(EXP), .MANT(MANT)) u_round (
+                    .pom_mant  (so_q[i].pom_mant),
+                    .exp_work  (so_q[i].exp_work),
+                    .tie       (so_q[i].tie),
+                    .rm        (so_q[i].ctl.rm),
+                    .mant_c    (s4_d[i].mant_c),
+                    .exp_round (s4_d[i].exp_work)
+                );
+
+                assign s4_d[i].inexact = so_q[i].inexact;
+            end else begin : g_exact
+                fmul_mult_cpa #(.MANT(MANT), .ROWS(TREE_ROWS)) u_cpa (
+                    .rows_i   (sum_rows),
+                    .inj      ('0),
+                    .pom_mant (s2_d[i].pom_mant)
+                );
+
+                assign s2_d[i].pom_hi  = '0;
+                assign s3_d[i].tie     = 1'b0;
+                assign s3_d[i].inexact = 1'b0;
+
+                fmul_norm #(.EXP(EXP), .MANT(MANT)) u_norm (
+                    .pom_mant (s2_q[i].pom_mant),
+                    .exp_work (s2_q[i].exp_work),
+                    .pom_norm (s3_d[i].pom_mant),
+                    .exp_norm (s3_d[i].exp_work)
+                );
+
+                fmul_round #(.EXP(EXP), .MANT(MANT)) u_round (
+                    .pom_mant  (so_q[i].pom_mant),
+                    .exp_work  (so_q[i].exp_work),
+                    .sign_c    (so_q[i].ctl.sign_c),
+                    .rm        (so_q[i].ctl.rm),
+                    .mant_c    (s4_d[i].mant_c),
+                    .exp_round (s4_d[i].exp_work),
+                    .inexact   (s4_d[i].inexact)
+                );
+            end
+
+            // Step 5: overflow / FTZ checks and pack
+            fmul_pack #(.EXP(EXP), .MANT(MANT), .SUBNORMAL(SUBNORMAL_SUPPORT)) u_pack (
+                .sign_c        (s4_q[i].ctl.sign_c),
+                .special       (s4_q[i].ctl.special),
+                .spec_nan      (s4_q[i].ctl.spec_nan),
+                .spec_inf      (s4_q[i].ctl.spec_inf),
+                .spec_invalid  (s4_q[i].ctl.spec_invalid),
+                .exp_work      (s4_q[i].exp_work),
+                .mant_c        (s4_q[i].mant_c),
+                .rm            (s4_q[i].ctl.rm),
+                .round_inexact (s4_q[i].inexact),
+                .tiny          (s4_q[i].tiny),
+                .y             (s5_d[i].y),
+                .invalid       (s5_d[i].invalid),
+                .overflow      (s5_d[i].overflow),
+                .underflow     (s5_d[i].underflow),
+                .inexact       (s5_d[i].inexact)
+            );
+
+            assign y[i*W +: W]  = s5_q[i].y;
+            assign invalid[i]   = s5_q[i].invalid;
+            assign overflow[i]  = s5_q[i].overflow;
+            assign underflow[i] = s5_q[i].underflow;
+            assign inexact[i]   = s5_q[i].inexact;
+        end
+    endgenerate
+
+    // ---------------------------------------------------------------
+    // Stage registers, shared by all lanes
+    // ---------------------------------------------------------------
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(unpack_t)), .EN(REG_MASK[0]), .CG(CLOCK_GATE != 0)) u_reg1 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[0]),
+        .in_ready  (rdy[0]),
+        .in_data   (s1_d),
+        .out_valid (vld[1]),
+        .out_ready (rdy[1]),
+        .out_data  (s1_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(unpack_t)), .EN(SUBNORMAL_SUPPORT != 0), .CG(CLOCK_GATE != 0)) u_reg_subnorm_in (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[1]),
+        .in_ready  (rdy[1]),
+        .in_data   (si_d),
+        .out_valid (vld[2]),
+        .out_ready (rdy[2]),
+        .out_data  (si_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(tree_t)), .EN(TREE_REG >= 0), .CG(CLOCK_GATE != 0)) u_reg_tree (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[2]),
+        .in_ready  (rdy[2]),
+        .in_data   (st_d),
+        .out_valid (vld[3]),
+        .out_ready (rdy[3]),
+        .out_data  (st_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(mult_t)), .EN(REG_MASK[1]), .CG(CLOCK_GATE != 0)) u_reg2 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[3]),
+        .in_ready  (rdy[3]),
+        .in_data   (s2_d),
+        .out_valid (vld[4]),
+        .out_ready (rdy[4]),
+        .out_data  (s2_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(norm_t)), .EN(REG_MASK[2]), .CG(CLOCK_GATE != 0)) u_reg3 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[4]),
+        .in_ready  (rdy[4]),
+        .in_data   (s3_d),
+        .out_valid (vld[5]),
+        .out_ready (rdy[5]),
+        .out_data  (s3_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(norm_t)), .EN(SUBNORMAL_SUPPORT != 0), .CG(CLOCK_GATE != 0)) u_reg_subnorm_out (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[5]),
+        .in_ready  (rdy[5]),
+        .in_data   (so_d),
+        .out_valid (vld[6]),
+        .out_ready (rdy[6]),
+        .out_data  (so_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(round_t)), .EN(REG_MASK[3]), .CG(CLOCK_GATE != 0)) u_reg4 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[6]),
+        .in_ready  (rdy[6]),
+        .in_data   (s4_d),
+        .out_valid (vld[7]),
+        .out_ready (rdy[7]),
+        .out_data  (s4_q)
+    );
+
+    fmul_pipe_reg #(.WIDTH(LANES*$bits(pack_t)), .EN(REG_MASK[4]), .CG(CLOCK_GATE != 0)) u_reg5 (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (vld[7]),
+        .in_ready  (rdy[7]),
+        .in_data   (s5_d),
+        .out_valid (vld[8]),
+        .out_ready (rdy[8]),
+        .out_data  (s5_q)
+    );
+
+    assign out_valid = vld[8];
+    assign rdy[8]    = out_ready;
+
+endmodule
+
+// -------------------------------------------------------------------
+// Valid/ready stage register. EN = 0 turns it into plain wires so the
+// same netlist shape covers every STAGES setting.
+// -------------------------------------------------------------------
+module fmul_pipe_reg #(
+    parameter WIDTH = 1,
+    parameter bit EN = 1'b1,
+    parameter bit CG = 1'b0   // data clocked through fmul_clk_gate
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [WIDTH - 1:0] in_data,
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [WIDTH - 1:0] out_data
+);
+
+    generate
+        if (EN) begin : g_reg
+            logic valid_q;
+            logic [WIDTH - 1:0] data_q;
+
+            // Accept when empty or when the current entry leaves this cycle
+            assign in_ready = !valid_q || out_ready;
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    valid_q <= 1'b0;
+                end else if (in_ready) begin
+                    valid_q <= in_valid;
+                end
+            end
+
+            if (CG) begin : g_cg
+                logic gclk;
+
+                fmul_clk_gate u_cg (
+                    .clk  (clk),
+                    .en   (in_valid && in_ready),
+                    .gclk (gclk)
+                );
+
+                always_ff @(posedge gclk) begin
+                    data_q <= in_data;
+                end
+            end else begin : g_en
+                always_ff @(posedge clk) begin
+                    if (in_valid && in_ready) begin
+                        data_q <= in_data;
+                    end
+                end
+            end
+
+            assign out_valid = valid_q;
+            assign out_data  = data_q;
+        end else begin : g_wire
+            assign in_ready  = out_ready;
+            assign out_valid = in_valid;
+            assign out_data  = in_data;
+        end
+    endgenerate
+
+endmodule
+
+// -------------------------------------------------------------------
+// Clock gate: en is latched while clk is low and ANDed with clk, so
+// gclk pulses only in cycles with en high and never glitches. This is
+// the behaviour of a library integrated clock gating cell; map it to
+// the target's ICG for synthesis.
+// -------------------------------------------------------------------
+module fmul_clk_gate (
+    input  logic clk,
+    input  logic en,
+    output logic gclk
+);
+
+    logic en_l;
+
+    always_latch begin
+        if (!clk) en_l = en;
+    end
+
+    assign gclk = clk & en_l;
+
+endmodule
@@ -0,0 +1,703 @@
+`timescale 1ns / 1ps
+
+// Datapath steps of the floating-point multiplier.
+//
+// Every step is purely combinational. fmul chains them directly, fmul_pipe
+// places pipeline registers between them, so both produce identical results.
+//
+//   fmul_unpack -> fmul_mult -> fmul_norm -> fmul_round -> fmul_pack
+//
+// SUBNORMAL = 1 replaces DAZ/FTZ by gradual underflow with two more steps:
+// subnormal inputs are normalized with a leading-zero count before the
+// multiply, tiny products are shifted right (with sticky) to the subnormal
+// position before rounding. With SUBNORMAL = 0 both steps are wires.
+//
+//   fmul_unpack -> fmul_subnorm_in -> fmul_mult -> fmul_norm
+//               -> fmul_subnorm_out -> fmul_round -> fmul_pack
+//
+// FAST_ROUND = 1 replaces the multiply, normalize and round steps by
+// injection rounding: the multiplier's final adder also forms the product
+// plus half an ULP for both normalizations, and the tie case comes from the
+// trailing zeros of the significands, computed beside the multiply. After
+// the product only muxes are left, no OR-reduce over the low bits:
+//
+//   fmul_unpack -> fmul_mult_inj -> fmul_norm_inj -> fmul_round_inj -> fmul_pack
+//
+// The rounding mode comes from the rm input of the top levels, encoded as
+// the RISC-V frm field. Reserved codes round like RNE.
+//
+// OPERAND_ISOLATION = 1 on the top levels puts fmul_isolate in front of the
+// multiply step, so the significand multiplier sees constant operands
+// while its product cannot reach the result.
+
+package fmul_rm_pkg;
+
+    localparam logic [2:0] RM_RNE = 3'd0;   // nearest, ties to even
+    localparam logic [2:0] RM_RTZ = 3'd1;   // toward zero
+    localparam logic [2:0] RM_RDN = 3'd2;   // toward -Inf
+    localparam logic [2:0] RM_RUP = 3'd3;   // toward +Inf
+    localparam logic [2:0] RM_RMM = 3'd4;   // nearest, ties away from zero
+
+    // Round-up decision from the sign, the result LSB, the guard bit and
+    // the OR of every bit below it
+    function automatic logic rm_inc(input logic [2:0] rm, input logic sign,
+                                    input logic lsb, input logic guard, input logic sticky);
+        case (rm)
+            RM_RTZ:  return 1'b0;
+            RM_RDN:  return sign & (guard | sticky);
+            RM_RUP:  return ~sign & (guard | sticky);
+            RM_RMM:  return guard;
+            default: return guard & (sticky | lsb);   // RNE
+        endcase
+    endfunction
+
+endpackage
+
+// -------------------------------------------------------------------
+// Classify operands, resolve special cases, add exponents
+// -------------------------------------------------------------------
+module fmul_unpack #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter SUBNORMAL = 0   // subnormals are values, not zeros
+)(
+    input  logic [EXP + MANT:0] a,
+    input  logic [EXP + MANT:0] b,
+    output logic sign_c,
+    output logic special,   // result decided by classification
+    output logic spec_nan,  // special result is qNaN
+    output logic spec_inf,  // special result is Inf (otherwise signed zero)
+    output logic invalid,
+    output logic signed [EXP+1:0] exp_work,
+    output logic [MANT:0] sig_a,    // SUBNORMAL: 0.mantissa for a subnormal
+    output logic [MANT:0] sig_b
+);
+
+    localparam DATA_WIDTH = 1 + EXP + MANT;
+
+    logic [EXP - 1:0] exp_a;
+    logic [EXP - 1:0] exp_b;
+    logic [MANT - 1:0] mant_a;
+    logic [MANT - 1:0] mant_b;
+
+    logic a_isZero, a_isSub, a_isNaN, a_isInf;
+    logic b_isZero, b_isSub, b_isNaN, b_isInf;
+    logic a_daz, b_daz;   // zero, or subnormal read as zero
+
+    assign sign_c = a[DATA_WIDTH - 1] ^ b[DATA_WIDTH - 1];
+    assign exp_a  = a[DATA_WIDTH - 2:MANT];
+    assign exp_b  = b[DATA_WIDTH - 2:MANT];
+    assign mant_a = a[MANT - 1:0];
+    assign mant_b = b[MANT - 1:0];
+
+    // Significands with the hidden leading 1 (0 for a subnormal with
+    // SUBNORMAL, which then has the exponent of the smallest normal)
+    assign sig_a = {(SUBNORMAL == 0) || (exp_a != 0), mant_a};
+    assign sig_b = {(SUBNORMAL == 0) || (exp_b != 0), mant_b};
+
+    always_comb begin
+
+        a_isZero = 0;
+        a_isSub  = 0;
+        a_isInf  = 0;
+        a_isNaN  = 0;
+        b_isZero = 0;
+        b_isSub  = 0;
+        b_isInf  = 0;
+        b_isNaN  = 0;
+
+        special  = 0;
+        spec_nan = 0;
+        spec_inf = 0;
+        invalid  = 0;
+
+        if (exp_a == 0 && mant_a == 0) begin
+            a_isZero = 1;
+        end else if (exp_a == 0 && mant_a != 0) begin
+            a_isSub = 1;
+        end else if (exp_a == {EXP{1'b1}} && mant_a == 0) begin
+            a_isInf = 1;
+        end else if (exp_a == {EXP{1'b1}} && mant_a != 0) begin
+            a_isNaN = 1;
+        end
+
+        if (exp_b == 0 && mant_b == 0) begin
+            b_isZero = 1;
+        end else if (exp_b == 0 && mant_b != 0) begin
+            b_isSub = 1;
+        end else if (exp_b == {EXP{1'b1}} && mant_b == 0) begin
+            b_isInf = 1;
+        end else if (exp_b == {EXP{1'b1}} && mant_b != 0) begin
+            b_isNaN = 1;
+        end
+
+        a_daz = a_isZero || (a_isSub && SUBNORMAL == 0);
+        b_daz = b_isZero || (b_isSub && SUBNORMAL == 0);
+
+        if (a_isNaN || b_isNaN) begin
+        // at least one is NaN -> c = NaN
+            special  = 1;
+            spec_nan = 1;
+        end else if ((a_daz && b_isInf) || (a_isInf && b_daz)) begin
+        // 0 * infinity  or  subnormal * infinity -> c = NaN, inv flag
+            special  = 1;
+            spec_nan = 1;
+            invalid  = 1;
+        end else if (a_isInf || b_isInf) begin
+        // one is infinite -> c = inf
+            special  = 1;
+            spec_inf = 1;
+        end else if (a_daz || b_daz) begin
+        //zero or subnormal -> c = zero
+            special  = 1;
+        end
+
+        if (SUBNORMAL != 0) begin
+            // subnormals have the exponent of the smallest normal
+            exp_work = $signed({1'b0, exp_a | EXP'(exp_a == 0)}) +
+                       $signed({1'b0, exp_b | EXP'(exp_b == 0)}) - BIAS;
+        end else begin
+            exp_work = $signed({1'b0, exp_a}) + $signed({1'b0, exp_b}) - BIAS;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// SUBNORMAL: shift subnormal significands up to a leading 1 at bit MANT
+// and take the shifts off the exponent. The product of two subnormals
+// is far below the subnormal range and only leaves a sticky bit.
+// -------------------------------------------------------------------
+module fmul_subnorm_in #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter SUBNORMAL = 0
+)(
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    input  logic signed [EXP+1:0] exp_work,
+    output logic [MANT:0] sig_a_n,
+    output logic [MANT:0] sig_b_n,
+    output logic signed [EXP+1:0] exp_n
+);
+
+    localparam LW = $clog2(MANT + 1);
+
+    generate
+        if (SUBNORMAL == 0) begin : g_daz
+            assign sig_a_n = sig_a;
+            assign sig_b_n = sig_b;
+            assign exp_n   = exp_work;
+        end else begin : g_subnorm
+            // smallest exponent: both operands subnormal with one bit set
+            if (2 - BIAS - 2*MANT < -(1 << (EXP + 1))) begin : g_bad_range
+                $error("fmul_subnorm_in: exponent of a subnormal product does not fit EXP+2 bits");
+            end
+
+            logic [LW - 1:0] lz_a, lz_b;
+
+            // Leading zeros, a zero significand is never normalized
+            always_comb begin
+                lz_a = '0;
+                lz_b = '0;
+                for (int k = 0; k < MANT; k++) begin
+                    if (sig_a[k]) lz_a = LW'(MANT - k);
+                    if (sig_b[k]) lz_b = LW'(MANT - k);
+                end
+                if (sig_a[MANT]) lz_a = '0;
+                if (sig_b[MANT]) lz_b = '0;
+            end
+
+            assign sig_a_n = sig_a << lz_a;
+            assign sig_b_n = sig_b << lz_b;
+            assign exp_n   = exp_work - $signed({2'b00, lz_a}) - $signed({2'b00, lz_b});
+        end
+    endgenerate
+
+endmodule
+
+// -------------------------------------------------------------------
+// Operand isolation for the multiply step: with EN, gate forces both
+// significands to zero. The tops raise gate for a special case, whose
+// result comes from fmul_unpack alone, and fmul_pipe also while no valid
+// operands sit at the multiplier. Runs of such operands (zeros in sparse
+// data, bubbles) then leave the multiplier tree idle instead of toggling
+// with the operand bits. Results are unchanged: fmul_pack ignores the
+// product of a special case, and the stage registers only load valid
+// data. EN = 0 is wires.
+// -------------------------------------------------------------------
+module fmul_isolate #(
+    parameter MANT = 23,
+    parameter EN = 0
+)(
+    input  logic gate,
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    output logic [MANT:0] sig_a_o,
+    output logic [MANT:0] sig_b_o
+);
+
+    generate
+        if (EN) begin : g_gate
+            assign sig_a_o = gate ? '0 : sig_a;
+            assign sig_b_o = gate ? '0 : sig_b;
+        end else begin : g_wire
+            assign sig_a_o = sig_a;
+            assign sig_b_o = sig_b;
+        end
+    endgenerate
+
+endmodule
+
+// -------------------------------------------------------------------
+// Significand multiply, implementation selected by MULT_IMPL (see
+// fmul_mult.sv)
+// -------------------------------------------------------------------
+module fmul_mult #(
+    parameter MANT = 23,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17
+)(
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    output logic [2*MANT+1:0] pom_mant
+);
+
+    import fmul_mult_pkg::*;
+
+    localparam PW     = 2*MANT + 2;
+    localparam ROWS0  = mult_pp_rows(MULT_IMPL, MANT, DSP_W);
+    localparam LEVELS = mult_levels(MULT_IMPL, ROWS0);
+    localparam ROWS   = mult_rows_at(MULT_IMPL, ROWS0, LEVELS);
+
+    logic [ROWS0*PW - 1:0] pp;
+    logic [ROWS*PW - 1:0] sum_rows;
+
+    fmul_mult_pp #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_pp (
+        .sig_a (sig_a),
+        .sig_b (sig_b),
+        .rows  (pp)
+    );
+
+    fmul_mult_tree #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W), .FROM(0), .TO(LEVELS)) u_tree (
+        .rows_i (pp),
+        .rows_o (sum_rows)
+    );
+
+    fmul_mult_cpa #(.MANT(MANT), .ROWS(ROWS)) u_cpa (
+        .rows_i   (sum_rows),
+        .inj      ('0),
+        .pom_mant (pom_mant)
+    );
+
+endmodule
+
+// -------------------------------------------------------------------
+// Normalize product into [1,2)
+// -------------------------------------------------------------------
+module fmul_norm #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [2*MANT+1:0] pom_mant,
+    input  logic signed [EXP+1:0] exp_work,
+    output logic [2*MANT+1:0] pom_norm,
+    output logic signed [EXP+1:0] exp_norm
+);
+
+    always_comb begin
+        pom_norm = pom_mant;
+        exp_norm = exp_work;
+
+        if (pom_mant[2*MANT+1] == 1'b1) begin
+            // the bit shifted out stays in the sticky position
+            pom_norm = {1'b0, pom_mant[2*MANT+1:2], pom_mant[1] | pom_mant[0]};
+            exp_norm = exp_work + 1;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// SUBNORMAL: a product below the normal range is shifted right to the
+// subnormal position, the shifted-out bits collected in the sticky bit,
+// and rounded with exponent 0 (a carry gives the smallest normal).
+// Tininess is detected after rounding, as on RISC-V and x86: tiny unless
+// rounding at full precision already reaches the smallest normal.
+// -------------------------------------------------------------------
+module fmul_subnorm_out #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter SUBNORMAL = 0
+)(
+    input  logic [2*MANT+1:0] pom_norm,
+    input  logic signed [EXP+1:0] exp_norm,
+    input  logic sign_c,
+    input  logic [2:0] rm,
+    output logic [2*MANT+1:0] pom_den,
+    output logic signed [EXP+1:0] exp_den,
+    output logic tiny
+);
+
+    import fmul_rm_pkg::*;
+
+    localparam PW = 2*MANT + 2;
+    localparam SW = $clog2(PW + 1);
+
+    generate
+        if (SUBNORMAL == 0) begin : g_ftz
+            assign pom_den = pom_norm;
+            assign exp_den = exp_norm;
+            assign tiny    = 1'b0;
+        end else begin : g_subnorm
+            logic [SW - 1:0] sh;
+            logic [2*PW - 1:0] wide;
+            logic carry_n;
+
+            // 1 - exp_norm, all bits go to sticky from PW on
+            assign sh = (exp_norm > 0) ? '0 :
+                        (exp_norm <= 1 - PW) ? SW'(PW) : SW'(1 - exp_norm);
+
+            assign wide    = {pom_norm, {PW{1'b0}}} >> sh;
+            assign pom_den = wide[2*PW - 1:PW] | PW'(|wide[PW - 1:0]);
+            assign exp_den = (exp_norm > 0) ? exp_norm : '0;
+
+            // Rounding with unbounded exponent carries 1.11..1 up to 2.0
+            assign carry_n = (&pom_norm[2*MANT - 1:MANT]) &
+                             rm_inc(rm, sign_c, 1'b1, pom_norm[MANT - 1], |pom_norm[MANT - 2:0]);
+            assign tiny    = (exp_norm < 0) || (exp_norm == 0 && !carry_n);
+        end
+    endgenerate
+
+endmodule
+// -------------------------------------------------------------------
+// Round in the mode given by rm (see fmul_rm_pkg)
+// -------------------------------------------------------------------
+module fmul_round #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [2*MANT+1:0] pom_mant,
+    input  logic signed [EXP+1:0] exp_work,
+    input  logic sign_c,
+    input  logic [2:0] rm,
+    output logic [MANT - 1:0] mant_c,
+    output logic signed [EXP+1:0] exp_round,
+    output logic inexact    // guard or sticky set
+);
+
+    import fmul_rm_pkg::*;
+
+    logic [MANT:0] mant_pom;
+    logic lsb, guard, sticky, inc;
+
+    assign lsb     = pom_mant[MANT];
+    assign guard   = pom_mant[MANT - 1];
+    assign sticky  = |pom_mant[MANT - 2:0];
+    assign inexact = guard | sticky;
+    assign inc     = rm_inc(rm, sign_c, lsb, guard, sticky);
+
+    always_comb begin
+        mant_pom  = {1'b0, pom_mant[2*MANT - 1:MANT]} + {{MANT{1'b0}}, inc};
+        mant_c    = mant_pom[MANT-1:0];
+        exp_round = exp_work;
+
+        if (mant_pom[MANT] == 1'b1) begin
+            // 1.11..1 rounded up to 2.0
+            mant_c    = {MANT{1'b0}};
+            exp_round = exp_work + 1;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// Tie and inexact detection from the significands. The product has
+// tz(sig_a) + tz(sig_b) trailing zeros, so the bits below its LSB are
+// exactly one half when that count is MANT-1 (no normalize shift) or MANT
+// (shifted by one), and nonzero when it is below MANT or MANT+1.
+// -------------------------------------------------------------------
+module fmul_tie #(
+    parameter MANT = 23
+)(
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    output logic tie_lo,
+    output logic tie_hi,
+    output logic inexact_lo,
+    output logic inexact_hi
+);
+
+    localparam TW = $clog2(2*MANT + 1);
+
+    logic [TW - 1:0] tz_a, tz_b, tz_p;
+
+    always_comb begin
+        tz_a = TW'(MANT);
+        tz_b = TW'(MANT);
+        for (int k = MANT; k >= 0; k--) begin
+            if (sig_a[k]) tz_a = TW'(k);
+            if (sig_b[k]) tz_b = TW'(k);
+        end
+    end
+
+    assign tz_p       = tz_a + tz_b;
+    assign tie_lo     = (tz_p == TW'(MANT - 1));
+    assign tie_hi     = (tz_p == TW'(MANT));
+    assign inexact_lo = (tz_p < TW'(MANT));
+    assign inexact_hi = (tz_p < TW'(MANT + 1));
+
+endmodule
+
+// -------------------------------------------------------------------
+// Rounding injection constants for the product rounded at the LSB of
+// either normalization: half an ULP for the nearest modes, one ULP minus
+// one for rounding away from zero (RDN negative, RUP positive), zero when
+// truncating
+// -------------------------------------------------------------------
+module fmul_inj #(
+    parameter MANT = 23
+)(
+    input  logic sign_c,
+    input  logic [2:0] rm,
+    output logic [2*MANT+1:0] inj_lo,
+    output logic [2*MANT+1:0] inj_hi
+);
+
+    import fmul_rm_pkg::*;
+
+    localparam PW = 2*MANT + 2;
+
+    always_comb begin
+        if (rm == RM_RTZ || (rm == RM_RDN && !sign_c) || (rm == RM_RUP && sign_c)) begin
+            inj_lo = '0;
+            inj_hi = '0;
+        end else if (rm == RM_RDN || rm == RM_RUP) begin
+            inj_lo = (PW'(1) << MANT) - 1;
+            inj_hi = (PW'(1) << (MANT + 1)) - 1;
+        end else begin
+            inj_lo = PW'(1) << (MANT - 1);
+            inj_hi = PW'(1) << MANT;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// Significand multiply with rounding injection: pom_lo = P + inj_lo and
+// pom_hi = P + inj_hi, the product rounded at the LSB of either
+// normalization (plus the tie and inexact flags from fmul_tie)
+// -------------------------------------------------------------------
+module fmul_mult_inj #(
+    parameter MANT = 23,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17
+)(
+    input  logic [MANT:0] sig_a,
+    input  logic [MANT:0] sig_b,
+    input  logic sign_c,
+    input  logic [2:0] rm,
+    output logic [2*MANT+1:0] pom_lo,
+    output logic [2*MANT+1:0] pom_hi,
+    output logic tie_lo,
+    output logic tie_hi,
+    output logic inexact_lo,
+    output logic inexact_hi
+);
+
+    import fmul_mult_pkg::*;
+
+    localparam PW     = 2*MANT + 2;
+    localparam ROWS0  = mult_pp_rows(MULT_IMPL, MANT, DSP_W);
+    localparam LEVELS = mult_levels(MULT_IMPL, ROWS0);
+    localparam ROWS   = mult_rows_at(MULT_IMPL, ROWS0, LEVELS);
+
+    logic [ROWS0*PW - 1:0] pp;
+    logic [ROWS*PW - 1:0] sum_rows;
+    logic [PW - 1:0] inj_lo, inj_hi;
+
+    fmul_mult_pp #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W)) u_pp (
+        .sig_a (sig_a),
+        .sig_b (sig_b),
+        .rows  (pp)
+    );
+
+    fmul_mult_tree #(.MANT(MANT), .MULT_IMPL(MULT_IMPL), .DSP_W(DSP_W), .FROM(0), .TO(LEVELS)) u_tree (
+        .rows_i (pp),
+        .rows_o (sum_rows)
+    );
+
+    fmul_inj #(.MANT(MANT)) u_inj (
+        .sign_c (sign_c),
+        .rm     (rm),
+        .inj_lo (inj_lo),
+        .inj_hi (inj_hi)
+    );
+
+    // Compound adder: the same rows with either injection constant
+    fmul_mult_cpa #(.MANT(MANT), .ROWS(ROWS)) u_cpa_lo (
+        .rows_i   (sum_rows),
+        .inj      (inj_lo),
+        .pom_mant (pom_lo)
+    );
+
+    fmul_mult_cpa #(.MANT(MANT), .ROWS(ROWS)) u_cpa_hi (
+        .rows_i   (sum_rows),
+        .inj      (inj_hi),
+        .pom_mant (pom_hi)
+    );
+
+    fmul_tie #(.MANT(MANT)) u_tie (
+        .sig_a      (sig_a),
+        .sig_b      (sig_b),
+        .tie_lo     (tie_lo),
+        .tie_hi     (tie_hi),
+        .inexact_lo (inexact_lo),
+        .inexact_hi (inexact_hi)
+    );
+
+endmodule
+
+// -------------------------------------------------------------------
+// Normalize with injection rounding: pick the rounded sum of the right
+// normalization. The top bit of pom_lo decides; when rounding alone carries
+// pom_lo over, pom_hi gives the same 2.0 result.
+// -------------------------------------------------------------------
+module fmul_norm_inj #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [2*MANT+1:0] pom_lo,
+    input  logic [2*MANT+1:0] pom_hi,
+    input  logic tie_lo,
+    input  logic tie_hi,
+    input  logic inexact_lo,
+    input  logic inexact_hi,
+    input  logic signed [EXP+1:0] exp_work,
+    output logic [2*MANT+1:0] pom_norm,    // rounded, leading 1 at bit 2*MANT
+    output logic signed [EXP+1:0] exp_norm,
+    output logic tie,
+    output logic inexact
+);
+
+    always_comb begin
+        pom_norm = pom_lo;
+        exp_norm = exp_work;
+        tie      = tie_lo;
+        inexact  = inexact_lo;
+
+        if (pom_lo[2*MANT+1] == 1'b1) begin
+            pom_norm = pom_hi >> 1;
+            exp_norm = exp_work + 1;
+            tie      = tie_hi;
+            inexact  = inexact_hi;
+        end
+    end
+
+endmodule
+
+// -------------------------------------------------------------------
+// Round with injection: the sum is already rounded, in RNE a tie only
+// clears the LSB (ties to even). Exponent is final.
+// -------------------------------------------------------------------
+module fmul_round_inj #(
+    parameter EXP = 8,
+    parameter MANT = 23
+)(
+    input  logic [2*MANT+1:0] pom_mant,
+    input  logic signed [EXP+1:0] exp_work,
+    input  logic tie,
+    input  logic [2:0] rm,
+    output logic [MANT - 1:0] mant_c,
+    output logic signed [EXP+1:0] exp_round
+);
+
+    import fmul_rm_pkg::*;
+
+    logic rne;
+
+    assign rne       = (rm != RM_RTZ && rm != RM_RDN && rm != RM_RUP && rm != RM_RMM);
+    assign mant_c    = {pom_mant[2*MANT - 1:MANT + 1], pom_mant[MANT] & ~(tie & rne)};
+    assign exp_round = exp_work;
+
+endmodule
+
+// -------------------------------------------------------------------
+// Overflow / flush-to-zero checks and result packing. With SUBNORMAL an
+// exponent of 0 is a subnormal result from fmul_subnorm_out, underflow is
+// raised when it is tiny and inexact.
+// -------------------------------------------------------------------
+module fmul_pack #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter SUBNORMAL = 0
+)(
+    input  logic sign_c,
+    input  logic special,
+    input  logic spec_nan,
+    input  logic spec_inf,
+    input  logic spec_invalid,
+    input  logic signed [EXP+1:0] exp_work,
+    input  logic [MANT - 1:0] mant_c,
+    input  logic [2:0] rm,
+    input  logic round_inexact,
+    input  logic tiny,
+    output logic [EXP + MANT:0] y,
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact
+);
+
+    import fmul_rm_pkg::*;
+
+    localparam logic signed [EXP+1:0] EXP_MAX = (1 << EXP) - 1;
+
+    logic [EXP - 1:0] exp_c;
+    logic ovf_max;
+
+    // Overflow rounds to the largest finite value when the mode rounds
+    // toward zero for this sign
+    assign ovf_max = (rm == RM_RTZ) || (rm == RM_RDN && !sign_c) || (rm == RM_RUP && sign_c);
+
+    always_comb begin
+        invalid   = 0;
+        overflow  = 0;
+        underflow = 0;
+        inexact   = 0;
+        exp_c     = 0;
+        y         = 0;
+
+        if (special) begin
+            invalid = spec_invalid;
+            if (spec_nan) begin
+                // constant qNaN
+                y = {1'b0, {EXP{1'b1}}, 1'b1, {(MANT-1){1'b0}}};
+            end else if (spec_inf) begin
+                y = {sign_c, {EXP{1'b1}}, {MANT{1'b0}}};
+            end else begin
+                y = {sign_c, {EXP{1'b0}}, {MANT{1'b0}}};
+            end
+        end else if (exp_work >= EXP_MAX) begin
+            if (ovf_max)
+                y = {sign_c, {(EXP-1){1'b1}}, 1'b0, {MANT{1'b1}}};
+            else
+                y = {sign_c, {EXP{1'b1}}, {MANT{1'b0}}};
+            overflow = 1;
+            inexact = 1;
+        end else if (exp_work <= 0 && SUBNORMAL == 0) begin
+            y = {sign_c, {EXP{1'b0}}, {MANT{1'b0}}};
+            underflow = 1;
+            inexact = 1;
+        end else begin
+            // SUBNORMAL: exp_work is 0 for a subnormal result
+            exp_c = exp_work[EXP-1:0];
+            y = {sign_c, exp_c, mant_c};
+            underflow = tiny & round_inexact;
+            inexact = round_inexact;
+        end
+    end
+
+endmodule
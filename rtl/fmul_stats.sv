@@ -0,0 +1,187 @@
+`timescale 1ns / 1ps
+
+// Pipelined floating-point multiplier with result statistics.
+//
+// fmul_pipe plus saturating event counters, readable through a small CSR
+// port, to measure how often a workload takes the special-case paths.
+// Every result delivered (out_valid && out_ready) counts once in TOTAL,
+// once in exactly one result class and once in each flag it raises. Every
+// operand pair accepted (in_valid && in_ready) with a subnormal operand
+// counts once in SUB_IN; without SUBNORMAL_SUPPORT these are the operands
+// flushed to zero, the work gradual underflow would add.
+//
+// Result classes, first match wins (from y and the flags only):
+//
+//   INVALID    invalid (Inf * 0)           OVERFLOW   overflow
+//   NAN        NaN operand                 INF        Inf operand
+//   UNDERFLOW  underflow                   ZERO       zero or flushed operand
+//   FINITE     everything else: normal results, exact subnormal results
+//
+// CSR read: csr_rd with csr_addr samples the counter, csr_rdata and
+// csr_rvalid follow one cycle later; unused addresses read 0. csr_clr
+// clears every counter; an event in the same cycle is kept (like
+// fmul_vec's sticky_clr). Counters stop at 2^CNT_W - 1.
+//
+// The testbench keeps the same counters in software (dv/fmul_stats.h).
+
+package fmul_stats_pkg;
+
+    localparam int STAT_N = 13;
+
+    localparam logic [3:0] STAT_TOTAL       = 4'd0;
+    localparam logic [3:0] STAT_INVALID     = 4'd1;   // result classes
+    localparam logic [3:0] STAT_NAN         = 4'd2;
+    localparam logic [3:0] STAT_OVERFLOW    = 4'd3;
+    localparam logic [3:0] STAT_INF         = 4'd4;
+    localparam logic [3:0] STAT_UNDERFLOW   = 4'd5;
+    localparam logic [3:0] STAT_ZERO        = 4'd6;
+    localparam logic [3:0] STAT_FINITE      = 4'd7;
+    localparam logic [3:0] STAT_F_INVALID   = 4'd8;   // flags
+    localparam logic [3:0] STAT_F_OVERFLOW  = 4'd9;
+    localparam logic [3:0] STAT_F_UNDERFLOW = 4'd10;
+    localparam logic [3:0] STAT_F_INEXACT   = 4'd11;
+    localparam logic [3:0] STAT_SUB_IN      = 4'd12;  // operand pairs with a subnormal
+
+endpackage
+
+module fmul_stats #(
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter STAGES = 3,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17,
+    parameter TREE_REG = -1,
+    parameter FAST_ROUND = 0,
+    parameter SUBNORMAL_SUPPORT = 0,
+    parameter OPERAND_ISOLATION = 0,
+    parameter CLOCK_GATE = 0,
+    parameter CNT_W = 32   // counter width
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [EXP + MANT:0] a,
+    input  logic [EXP + MANT:0] b,
+    input  logic [2:0] rm,
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [EXP + MANT:0] y,
+    output logic invalid,
+    output logic overflow,
+    output logic underflow,
+    output logic inexact,
+
+    // Counter readout
+    input  logic csr_rd,
+    input  logic [3:0] csr_addr,
+    output logic [CNT_W - 1:0] csr_rdata,
+    output logic csr_rvalid,
+    input  logic csr_clr
+);
+
+    import fmul_stats_pkg::*;
+
+    fmul_pipe #(
+        .EXP               (EXP),
+        .MANT              (MANT),
+        .BIAS              (BIAS),
+        .STAGES            (STAGES),
+        .MULT_IMPL         (MULT_IMPL),
+        .DSP_W             (DSP_W),
+        .TREE_REG          (TREE_REG),
+        .FAST_ROUND        (FAST_ROUND),
+        .SUBNORMAL_SUPPORT (SUBNORMAL_SUPPORT),
+        .OPERAND_ISOLATION (OPERAND_ISOLATION),
+        .CLOCK_GATE        (CLOCK_GATE)
+    ) u_pipe (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (in_valid),
+        .in_ready  (in_ready),
+        .a         (a),
+        .b         (b),
+        .rm        (rm),
+        .out_valid (out_valid),
+        .out_ready (out_ready),
+        .y         (y),
+        .invalid   (invalid),
+        .overflow  (overflow),
+        .underflow (underflow),
+        .inexact   (inexact)
+    );
+
+    // -------------------------------------------------------------------
+    // Events of this cycle
+    // -------------------------------------------------------------------
+    logic fire_in, fire_out;
+    logic y_exp_ones, y_frac_zero, y_zero;
+    logic a_sub, b_sub;
+    logic [STAT_N - 1:0] ev;
+
+    assign fire_in  = in_valid && in_ready;
+    assign fire_out = out_valid && out_ready;
+
+    assign y_exp_ones  = &y[MANT +: EXP];
+    assign y_frac_zero = ~|y[MANT - 1:0];
+    assign y_zero      = ~|y[EXP + MANT - 1:0];
+
+    assign a_sub = ~|a[MANT +: EXP] && |a[MANT - 1:0];
+    assign b_sub = ~|b[MANT +: EXP] && |b[MANT - 1:0];
+
+    always_comb begin
+        ev = '0;
+        if (fire_out) begin
+            ev[STAT_TOTAL] = 1'b1;
+            if (invalid)                         ev[STAT_INVALID]   = 1'b1;
+            else if (y_exp_ones && !y_frac_zero) ev[STAT_NAN]       = 1'b1;
+            else if (overflow)                   ev[STAT_OVERFLOW]  = 1'b1;
+            else if (y_exp_ones)                 ev[STAT_INF]       = 1'b1;
+            else if (underflow)                  ev[STAT_UNDERFLOW] = 1'b1;
+            else if (y_zero)                     ev[STAT_ZERO]      = 1'b1;
+            else                                 ev[STAT_FINITE]    = 1'b1;
+            ev[STAT_F_INVALID]   = invalid;
+            ev[STAT_F_OVERFLOW]  = overflow;
+            ev[STAT_F_UNDERFLOW] = underflow;
+            ev[STAT_F_INEXACT]   = inexact;
+        end
+        ev[STAT_SUB_IN] = fire_in && (a_sub || b_sub);
+    end
+
+    // -------------------------------------------------------------------
+    // Saturating counters
+    // -------------------------------------------------------------------
+    logic [CNT_W - 1:0] cnt_q [STAT_N];
+
+    genvar k;
+    generate
+        for (k = 0; k < STAT_N; k++) begin : g_cnt
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    cnt_q[k] <= '0;
+                end else if (csr_clr) begin
+                    cnt_q[k] <= CNT_W'(ev[k]);
+                end else if (ev[k] && !(&cnt_q[k])) begin
+                    cnt_q[k] <= cnt_q[k] + 1'b1;
+                end
+            end
+        end
+    endgenerate
+
+    // -------------------------------------------------------------------
+    // CSR read port
+    // -------------------------------------------------------------------
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            csr_rdata  <= '0;
+            csr_rvalid <= 1'b0;
+        end else begin
+            csr_rvalid <= csr_rd;
+            if (csr_rd) csr_rdata <= (int'(csr_addr) < STAT_N) ? cnt_q[csr_addr] : '0;
+        end
+    end
+
+endmodule
@@ -0,0 +1,109 @@
+`timescale 1ns / 1ps
+
+// Vector floating-point multiplier.
+//
+// LANES independent multipliers behind one fmul_pipe valid/ready chain:
+// operands and results are packed buses with lane i in bits [i*W +: W], a
+// beat carries all lanes. Per-lane flags come straight from the lanes, the
+// any_* outputs OR them over the lanes of the current result, and the
+// sticky_* outputs accumulate that OR over every result delivered since
+// reset or the last sticky_clr (like a status register).
+
+module fmul_vec #(
+    parameter LANES = 4,
+    parameter EXP = 8,
+    parameter MANT = 23,
+    parameter BIAS = 127,
+    parameter STAGES = 3,
+    parameter MULT_IMPL = 0,
+    parameter DSP_W = 17,
+    parameter TREE_REG = -1,
+    parameter FAST_ROUND = 0,
+    parameter SUBNORMAL_SUPPORT = 0,
+    parameter OPERAND_ISOLATION = 0,
+    parameter CLOCK_GATE = 0
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic in_valid,
+    output logic in_ready,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] a,
+    input  logic [LANES*(1 + EXP + MANT) - 1:0] b,
+    input  logic [2:0] rm,   // rounding mode of the beat, see fmul_rm_pkg
+
+    output logic out_valid,
+    input  logic out_ready,
+    output logic [LANES*(1 + EXP + MANT) - 1:0] y,
+    output logic [LANES - 1:0] invalid,
+    output logic [LANES - 1:0] overflow,
+    output logic [LANES - 1:0] underflow,
+    output logic [LANES - 1:0] inexact,
+
+    // OR over the lanes of the current result
+    output logic any_invalid,
+    output logic any_overflow,
+    output logic any_underflow,
+    output logic any_inexact,
+
+    // Accumulated over delivered results; sticky_clr clears first, so a
+    // result delivered in the same cycle is kept
+    input  logic sticky_clr,
+    output logic sticky_invalid,
+    output logic sticky_overflow,
+    output logic sticky_underflow,
+    output logic sticky_inexact
+);
+
+    fmul_pipe #(
+        .EXP               (EXP),
+        .MANT              (MANT),
+        .BIAS              (BIAS),
+        .STAGES            (STAGES),
+        .LANES             (LANES),
+        .MULT_IMPL         (MULT_IMPL),
+        .DSP_W             (DSP_W),
+        .TREE_REG          (TREE_REG),
+        .FAST_ROUND        (FAST_ROUND),
+        .SUBNORMAL_SUPPORT (SUBNORMAL_SUPPORT),
+        .OPERAND_ISOLATION (OPERAND_ISOLATION),
+        .CLOCK_GATE        (CLOCK_GATE)
+    ) u_pipe (
+        .clk       (clk),
+        .rst_n     (rst_n),
+        .in_valid  (in_valid),
+        .in_ready  (in_ready),
+        .a         (a),
+        .b         (b),
+        .rm        (rm),
+        .out_valid (out_valid),
+        .out_ready (out_ready),
+        .y         (y),
+        .invalid   (invalid),
+        .overflow  (overflow),
+        .underflow (underflow),
+        .inexact   (inexact)
+    );
+
+    assign any_invalid   = |invalid;
+    assign any_overflow  = |overflow;
+    assign any_underflow = |underflow;
+    assign any_inexact   = |inexact;
+
+    logic [3:0] sticky_q;
+    logic [3:0] sticky_set;
+
+    assign sticky_set = (out_valid && out_ready) ?
+                        {any_invalid, any_overflow, any_underflow, any_inexact} : 4'b0;
+
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            sticky_q <= 4'b0;
+        end else begin
+            sticky_q <= (sticky_clr ? 4'b0 : sticky_q) | sticky_set;
+        end
+    end
+
+    assign {sticky_invalid, sticky_overflow, sticky_underflow, sticky_inexact} = sticky_q;
+
+endmodule
@@ -4,16 +4,69 @@ set -euo pipefail
 # ----------------------------------------
 # Config
 # ----------------------------------------
-DUT_SV="fmul.sv"
+RTL_SV=(rtl/fmul_mult.sv rtl/fmul.sv rtl/fmul_stages.sv rtl/fmul_pipe.sv rtl/fmul_vec.sv
+        rtl/fmul_stats.sv rtl/ffma.sv rtl/ffma_stages.sv rtl/ffma_pipe.sv rtl/fdot.sv)
 TB_CPP="tb_fmul.cpp"
 TOP="fmul"
+PREFIX="Vfmul"
+# Build cache: one directory per configuration, least recently used dropped
+CACHE_DIR="${FMUL_BUILD_CACHE:-build}"
+CACHE_KEEP="${FMUL_CACHE_KEEP:-32}"
+# Regression database: run log and corpus of minimized failures (tb_fmul)
+REGRESS_DB="${FMUL_REGRESS_DB:-regress}"
+# --par auto: fmul_vec builds of at least this many lanes get model threads
+PAR_THREAD_LANES=16
 
 # Defaults
 NRAND=200000
 PRINT_OK=0
 TRACE=0
+TRACE_FORMAT="fst"
+TRACE_WINDOW=""
 CHECK_FLAGS=0
 SEED=""
+START=""
+STIM_WEIGHTS=""
+COVERAGE=""
+BATCH=""
+JOBS=""
+CHUNK=""
+THREADS=""
+PAR=""
+OUTPUT_SPLIT=""
+SWEEP=""
+EXHAUSTIVE=0
+CHECKPOINT=""
+SUMMARY=""
+REPLAY=""
+MAX_FAILS=""
+RECORD=""
+REF_ISA=""
+ORACLE=""
+SOFTFLOAT=""
+PIPE_STAGES=""
+VEC_LANES=""
+FMA=0
+DOT_LANES=""
+MAX_BEATS=""
+FORMAT="fp32"
+MULT=""
+TREE_REG=""
+FAST_ROUND=0
+ROUND_MODE=""
+SUBNORMAL=0
+ISOLATE=0
+CLOCK_GATE=0
+BACKPRESSURE=0
+STATS=0
+STATS_WIDTH=""
+SV_TB=0
+BENCH=""
+BENCH_LABEL=""
+VL_OPTS=""
+REBUILD=0
+CCACHE=1
+CCACHE_USED=""
 
 usage() {
   cat <<EOF
@@ -23,9 +76,96 @@ Usage:
 Options:
   --n N            Number of random tests (default: ${NRAND})
   --print-ok       Print PASS cases as well as FAIL cases
-  --trace          Enable VCD tracing (wave.vcd)
+  --trace          Trace the whole run (wave.fst, or wave.vcd with --trace-format vcd)
+  --trace-format F Waveform format of a traced build: fst (default), vcd
+  --trace-window K Keep the last K vectors in memory, write wave_fail_<index>.<fmt>
+                   for the first mismatch only (not with --fma)
+                   Without --trace/--trace-window tracing is compiled out
   --check-flags    Check invalid/overflow/underflow/inexact status outputs
-  --seed S         RNG seed (reproducible runs)
+  --seed S         Stimulus seed (reproducible runs)
+  --start I        First stimulus vector index (replay a reported failure)
+  --stim-weights W Operand class weights +0,-0,+inf,-inf,nan,exp0,exp1,exp254,uniform
+                   (default in TB: 1,1,1,1,1,1,1,1,4)
+  --coverage       Report functional coverage of the random vectors
+  --cov-directed   Steer part of every batch at the least-hit coverage bins
+  --until-covered  Stop the random run at full coverage (--n is the cap)
+  --batch B        Vectors per driver/check batch (default in TB: 4096)
+  --jobs J         Sharded run on J threads, one model each (0 = all cores)
+  --chunk C        Vectors per shard/sweep unit (default in TB: 65536)
+  --threads T      Multithreaded model (verilator --threads T); every --jobs model
+                   runs T threads, --jobs 0 runs cores/T models
+  --par P          Split the --jobs budget (default: all cores) into models x model
+                   threads (tb_fmul only): models = one thread per model,
+                   threads = min(budget, LANES) threads per model, auto = models
+                   below ${PAR_THREAD_LANES} lanes, LANES/8 threads per model from there
+                   (bench_verilator.sh measures both)
+  --output-split N Split the generated C++ into files of about N statements and
+                   compile them in parallel (verilator --output-split N -j 0)
+  --sweep TILE     Exhaustive sweep of A_LO:A_HI:B_LO:B_HI instead of random tests
+  --exhaustive     Sweep every operand pair (--format fp16/bf16 only), on all
+                   cores unless --jobs is given; reports vectors/s
+  --checkpoint F   Sweep checkpoint file (resumed from if present)
+  --summary F      Append the sweep summary JSON line to F
+  --max-fails K    Keep going after mismatches until K failing vectors (0 = no limit),
+                   then print one dump per failure class
+  --replay F       Check the DUT against vector file F instead of random tests
+  --record F       Write the random vectors and reference results to vector file F
+  --ref-isa I      Batched reference kernel: scalar, avx2, avx512 (default: best)
+  --oracle O       Also check every reference batch against an independent model:
+                   host (host FPU: fp32/fp64, rne/rtz/rdn/rup) or softfloat
+  --softfloat DIR  Link Berkeley SoftFloat 3 from DIR (softfloat.h and softfloat.a,
+                   source/include and build/<target> of a source tree also found)
+                   for --oracle softfloat (the default oracle with this option)
+  --pipe STAGES    Build fmul_pipe with STAGES pipeline registers (1..5, 1..6 with --fma)
+  --vec LANES      Build fmul_vec with LANES lanes (1..32), STAGES from --pipe (default 3)
+  --fma            Build ffma (a*b + c) and its testbench; with --pipe, ffma_pipe.
+                   Supports --n/--seed/--start/--stim-weights/--batch/--print-ok/
+                   --trace/--check-flags/--backpressure
+  --dot LANES      Build fdot (dot product of LANES-wide beats, one rounding per
+                   stream) and its testbench; --n counts streams. Supports
+                   --n/--seed/--start/--stim-weights/--batch/--print-ok/--trace/
+                   --check-flags/--backpressure/--rm/--format/--mult
+  --max-beats K    With --dot: random streams of 1..K beats (default in TB: 16)
+  --mult M         Significand multiplier: infer, booth-wallace, booth-dadda, dsp
+                   (default: infer)
+  --tree-reg L     With --pipe/--vec: extra pipeline register after L levels of
+                   the multiplier tree (0 = after the partial products)
+  --fast-round     Injection rounding with trailing-zero tie detection (FAST_ROUND=1)
+  --rm M           Rounding mode driven on the rm input: rne, rtz, rdn, rup, rmm
+                   (default: rne); the reference model follows
+  --subnormal      Gradual underflow instead of DAZ/FTZ (SUBNORMAL_SUPPORT=1),
+                   reference model to match
+  --isolate        Operand isolation (OPERAND_ISOLATION=1): multiplier inputs gated
+                   to zero for special cases and, in fmul_pipe, bubbles
+  --clock-gate     With --pipe/--vec/--stats: stage data registers clocked through
+                   clock gates (CLOCK_GATE=1)
+  --format F       Operand format: fp16, bf16, fp32, fp64 (default: fp32);
+                   sets EXP/MANT/BIAS of the DUT and the reference model
+  --backpressure   With --pipe/--vec/--stats: random input bubbles and output stalls
+  --stats          Build fmul_stats (fmul_pipe plus result counters), STAGES from
+                   --pipe (default 3); the TB reads the counters back through the
+                   CSR port and, for random runs, prints the matching histogram
+  --stats-width W  Counter width of --stats (1..64, default 32)
+  --sv-tb          Build the SystemVerilog testbench dv/fmul_tb.sv (DPI-C
+                   reference, --binary --timing) instead of the C++ one.
+                   Supports --n/--seed/--rm/--check-flags/--print-ok/--max-fails/
+                   --batch (vectors per DPI call) and the DUT options of fmul
+  --bench F        Time the random run and append a JSON line (vectors/s,
+                   DUT/ref ns per vector, peak RSS) to F (- = stdout)
+  --bench-label S  Label stored in the --bench line
+  --vl-opt "OPTS"  Extra Verilator options, e.g. "--x-assign fast" or
+                   "--output-split 20000" (see bench_verilator.sh)
+  --db DIR         Regression database of tb_fmul runs (default: ${REGRESS_DB}, or
+                   \$FMUL_REGRESS_DB): the minimized failures of earlier runs
+                   with the same format, rounding mode and subnormal handling are
+                   replayed first, this run's failures are shrunk and added, and
+                   the run is appended to DIR/runs.jsonl
+  --no-db          Don't read or write the regression database
+  --build-dir D    Build cache root (default: ${CACHE_DIR}, or \$FMUL_BUILD_CACHE);
+                   the ${CACHE_KEEP} most recently used configurations are kept
+                   (\$FMUL_CACHE_KEEP)
+  --rebuild        Build again even if this configuration is cached
+  --no-ccache      Don't compile through ccache (used when installed)
   -h, --help       Show this help
 
 Examples:
@@ -33,8 +173,38 @@ Examples:
   ./run_verilator.sh --n 500000
   ./run_verilator.sh --n 50 --print-ok
   ./run_verilator.sh --n 50 --print-ok --trace
+  ./run_verilator.sh --n 100000000 --check-flags --trace-window 1000
   ./run_verilator.sh --n 200000 --check-flags
   ./run_verilator.sh --n 50 --print-ok --trace --check-flags --seed 12345
+  ./run_verilator.sh --n 100000000 --jobs 0 --check-flags
+  ./run_verilator.sh --n 100000000 --jobs 0 --check-flags --max-fails 0
+  ./run_verilator.sh --check-flags --seed 12345 --start 4711 --n 1 --print-ok
+  ./run_verilator.sh --n 1000000 --stim-weights 0,0,0,0,0,1,1,1,0
+  ./run_verilator.sh --n 10000000 --check-flags --cov-directed --until-covered
+  ./run_verilator.sh --jobs 0 --check-flags --sweep 0x3f800000:0x3f80ffff:0:0xffffffff \
+                     --checkpoint tile.ckpt --summary tiles.jsonl
+  ./run_verilator.sh --pipe 3 --n 200000 --backpressure
+  ./run_verilator.sh --vec 8 --pipe 4 --n 8000000 --check-flags
+  ./run_verilator.sh --vec 32 --par auto --jobs 0 --n 100000000 --check-flags --output-split 20000
+  ./run_verilator.sh --stats --n 1000000 --check-flags --backpressure
+  ./run_verilator.sh --mult booth-dadda --pipe 3 --tree-reg 3 --n 1000000 --backpressure
+  ./run_verilator.sh --format bf16 --exhaustive --fast-round
+  ./run_verilator.sh --n 1000000 --check-flags --rm rdn
+  ./run_verilator.sh --subnormal --pipe 3 --n 1000000 --check-flags
+  ./run_verilator.sh --isolate --clock-gate --pipe 4 --n 1000000 --check-flags --backpressure
+  ./run_verilator.sh --fma --n 1000000 --check-flags
+  ./run_verilator.sh --fma --pipe 6 --n 1000000 --check-flags --backpressure
+  ./run_verilator.sh --dot 8 --n 100000 --check-flags --max-beats 64 --backpressure
+  ./run_verilator.sh --format bf16 --n 10000000 --check-flags
+  ./run_verilator.sh --format bf16 --exhaustive --check-flags --checkpoint bf16.ckpt
+  ./run_verilator.sh --format fp64 --vec 4 --n 1000000 --check-flags --cov-directed
+  ./run_verilator.sh --n 10000000 --record run.fvec
+  ./run_verilator.sh --check-flags --jobs 0 --replay run.fvec
+  ./run_verilator.sh --n 100000000 --jobs 0 --check-flags --rm rdn --oracle host
+  ./run_verilator.sh --format fp16 --exhaustive --check-flags --softfloat ~/SoftFloat-3e
+  ./run_verilator.sh --sv-tb --n 1000000 --check-flags --rm rup
+  ./run_verilator.sh --n 100000000 --jobs 0 --check-flags --max-fails 0 --db nightly
+  ./run_verilator.sh --n 10000000 --vl-opt "--x-assign fast" --bench bench.jsonl
 EOF
 }
 
@@ -55,6 +225,14 @@ while [[ $# -gt 0 ]]; do
       TRACE=1
       shift
       ;;
+    --trace-format)
+      TRACE_FORMAT="$2"
+      shift 2
+      ;;
+    --trace-window)
+      TRACE_WINDOW="$2"
+      shift 2
+      ;;
     --check-flags)
       CHECK_FLAGS=1
       shift
@@ -63,6 +241,183 @@ while [[ $# -gt 0 ]]; do
       SEED="$2"
       shift 2
       ;;
+    --start)
+      START="$2"
+      shift 2
+      ;;
+    --stim-weights)
+      STIM_WEIGHTS="$2"
+      shift 2
+      ;;
+    --coverage|--cov-directed|--until-covered)
+      COVERAGE="${COVERAGE} $1"
+      shift
+      ;;
+    --batch)
+      BATCH="$2"
+      shift 2
+      ;;
+    --jobs)
+      JOBS="$2"
+      shift 2
+      ;;
+    --chunk)
+      CHUNK="$2"
+      shift 2
+      ;;
+    --threads)
+      THREADS="$2"
+      shift 2
+      ;;
+    --par)
+      PAR="$2"
+      shift 2
+      ;;
+    --output-split)
+      OUTPUT_SPLIT="$2"
+      shift 2
+      ;;
+    --sweep)
+      SWEEP="$2"
+      shift 2
+      ;;
+    --exhaustive)
+      EXHAUSTIVE=1
+      shift
+      ;;
+    --checkpoint)
+      CHECKPOINT="$2"
+      shift 2
+      ;;
+    --summary)
+      SUMMARY="$2"
+      shift 2
+      ;;
+    --max-fails)
+      MAX_FAILS="$2"
+      shift 2
+      ;;
+    --replay)
+      REPLAY="$2"
+      shift 2
+      ;;
+    --record)
+      RECORD="$2"
+      shift 2
+      ;;
+    --ref-isa)
+      REF_ISA="$2"
+      shift 2
+      ;;
+    --oracle)
+      ORACLE="$2"
+      shift 2
+      ;;
+    --softfloat)
+      SOFTFLOAT="$2"
+      shift 2
+      ;;
+    --pipe)
+      PIPE_STAGES="$2"
+      shift 2
+      ;;
+    --vec)
+      VEC_LANES="$2"
+      shift 2
+      ;;
+    --fma)
+      FMA=1
+      shift
+      ;;
+    --dot)
+      DOT_LANES="$2"
+      shift 2
+      ;;
+    --max-beats)
+      MAX_BEATS="$2"
+      shift 2
+      ;;
+    --mult)
+      MULT="$2"
+      shift 2
+      ;;
+    --tree-reg)
+      TREE_REG="$2"
+      shift 2
+      ;;
+    --fast-round)
+      FAST_ROUND=1
+      shift
+      ;;
+    --rm)
+      ROUND_MODE="$2"
+      shift 2
+      ;;
+    --subnormal)
+      SUBNORMAL=1
+      shift
+      ;;
+    --isolate)
+      ISOLATE=1
+      shift
+      ;;
+    --clock-gate)
+      CLOCK_GATE=1
+      shift
+      ;;
+    --format)
+      FORMAT="$2"
+      shift 2
+      ;;
+    --backpressure)
+      BACKPRESSURE=1
+      shift
+      ;;
+    --stats)
+      STATS=1
+      shift
+      ;;
+    --stats-width)
+      STATS=1
+      STATS_WIDTH="$2"
+      shift 2
+      ;;
+    --sv-tb)
+      SV_TB=1
+      shift
+      ;;
+    --bench)
+      BENCH="$2"
+      shift 2
+      ;;
+    --bench-label)
+      BENCH_LABEL="$2"
+      shift 2
+      ;;
+    --vl-opt)
+      VL_OPTS="${VL_OPTS:+$VL_OPTS }$2"
+      shift 2
+      ;;
+    --db)
+      REGRESS_DB="$2"
+      shift 2
+      ;;
+    --no-db)
+      REGRESS_DB=""
+      shift
+      ;;
+    --build-dir)
+      CACHE_DIR="$2"
+      shift 2
+      ;;
+    --rebuild)
+      REBUILD=1
+      shift
+      ;;
+    --no-ccache)
+      CCACHE=0
+      shift
+      ;;
     -h|--help)
       usage
       exit 0
@@ -77,24 +432,426 @@ while [[ $# -gt 0 ]]; do
 done
 
 # ----------------------------------------
-# Clean build artifacts
+# DUT selection
+# ----------------------------------------
+VFLAGS=()
+
+case "$FORMAT" in
+  fp16) FMT_EXP=5;  FMT_MANT=10; FMT_BIAS=15 ;;
+  bf16) FMT_EXP=8;  FMT_MANT=7;  FMT_BIAS=127 ;;
+  fp32) FMT_EXP=8;  FMT_MANT=23; FMT_BIAS=127 ;;
+  fp64) FMT_EXP=11; FMT_MANT=52; FMT_BIAS=1023 ;;
+  *)
+    echo "--format must be one of fp16, bf16, fp32, fp64"
+    exit 1
+    ;;
+esac
+
+if [[ "$FORMAT" != "fp32" ]]; then
+  if [[ "$FMA" -eq 1 ]]; then
+    echo "--format is not supported with --fma (tb_ffma is binary32 only)"
+    exit 1
+  fi
+  # Same parameters on the RTL and on the TB, which sizes its words from them
+  VFLAGS+=(-GEXP="$FMT_EXP" -GMANT="$FMT_MANT" -GBIAS="$FMT_BIAS"
+           -CFLAGS -DFMUL_EXP="$FMT_EXP" -CFLAGS -DFMUL_MANT="$FMT_MANT"
+           -CFLAGS -DFMUL_BIAS="$FMT_BIAS")
+fi
+
+if [[ -n "$PIPE_STAGES" ]]; then
+  PIPE_MAX=$(( FMA ? 6 : 5 ))
+  if [[ "$PIPE_STAGES" -lt 1 || "$PIPE_STAGES" -gt "$PIPE_MAX" ]]; then
+    echo "--pipe STAGES must be in 1..${PIPE_MAX}"
+    exit 1
+  fi
+fi
+
+if [[ -n "$MAX_BEATS" && -z "$DOT_LANES" ]]; then
+  echo "--max-beats needs --dot"
+  exit 1
+fi
+
+if [[ "$FMA" -eq 1 ]]; then
+  if [[ -n "$VEC_LANES$DOT_LANES" || "$STATS" -eq 1 ]]; then
+    echo "--vec, --dot and --stats are not supported with --fma"
+    exit 1
+  fi
+  TB_CPP="tb_ffma.cpp"
+  PREFIX="Vffma"
+  TOP="ffma"
+  if [[ -n "$PIPE_STAGES" ]]; then
+    TOP="ffma_pipe"
+    VFLAGS+=(-GSTAGES="$PIPE_STAGES" -CFLAGS -DFFMA_PIPE)
+  fi
+elif [[ -n "$DOT_LANES" ]]; then
+  if [[ "$DOT_LANES" -lt 1 || "$DOT_LANES" -gt 32 ]]; then
+    echo "--dot LANES must be in 1..32"
+    exit 1
+  fi
+  if [[ -n "$PIPE_STAGES$VEC_LANES$TREE_REG$TRACE_WINDOW" || "$STATS" -eq 1 || "$SV_TB" -eq 1 ||
+        "$FAST_ROUND" -eq 1 || "$SUBNORMAL" -eq 1 || "$ISOLATE" -eq 1 || "$CLOCK_GATE" -eq 1 ||
+        "$EXHAUSTIVE" -eq 1 || -n "$SWEEP$REPLAY$RECORD$JOBS$COVERAGE$BENCH" ]]; then
+    echo "--dot supports --n/--seed/--start/--stim-weights/--batch/--print-ok/--trace/"
+    echo "--check-flags/--backpressure/--rm/--format/--mult/--max-beats only"
+    exit 1
+  fi
+  TB_CPP="tb_fdot.cpp"
+  PREFIX="Vfdot"
+  TOP="fdot"
+  VFLAGS+=(-GLANES="$DOT_LANES" -CFLAGS -DFDOT_LANES="$DOT_LANES")
+elif [[ "$STATS" -eq 1 ]]; then
+  if [[ -n "$VEC_LANES" || "$SV_TB" -eq 1 ]]; then
+    echo "--stats wraps a single-lane fmul_pipe (no --vec or --sv-tb)"
+    exit 1
+  fi
+  STATS_WIDTH="${STATS_WIDTH:-32}"
+  if [[ "$STATS_WIDTH" -lt 1 || "$STATS_WIDTH" -gt 64 ]]; then
+    echo "--stats-width must be in 1..64"
+    exit 1
+  fi
+  TOP="fmul_stats"
+  PIPE_STAGES="${PIPE_STAGES:-3}"
+  VFLAGS+=(-GSTAGES="$PIPE_STAGES" -GCNT_W="$STATS_WIDTH"
+           -CFLAGS -DFMUL_PIPE -CFLAGS -DFMUL_STATS="$STATS_WIDTH")
+elif [[ -n "$VEC_LANES" ]]; then
+  if [[ "$VEC_LANES" -lt 1 || "$VEC_LANES" -gt 32 ]]; then
+    echo "--vec LANES must be in 1..32"
+    exit 1
+  fi
+  TOP="fmul_vec"
+  PIPE_STAGES="${PIPE_STAGES:-3}"
+  VFLAGS+=(-GLANES="$VEC_LANES" -GSTAGES="$PIPE_STAGES"
+           -CFLAGS -DFMUL_PIPE -CFLAGS -DFMUL_VEC="$VEC_LANES")
+elif [[ -n "$PIPE_STAGES" ]]; then
+  TOP="fmul_pipe"
+  VFLAGS+=(-GSTAGES="$PIPE_STAGES" -CFLAGS -DFMUL_PIPE)
+fi
+
+case "${MULT:-infer}" in
+  infer)         MULT_IMPL=0 ;;
+  booth-wallace) MULT_IMPL=1 ;;
+  booth-dadda)   MULT_IMPL=2 ;;
+  dsp)           MULT_IMPL=3 ;;
+  *)
+    echo "--mult must be one of infer, booth-wallace, booth-dadda, dsp"
+    exit 1
+    ;;
+esac
+
+if [[ -n "$MULT" ]]; then
+  VFLAGS+=(-GMULT_IMPL="$MULT_IMPL")
+fi
+
+if [[ -n "$TREE_REG" ]]; then
+  if [[ "$FMA" -eq 1 || -z "$PIPE_STAGES" ]]; then
+    echo "--tree-reg needs --pipe, --vec or --stats (fmul_pipe), not --fma"
+    exit 1
+  fi
+  VFLAGS+=(-GTREE_REG="$TREE_REG")
+fi
+
+if [[ "$FAST_ROUND" -eq 1 ]]; then
+  if [[ "$FMA" -eq 1 ]]; then
+    echo "--fast-round is not supported with --fma (ffma rounds the normalized sum)"
+    exit 1
+  fi
+  VFLAGS+=(-GFAST_ROUND=1)
+fi
+
+if [[ "$SUBNORMAL" -eq 1 ]]; then
+  if [[ "$FMA" -eq 1 || "$FAST_ROUND" -eq 1 ]]; then
+    echo "--subnormal is not supported with --fma or --fast-round"
+    exit 1
+  fi
+  VFLAGS+=(-GSUBNORMAL_SUPPORT=1 -CFLAGS -DFMUL_SUBNORMAL=1)
+fi
+
+if [[ "$ISOLATE" -eq 1 || "$CLOCK_GATE" -eq 1 ]]; then
+  if [[ "$FMA" -eq 1 ]]; then
+    echo "--isolate and --clock-gate are not supported with --fma"
+    exit 1
+  fi
+  if [[ "$ISOLATE" -eq 1 ]]; then
+    VFLAGS+=(-GOPERAND_ISOLATION=1)
+  fi
+  if [[ "$CLOCK_GATE" -eq 1 ]]; then
+    if [[ -z "$PIPE_STAGES" ]]; then
+      echo "--clock-gate needs --pipe, --vec or --stats (fmul_pipe stage registers)"
+      exit 1
+    fi
+    VFLAGS+=(-GCLOCK_GATE=1)
+  fi
+fi
+
+case "${ROUND_MODE:-rne}" in
+  rne|rtz|rdn|rup|rmm) ;;
+  *)
+    echo "--rm must be one of rne, rtz, rdn, rup, rmm"
+    exit 1
+    ;;
+esac
+
+if [[ "$FMA" -eq 1 && -n "$ROUND_MODE" && "$ROUND_MODE" != "rne" ]]; then
+  echo "--rm is not supported with --fma (ffma rounds to nearest even only)"
+  exit 1
+fi
+
+# Differential check of the reference model (dv/fmul_oracle.h)
+case "${ORACLE:-none}" in
+  none|host|softfloat) ;;
+  *)
+    echo "--oracle must be one of host, softfloat, none"
+    exit 1
+    ;;
+esac
+
+if [[ -n "$ORACLE$SOFTFLOAT" && ( "$FMA" -eq 1 || -n "$DOT_LANES" || "$SV_TB" -eq 1 ) ]]; then
+  echo "--oracle and --softfloat check the reference of tb_fmul only (no --fma, --dot or --sv-tb)"
+  exit 1
+fi
+
+if [[ "$ORACLE" == "softfloat" && -z "$SOFTFLOAT" ]]; then
+  echo "--oracle softfloat needs --softfloat DIR (a Berkeley SoftFloat 3 build)"
+  exit 1
+fi
+
+if [[ -n "$SOFTFLOAT" ]]; then
+  SF_INC=""
+  SF_LIB=""
+  for d in "$SOFTFLOAT" "$SOFTFLOAT/include" "$SOFTFLOAT/source/include"; do
+    if [[ -f "$d/softfloat.h" ]]; then
+      SF_INC="$d"
+      break
+    fi
+  done
+  for f in "$SOFTFLOAT/softfloat.a" "$SOFTFLOAT/libsoftfloat.a" "$SOFTFLOAT"/build/*/softfloat.a; do
+    if [[ -f "$f" ]]; then
+      SF_LIB="$f"
+      break
+    fi
+  done
+  if [[ -z "$SF_INC" || -z "$SF_LIB" ]]; then
+    echo "--softfloat: no softfloat.h and softfloat.a under $SOFTFLOAT"
+    exit 1
+  fi
+  # Absolute, the model is compiled in its build directory
+  SF_INC="$(cd "$SF_INC" && pwd)"
+  SF_LIB="$(cd "$(dirname "$SF_LIB")" && pwd)/$(basename "$SF_LIB")"
+  VFLAGS+=(-CFLAGS -DFMUL_SOFTFLOAT=1 -CFLAGS -I"$SF_INC" -LDFLAGS "$SF_LIB")
+  ORACLE="${ORACLE:-softfloat}"
+fi
+
+if [[ "$EXHAUSTIVE" -eq 1 ]]; then
+  if [[ "$FORMAT" != "fp16" && "$FORMAT" != "bf16" ]]; then
+    echo "--exhaustive needs --format fp16 or bf16 (2^32 operand pairs)"
+    exit 1
+  fi
+  if [[ "$FMA" -eq 1 || -n "$SWEEP" || -n "$REPLAY" ]]; then
+    echo "--exhaustive is not supported with --fma, --sweep or --replay"
+    exit 1
+  fi
+  JOBS="${JOBS:-0}"
+fi
+
+if [[ -n "$BENCH" ]]; then
+  if [[ "$FMA" -eq 1 || "$SV_TB" -eq 1 || "$EXHAUSTIVE" -eq 1 || -n "$SWEEP$REPLAY" ]]; then
+    echo "--bench times random runs of tb_fmul only (no --fma, --sv-tb, --sweep, --exhaustive, --replay)"
+    exit 1
+  fi
+fi
+
+# Parallelism: J models (--jobs) x T threads per model (--threads).
+# Lanes are independent, so Verilator can spread a wide fmul_vec over
+# several threads; a narrow one has too little work per eval to pay for
+# the thread synchronization and runs faster as more single-thread models.
+if [[ -n "$PAR" ]]; then
+  if [[ "$FMA" -eq 1 || -n "$DOT_LANES" || "$SV_TB" -eq 1 ]]; then
+    echo "--par splits tb_fmul --jobs runs (no --fma, --dot or --sv-tb)"
+    exit 1
+  fi
+  if [[ -n "$THREADS" ]]; then
+    echo "--par picks --threads itself, give one or the other"
+    exit 1
+  fi
+  PAR_BUDGET="${JOBS:-0}"
+  if [[ "$PAR_BUDGET" -eq 0 ]]; then
+    PAR_BUDGET="$(nproc)"
+  fi
+  PAR_LANES="${VEC_LANES:-1}"
+  case "$PAR" in
+    models)  THREADS=1 ;;
+    threads) THREADS=$(( PAR_LANES < PAR_BUDGET ? PAR_LANES : PAR_BUDGET )) ;;
+    auto)
+      THREADS=1
+      if [[ "$PAR_LANES" -ge "$PAR_THREAD_LANES" ]]; then
+        THREADS=$(( PAR_LANES / 8 < PAR_BUDGET ? PAR_LANES / 8 : PAR_BUDGET ))
+      fi
+      ;;
+    *)
+      echo "--par must be one of models, threads, auto"
+      exit 1
+      ;;
+  esac
+  JOBS=$(( PAR_BUDGET / THREADS ))
+fi
+
+if [[ -n "$THREADS" ]]; then
+  if [[ "$THREADS" -lt 1 ]]; then
+    echo "--threads must be at least 1"
+    exit 1
+  fi
+  VFLAGS+=(--threads "$THREADS")
+  if [[ "$SV_TB" -eq 0 ]]; then
+    VFLAGS+=(-CFLAGS -DFMUL_MODEL_THREADS="$THREADS")
+  fi
+fi
+
+if [[ -n "$OUTPUT_SPLIT" ]]; then
+  VFLAGS+=(--output-split "$OUTPUT_SPLIT" --output-split-cfuncs "$OUTPUT_SPLIT" -j 0)
+fi
+
+if [[ -n "$VL_OPTS" ]]; then
+  # Split on purpose: one string of several Verilator options
+  # shellcheck disable=SC2206
+  VFLAGS+=($VL_OPTS)
+fi
+
+if [[ "$SV_TB" -eq 1 ]]; then
+  if [[ "$FMA" -eq 1 || -n "$PIPE_STAGES" || -n "$VEC_LANES" ]]; then
+    echo "--sv-tb checks the combinational fmul only (no --fma, --pipe or --vec)"
+    exit 1
+  fi
+  if [[ "$EXHAUSTIVE" -eq 1 || "$TRACE" -eq 1 || -n "$TRACE_WINDOW" ||
+        -n "$SWEEP$REPLAY$RECORD$JOBS$CHECKPOINT$COVERAGE$START$STIM_WEIGHTS$REF_ISA" ]]; then
+    echo "--sv-tb supports --n/--seed/--rm/--check-flags/--print-ok/--max-fails/--batch only"
+    exit 1
+  fi
+  TOP="fmul_tb"
+  PREFIX="Vfmul_tb"
+  if [[ -n "$BATCH" ]]; then
+    VFLAGS+=(-GBATCH="$BATCH")
+  fi
+fi
+
+# Tracing is compiled in only when asked for (FMUL_TRACE, dv/fmul_trace.h)
+case "$TRACE_FORMAT" in
+  fst) TRACE_VL=--trace-fst; TRACE_CODE=2 ;;
+  vcd) TRACE_VL=--trace;     TRACE_CODE=1 ;;
+  *)
+    echo "--trace-format must be fst or vcd"
+    exit 1
+    ;;
+esac
+
+if [[ -n "$TRACE_WINDOW" && "$FMA" -eq 1 ]]; then
+  echo "--trace-window is not supported with --fma"
+  exit 1
+fi
+
+if [[ "$SV_TB" -eq 0 ]]; then
+  if [[ "$TRACE" -eq 1 || -n "$TRACE_WINDOW" ]]; then
+    VFLAGS+=("$TRACE_VL" -CFLAGS -DFMUL_TRACE="$TRACE_CODE")
+  else
+    VFLAGS+=(-CFLAGS -DFMUL_TRACE=0)
+  fi
+fi
+
+# ----------------------------------------
+# Clean run outputs
 # ----------------------------------------
-rm -rf obj_dir wave.vcd
+rm -f wave.vcd wave.fst wave_fail_*.vcd wave_fail_*.fst
 
 # ----------------------------------------
-# Build
+# Build cache
 # ----------------------------------------
-echo "=============================================="
-echo "Building with Verilator..."
-echo "=============================================="
+# Every configuration is built once into ${CACHE_DIR}/<top>-<format>-<key>,
+# the key hashing the Verilator version, the compiler environment, the full
+# Verilator command line (DUT parameters and TB defines included) and the
+# contents of the sources. Runs that change only run options (--n, --seed,
+# ...) reuse the model; ./obj_dir links to the last one used.
+if [[ "$SV_TB" -eq 1 ]]; then
+  # SV testbench as the top, the reference model linked in through DPI-C
+  VL_ARGS=(--binary --timing
+           "${RTL_SV[@]}" dv/fmul_tb.sv dv/fmul_dpi.cpp)
+  KEY_SRC=("${RTL_SV[@]}" dv/fmul_tb.sv dv/fmul_dpi.cpp dv/*.h sw/*.h)
+else
+  # The model class is fixed per testbench (Vfmul, Vffma, Vfdot) so the TB
+  # includes the same header whichever top is built.
+  VL_ARGS=(--cc "${RTL_SV[@]}"
+           --exe "dv/$TB_CPP"
+           --build
+           -LDFLAGS -pthread)
+  KEY_SRC=("${RTL_SV[@]}" "dv/$TB_CPP" dv/*.h sw/*.h)
+  if [[ -n "$SOFTFLOAT" ]]; then
+    KEY_SRC+=("$SF_INC/softfloat.h" "$SF_LIB")
+  fi
+fi
+VL_ARGS=(-Wall -Wno-UNUSED -Wno-DECLFILENAME "${VL_ARGS[@]}"
+         --top-module "$TOP"
+         --prefix "$PREFIX"
+         -O3
+         ${VFLAGS[@]+"${VFLAGS[@]}"})
+
+hash_stream() {
+  if command -v sha256sum > /dev/null; then
+    sha256sum "$@"
+  else
+    shasum -a 256 "$@"
+  fi
+}
+
+BUILD_KEY="$( {
+  verilator --version
+  echo "CXX=${CXX:-} CXXFLAGS=${CXXFLAGS:-} LDFLAGS=${LDFLAGS:-}"
+  printf '%s\n' "${VL_ARGS[@]}"
+  hash_stream "${KEY_SRC[@]}"
+} | hash_stream | cut -c1-16 )"
+BUILD_DIR="${CACHE_DIR}/${TOP}-${FORMAT}-${BUILD_KEY}"
+
+if [[ "$REBUILD" -eq 1 ]]; then
+  rm -rf "$BUILD_DIR"
+fi
+
+# ccache speeds up the misses too: the Verilator runtime and a TB compiled
+# with the same defines hit whichever model they are linked into
+if [[ "$CCACHE" -eq 1 ]] && command -v ccache > /dev/null; then
+  VL_ARGS+=(-MAKEFLAGS "OBJCACHE=ccache")
+  CCACHE_USED="ccache"
+fi
+
+if [[ -x "${BUILD_DIR}/${PREFIX}" ]]; then
+  BUILD_STATE="cached"
+  touch "$BUILD_DIR"
+else
+  BUILD_STATE="built"
+  echo "=============================================="
+  echo "Building with Verilator..."
+  echo "=============================================="
 
-verilator -Wall -Wno-UNUSED -Wno-DECLFILENAME \
-  --cc "rtl/$DUT_SV" \
-  --exe "dv/$TB_CPP" \
-  --top-module "$TOP" \
-  --trace \
-  --build \
-  -O3
+  # Build beside the final directory and move it in when complete, so an
+  # interrupted build or a concurrent run never sees a half-built model
+  mkdir -p "$CACHE_DIR"
+  BUILD_TMP="$(mktemp -d "${BUILD_DIR}.tmp.XXXXXX")"
+  chmod 755 "$BUILD_TMP"
+  trap 'rm -rf "$BUILD_TMP"' EXIT
+  verilator "${VL_ARGS[@]}" --Mdir "$BUILD_TMP"
+  if [[ ! -e "$BUILD_DIR" ]]; then
+    mv "$BUILD_TMP" "$BUILD_DIR"
+  fi
+  rm -rf "$BUILD_TMP"
+  trap - EXIT
+
+  # Keep the CACHE_KEEP most recently used configurations
+  # shellcheck disable=SC2012
+  ls -1dt "${CACHE_DIR}"/*-*-* 2>/dev/null | grep -v '\.tmp\.' | tail -n +$(( CACHE_KEEP + 1 )) |
+    while read -r old; do rm -rf "$old"; done
+fi
+
+# The model of this run as ./obj_dir for scripts and manual runs
+if [[ -d obj_dir && ! -L obj_dir ]]; then
+  rm -rf obj_dir
+fi
+ln -sfn "$BUILD_DIR" obj_dir
 
 # ----------------------------------------
 # Run
@@ -103,15 +860,36 @@ echo
 echo "=============================================="
 echo "Running simulation"
 echo "=============================================="
-echo "  Random tests : $NRAND"
+if [[ "$EXHAUSTIVE" -eq 1 ]]; then
+  echo "  Sweep tile   : every ${FORMAT} operand pair"
+elif [[ -n "$SWEEP" ]]; then
+  echo "  Sweep tile   : $SWEEP"
+elif [[ -n "$REPLAY" ]]; then
+  echo "  Replay file  : $REPLAY"
+else
+  echo "  Random tests : $NRAND"
+fi
 echo "  Print OK     : $PRINT_OK"
-echo "  Trace        : $TRACE"
+echo "  Trace        : $TRACE${TRACE_WINDOW:+ (window of ${TRACE_WINDOW} vectors)}$([[ "$TRACE" -eq 1 || -n "$TRACE_WINDOW" ]] && echo ", ${TRACE_FORMAT}" || echo ", compiled out")"
 echo "  Check flags  : $CHECK_FLAGS"
 echo "  Seed         : ${SEED:-<default in TB>}"
+echo "  Jobs         : ${JOBS:-<serial>}"
+echo "  Model threads: ${THREADS:-1}${PAR:+ (--par ${PAR})}"
+echo "  DUT          : ${TOP}${PIPE_STAGES:+ (STAGES=${PIPE_STAGES}${VEC_LANES:+, LANES=${VEC_LANES}}${STATS_WIDTH:+, CNT_W=${STATS_WIDTH}})}${DOT_LANES:+ (LANES=${DOT_LANES})}"
+echo "  Format       : ${FORMAT} (EXP=${FMT_EXP} MANT=${FMT_MANT} BIAS=${FMT_BIAS})"
+echo "  Multiplier   : ${MULT:-infer}${TREE_REG:+ (tree register after level ${TREE_REG})}"
+echo "  Fast round   : $FAST_ROUND"
+echo "  Rounding     : ${ROUND_MODE:-rne}"
+echo "  Oracle       : ${ORACLE:-none}${SOFTFLOAT:+ (SoftFloat ${SF_LIB})}"
+echo "  Subnormals   : $([[ "$SUBNORMAL" -eq 1 ]] && echo "gradual underflow" || echo "DAZ/FTZ")"
+echo "  Low power    : isolation=${ISOLATE} clock-gate=${CLOCK_GATE}"
+echo "  Build        : ${BUILD_DIR} (${BUILD_STATE}${CCACHE_USED:+, ${CCACHE_USED}})"
+echo "  Database     : $([[ -n "$REGRESS_DB" && "$FMA" -eq 0 && -z "$DOT_LANES" && "$SV_TB" -eq 0 ]] && echo "$REGRESS_DB" || echo "off")"
+echo "  Verilator    : -O3${THREADS:+ --threads $THREADS}${OUTPUT_SPLIT:+ --output-split $OUTPUT_SPLIT}${VL_OPTS:+ $VL_OPTS}"
 echo "=============================================="
 echo
 
-CMD="./obj_dir/V${TOP} --n ${NRAND}"
+CMD="${BUILD_DIR}/${PREFIX} --n ${NRAND}"
 
 if [[ "$PRINT_OK" -eq 1 ]]; then
   CMD="${CMD} --print-ok"
@@ -121,6 +899,10 @@ if [[ "$TRACE" -eq 1 ]]; then
   CMD="${CMD} --trace"
 fi
 
+if [[ -n "$TRACE_WINDOW" ]]; then
+  CMD="${CMD} --trace-window ${TRACE_WINDOW}"
+fi
+
 if [[ "$CHECK_FLAGS" -eq 1 ]]; then
   CMD="${CMD} --check-flags"
 fi
@@ -129,10 +911,124 @@ if [[ -n "$SEED" ]]; then
   CMD="${CMD} --seed ${SEED}"
 fi
 
+if [[ -n "$START" ]]; then
+  CMD="${CMD} --start ${START}"
+fi
+
+if [[ -n "$STIM_WEIGHTS" ]]; then
+  CMD="${CMD} --stim-weights ${STIM_WEIGHTS}"
+fi
+
+if [[ -n "$COVERAGE" ]]; then
+  CMD="${CMD}${COVERAGE}"
+fi
+
+if [[ -n "$BATCH" ]]; then
+  CMD="${CMD} --batch ${BATCH}"
+fi
+
+if [[ -n "$JOBS" ]]; then
+  CMD="${CMD} --jobs ${JOBS}"
+fi
+
+if [[ -n "$CHUNK" ]]; then
+  CMD="${CMD} --chunk ${CHUNK}"
+fi
+
+if [[ -n "$SWEEP" ]]; then
+  CMD="${CMD} --sweep ${SWEEP}"
+fi
+
+if [[ "$EXHAUSTIVE" -eq 1 ]]; then
+  CMD="${CMD} --exhaustive"
+fi
+
+if [[ -n "$CHECKPOINT" ]]; then
+  CMD="${CMD} --checkpoint ${CHECKPOINT}"
+fi
+
+if [[ -n "$SUMMARY" ]]; then
+  CMD="${CMD} --summary ${SUMMARY}"
+fi
+
+if [[ -n "$MAX_FAILS" ]]; then
+  CMD="${CMD} --max-fails ${MAX_FAILS}"
+fi
+
+if [[ -n "$REPLAY" ]]; then
+  CMD="${CMD} --replay ${REPLAY}"
+fi
+
+if [[ -n "$RECORD" ]]; then
+  CMD="${CMD} --record ${RECORD}"
+fi
+
+if [[ -n "$REF_ISA" ]]; then
+  CMD="${CMD} --ref-isa ${REF_ISA}"
+fi
+
+if [[ -n "$ORACLE" ]]; then
+  CMD="${CMD} --oracle ${ORACLE}"
+fi
+
+if [[ -n "$ROUND_MODE" && "$FMA" -eq 0 ]]; then
+  CMD="${CMD} --rm ${ROUND_MODE}"
+fi
+
+if [[ "$BACKPRESSURE" -eq 1 ]]; then
+  CMD="${CMD} --backpressure"
+fi
+
+if [[ -n "$BENCH" ]]; then
+  CMD="${CMD} --bench ${BENCH}"
+fi
+
+if [[ -n "$MAX_BEATS" ]]; then
+  CMD="${CMD} --max-beats ${MAX_BEATS}"
+fi
+
+# The database keys its records on the build directory, one per configuration
+if [[ -n "$REGRESS_DB" && "$FMA" -eq 0 && -z "$DOT_LANES" ]]; then
+  CMD="${CMD} --db ${REGRESS_DB} --db-label $(basename "$BUILD_DIR")"
+fi
+
+# The counter check runs in every mode, the histogram for random runs
+if [[ "$STATS" -eq 1 && "$EXHAUSTIVE" -eq 0 && -z "$SWEEP$REPLAY" ]]; then
+  CMD="${CMD} --stats"
+fi
+
+# The SV testbench takes plusargs instead
+if [[ "$SV_TB" -eq 1 ]]; then
+  case "${ROUND_MODE:-rne}" in
+    rne) RM_CODE=0 ;;
+    rtz) RM_CODE=1 ;;
+    rdn) RM_CODE=2 ;;
+    rup) RM_CODE=3 ;;
+    rmm) RM_CODE=4 ;;
+  esac
+  CMD="${BUILD_DIR}/${PREFIX} +n=${NRAND} +rm=${RM_CODE}"
+  if [[ -n "$SEED" ]]; then
+    CMD="${CMD} +seed=${SEED}"
+  fi
+  if [[ "$CHECK_FLAGS" -eq 1 ]]; then
+    CMD="${CMD} +check_flags"
+  fi
+  if [[ "$PRINT_OK" -eq 1 ]]; then
+    CMD="${CMD} +print_ok"
+  fi
+  if [[ -n "$MAX_FAILS" ]]; then
+    CMD="${CMD} +max_fails=${MAX_FAILS}"
+  fi
+fi
+
 echo "CMD: $CMD"
 echo
 
-$CMD
+if [[ -n "$BENCH_LABEL" ]]; then
+  $CMD --bench-label "$BENCH_LABEL"
+else
+  $CMD
+fi
 
 echo
 echo "=============================================="
@@ -140,6 +1036,6 @@ echo "Done."
 echo "=============================================="
 
 if [[ "$TRACE" -eq 1 ]]; then
-  echo "Waveform written to: wave.vcd"
-  echo "Open with: gtkwave wave.vcd"
+  echo "Waveform written to: wave.${TRACE_FORMAT}"
+  echo "Open with: gtkwave wave.${TRACE_FORMAT}"
 fi
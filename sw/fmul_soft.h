@@ -0,0 +1,758 @@
+// fmul_soft.h
+//
+// Header-only software fmul, bit-exact with the RTL for y and the four
+// status flags: DAZ/FTZ (or gradual underflow, as a SUBNORMAL_SUPPORT=1
+// DUT), one constant qNaN, the five rounding modes of the rm input. For
+// firmware and host-side emulation of the accelerator; it needs nothing
+// from the testbench, dv/fmul_ref.h builds the reference model on it.
+//  - Format<E,M,B>        fields of a format with the RTL parameters
+//                         EXP/MANT/BIAS; binary16, bfloat16, binary32, binary64
+//  - mul_k<F,RM,SUBN>()   scalar kernel, rounding mode and subnormal policy
+//                         fixed at compile time; Kernels<F> is the table of them
+//  - mul<F>()             the same with rm and subnormal handling picked at runtime
+//  - mul_batch<F>()       n operand pairs into y[] plus one packed flag byte
+//                         per vector (batch_select() returns the kernel for a
+//                         loop). binary32 with DAZ/FTZ runs AVX-512 (16 lanes)
+//                         or AVX2 (8 lanes) kernels in every rounding mode,
+//                         selected at runtime; other configurations are scalar
+//  - mul_bulk<F>()        std::span arrays (C++20), split over threads, flags
+//                         optional; returns the OR of all flags
+//
+// C++14 (mul_bulk: C++20), GCC or Clang (unsigned __int128); the threaded
+// bulk call needs -pthread.
+
+#ifndef FMUL_SOFT_H
+#define FMUL_SOFT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define FMUL_SOFT_SPAN 1
+#endif
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FMUL_SOFT_X86 1
+#endif
+
+namespace fmul_soft {
+
+// Smallest unsigned type holding BITS bits
+template <int BITS>
+struct Word {
+  typedef typename std::conditional<(BITS <= 8), uint8_t,
+          typename std::conditional<(BITS <= 16), uint16_t,
+          typename std::conditional<(BITS <= 32), uint32_t, uint64_t>::type>::type>::type type;
+};
+
+// -------------------------------------------------------------------
+// Format with 1 sign bit, E exponent bits (bias B) and M fraction bits,
+// the same parameters as the RTL. Exponent all ones is Inf/NaN, zero is
+// zero/subnormal.
+// -------------------------------------------------------------------
+template <int E, int M, int B>
+struct Format {
+  static const int EXP   = E;
+  static const int MANT  = M;
+  static const int BIAS  = B;
+  static const int WIDTH = 1 + E + M;
+  static_assert(E >= 2 && M >= 2 && WIDTH <= 64, "Format: EXP and MANT must be >= 2, at most 64 bits");
+  static_assert(B >= 1 && (long long)B < (1ll << E) - 1, "Format: BIAS must leave a normal range");
+
+  typedef typename Word<WIDTH>::type word;
+  // Significand product, 2*MANT+2 bits
+  typedef typename std::conditional<(2 * M + 2 <= 64), uint64_t, unsigned __int128>::type prod;
+
+  static constexpr word EXP_ONES  = (word)((1ull << E) - 1);
+  static constexpr word FRAC_MASK = (word)((1ull << M) - 1);
+  static constexpr word SIGN      = (word)(1ull << (E + M));
+  static constexpr word MASK      = (word)(SIGN | (SIGN - 1));
+  static constexpr word INF       = (word)((uint64_t)EXP_ONES << M);
+  static constexpr word QNAN      = (word)(INF | (1ull << (M - 1)));  // the DUT's only NaN
+
+  static inline word sign_bit(word x) { return (word)((x >> (E + M)) & 1u); }
+  static inline word exp_field(word x) { return (word)((x >> M) & EXP_ONES); }
+  static inline word frac_field(word x) { return (word)(x & FRAC_MASK); }
+
+  static inline bool is_nan(word x) { return exp_field(x) == EXP_ONES && frac_field(x) != 0; }
+  static inline bool is_inf(word x) { return exp_field(x) == EXP_ONES && frac_field(x) == 0; }
+  static inline bool is_zero(word x) { return exp_field(x) == 0 && frac_field(x) == 0; }
+  static inline bool is_sub(word x) { return exp_field(x) == 0 && frac_field(x) != 0; }
+
+  // Signed zero / Inf with sign s (0 or 1)
+  static inline word zero(word s) { return (word)((uint64_t)s << (E + M)); }
+  static inline word inf(word s) { return (word)(zero(s) | INF); }
+  // Largest finite magnitude with sign s
+  static inline word max_finite(word s) { return (word)(inf(s) - 1); }
+};
+
+typedef Format<5, 10, 15>    binary16;
+typedef Format<8, 7, 127>    bfloat16;
+typedef Format<8, 23, 127>   binary32;
+typedef Format<11, 52, 1023> binary64;
+
+// Result and status flags of one multiply
+template <class F>
+struct Result {
+  typename F::word y;
+  bool invalid;
+  bool overflow;
+  bool underflow;
+  bool inexact;
+};
+
+// Rounding modes, encoded like the DUT rm input (RISC-V frm). Reserved
+// codes 5..7 round like RNE, as in the RTL.
+enum Rm : int {
+  RNE = 0,  // nearest, ties to even
+  RTZ = 1,  // toward zero
+  RDN = 2,  // toward -Inf
+  RUP = 3,  // toward +Inf
+  RMM = 4,  // nearest, ties away from zero
+};
+
+// Packed flag bits, same order as the DUT ports {invalid, overflow, underflow, inexact}
+enum : uint8_t {
+  FLAG_INEXACT   = 1u << 0,
+  FLAG_UNDERFLOW = 1u << 1,
+  FLAG_OVERFLOW  = 1u << 2,
+  FLAG_INVALID   = 1u << 3,
+  FLAG_ALL       = 0xFu,
+};
+
+template <class F>
+inline uint8_t pack_flags(const Result<F>& o) {
+  return (uint8_t)((o.invalid ? FLAG_INVALID : 0) | (o.overflow ? FLAG_OVERFLOW : 0) |
+                   (o.underflow ? FLAG_UNDERFLOW : 0) | (o.inexact ? FLAG_INEXACT : 0));
+}
+
+template <class F>
+inline Result<F> unpack_flags(typename F::word y, uint8_t fl) {
+  Result<F> o;
+  o.y = y;
+  o.invalid   = (fl & FLAG_INVALID) != 0;
+  o.overflow  = (fl & FLAG_OVERFLOW) != 0;
+  o.underflow = (fl & FLAG_UNDERFLOW) != 0;
+  o.inexact   = (fl & FLAG_INEXACT) != 0;
+  return o;
+}
+
+// Round-up decision from sign s, the result LSB, the guard bit G and the
+// OR of every bit below it (sticky)
+inline uint32_t round_inc(int rm, uint32_t s, uint32_t lsb, uint32_t G, uint32_t sticky) {
+  switch (rm) {
+    case RTZ: return 0;
+    case RDN: return s & (G | sticky);
+    case RUP: return (s ^ 1u) & (G | sticky);
+    case RMM: return G;
+    default:  return G & (sticky | lsb);
+  }
+}
+
+// Overflow gives the largest finite value instead of Inf when the mode
+// rounds toward zero for sign s
+inline bool ovf_max(int rm, uint32_t s) {
+  return rm == RTZ || (rm == RDN && !s) || (rm == RUP && s);
+}
+
+// Code in 0..4 of rm, reserved codes map to RNE
+inline int rm_index(int rm) { return (rm > RNE && rm <= RMM) ? rm : RNE; }
+
+// -------------------------------------------------------------------
+// Scalar kernel, all NaNs are qNaN, subnormals are treated as zeros
+// (DAZ/FTZ) or, with SUBN, as values with gradual underflow.
+//
+// Format F, rounding mode RM and the subnormal policy are template
+// parameters, so each configuration compiles to its own kernel with the
+// mode and policy branches folded away. mul() picks the kernel at
+// runtime; loops select one once (Kernels, batch_select()).
+// -------------------------------------------------------------------
+template <class F, int RM, bool SUBN>
+inline Result<F> mul_k(typename F::word a, typename F::word b) {
+  typedef typename F::word W;
+  typedef typename F::prod P;
+  const int M = F::MANT;
+
+  Result<F> o{};
+  o.y = 0;
+  o.invalid = o.overflow = o.underflow = o.inexact = false;
+
+  const W s = (W)((F::sign_bit(a) ^ F::sign_bit(b)) & 1u);
+
+  // Any NaN input => constant qNaN
+  if (F::is_nan(a) || F::is_nan(b)) {
+    o.y = F::QNAN;
+    return o;
+  }
+
+  // Treat subnormals as zero (DAZ) unless SUBN
+  const bool a_eff_zero = F::is_zero(a) || (!SUBN && F::is_sub(a));
+  const bool b_eff_zero = F::is_zero(b) || (!SUBN && F::is_sub(b));
+
+  const bool a_inf = F::is_inf(a);
+  const bool b_inf = F::is_inf(b);
+
+  // Inf * 0 => invalid + qNaN
+  if ((a_inf && b_eff_zero) || (b_inf && a_eff_zero)) {
+    o.invalid = true;
+    o.y = F::QNAN;
+    return o;
+  }
+
+  // Inf * finite => Inf
+  if (a_inf || b_inf) {
+    o.y = F::inf(s);
+    return o;
+  }
+
+  // 0 * anything => signed zero
+  if (a_eff_zero || b_eff_zero) {
+    o.y = F::zero(s);
+    return o;
+  }
+
+  // ------------------------------------------------------------
+  // Normal finite multiply path
+  // Inputs are normal, or subnormal with SUBN (normalized below)
+  // ------------------------------------------------------------
+
+  // (MANT+1)-bit significands with hidden 1, biased exponents. A
+  // subnormal 0.frac * 2^(1-BIAS) is shifted up to its leading 1.
+  P sigA = ((P)1 << M) | F::frac_field(a);
+  P sigB = ((P)1 << M) | F::frac_field(b);
+  int expA = (int)F::exp_field(a);
+  int expB = (int)F::exp_field(b);
+  if (SUBN && expA == 0) {
+    sigA = F::frac_field(a);
+    for (expA = 1; !(sigA >> M); expA--) sigA <<= 1;
+  }
+  if (SUBN && expB == 0) {
+    sigB = F::frac_field(b);
+    for (expB = 1; !(sigB >> M); expB--) sigB <<= 1;
+  }
+
+  // Biased exponent of the product
+  int expP = expA + expB - F::BIAS;
+
+  // (MANT+1)x(MANT+1) -> (2*MANT+2)-bit product
+  P prod = sigA * sigB;
+
+  // Normalize into [1,2)
+  // Leading 1 should be at bit 2*MANT
+  // If prod[2*MANT+1]=1, it's in [2,4) => shift right 1 and increment exponent,
+  // the bit shifted out stays in the sticky position
+  if ((prod >> (2 * M + 1)) & 1u) {
+    prod = (prod >> 1) | (prod & 1u);
+    expP += 1;
+  }
+
+  // Round p (leading 1 at or below bit 2*MANT) at bit MANT:
+  // upper_bits = p[2*MANT:MANT]  (hidden 1 + MANT fraction bits)
+  // G = p[MANT-1], R = p[MANT-2], S = OR(p[MANT-3:0])
+  auto round_at_mant = [&](P p, bool& inexact) -> uint64_t {
+    uint64_t upper_bits = (uint64_t)(p >> M) & ((2ull << M) - 1);
+    const uint32_t G = (uint32_t)((p >> (M - 1)) & 1u);
+    const uint32_t R = (uint32_t)((p >> (M - 2)) & 1u);
+    const uint32_t S = (p & (((P)1 << (M - 2)) - 1)) != 0 ? 1u : 0u;
+
+    // Increment rule of the rounding mode
+    const uint32_t LSB = (uint32_t)(upper_bits & 1u);
+    const uint32_t inc = round_inc(RM, (uint32_t)s, LSB, G, R | S);
+
+    // Inexact if any discarded bits were nonzero
+    inexact = (G | R | S) != 0;
+
+    // Add increment; may carry out to bit MANT+1
+    return upper_bits + inc;
+  };
+
+  // Renormalize a carry out by shifting right 1 and exp++
+  uint64_t upper_bits = round_at_mant(prod, o.inexact);
+  int expR = expP;
+  if (upper_bits >> (M + 1)) {
+    upper_bits >>= 1;
+    expR += 1;
+  }
+
+  // ------------------------------------------------------------
+  // Gradual underflow (SUBN): shift right to the subnormal position,
+  // shifted-out bits into sticky, and round again there. A carry into
+  // the hidden bit gives the smallest normal. Tininess is detected after
+  // rounding (RISC-V, x86): the result rounded with unbounded exponent
+  // is below the smallest normal.
+  // ------------------------------------------------------------
+  if (SUBN && expP <= 0) {
+    const bool tiny = expR <= 0;
+    const int sh = 1 - expP;
+    const P den = sh >= 2 * M + 2 ? (P)(prod != 0)
+                                  : (prod >> sh) | (P)((prod & (((P)1 << sh) - 1)) != 0);
+    const uint64_t sub_bits = round_at_mant(den, o.inexact);
+    o.underflow = tiny && o.inexact;
+    o.y = (W)(F::zero(s) | sub_bits);
+    return o;
+  }
+
+  // ------------------------------------------------------------
+  // Flush to zero and overflow handling
+  // ------------------------------------------------------------
+  if (expR >= (int)F::EXP_ONES) {
+    // Overflow => Inf, or the largest finite value when rounding toward zero
+    o.overflow = true;
+    o.inexact  = true;
+    o.y = ovf_max(RM, (uint32_t)s) ? F::max_finite(s) : F::inf(s);
+    return o;
+  }
+
+  if (expR <= 0) {
+    // Would be subnormal => flush to zero
+    o.underflow = true;
+    o.inexact   = true;
+    o.y = F::zero(s);
+    return o;
+  }
+
+  // Normal pack, drop the hidden 1
+  o.y = (W)(F::zero(s) | ((uint64_t)expR << M) | (upper_bits & F::FRAC_MASK));
+
+  return o;
+}
+
+// Kernel table of format F, [gradual underflow][rounding mode]
+template <class F>
+struct Kernels {
+  typedef Result<F> (*Fn)(typename F::word, typename F::word);
+
+  static Fn get(int rm, bool subn) {
+    static const Fn table[2][5] = {
+      { mul_k<F, RNE, false>, mul_k<F, RTZ, false>, mul_k<F, RDN, false>,
+        mul_k<F, RUP, false>, mul_k<F, RMM, false> },
+      { mul_k<F, RNE, true>, mul_k<F, RTZ, true>, mul_k<F, RDN, true>,
+        mul_k<F, RUP, true>, mul_k<F, RMM, true> },
+    };
+    return table[subn ? 1 : 0][rm_index(rm)];
+  }
+};
+
+template <class F>
+inline Result<F> mul(typename F::word a, typename F::word b, int rm = RNE, bool subn = false) {
+  return Kernels<F>::get(rm, subn)(a, b);
+}
+
+// -------------------------------------------------------------------
+// Batched kernels
+//
+// The SIMD kernels compute every path for every lane and select the
+// result with masks: specials (NaN, Inf*0, Inf, zero/DAZ) override the
+// normal path, overflow and FTZ override the normal pack. Lanes are
+// processed as 64-bit so the 24x24 significand product fits; 32-bit
+// operands are split into even and odd lanes and merged back. They are
+// binary32 with DAZ/FTZ only, the rounding mode is a template parameter
+// like in mul_k(); other configurations use the scalar loop.
+//
+// Flags are packed per lane as {invalid, overflow, underflow, inexact}
+// (bit 3..0), the same order as the DUT ports.
+// -------------------------------------------------------------------
+enum class Isa { Scalar, Avx2, Avx512 };
+
+inline const char* isa_name(Isa isa) {
+  switch (isa) {
+    case Isa::Avx512: return "avx512";
+    case Isa::Avx2:   return "avx2";
+    default:          return "scalar";
+  }
+}
+
+// Batch kernel: n pairs into y[] and packed flags, one configuration
+template <class F>
+struct Batch {
+  typedef typename F::word W;
+  typedef void (*Fn)(const W* a, const W* b, W* y, uint8_t* flags, size_t n);
+};
+
+template <class F, int RM, bool SUBN>
+inline void mul_batch_k(const typename F::word* a, const typename F::word* b,
+                        typename F::word* y, uint8_t* flags, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    Result<F> o = mul_k<F, RM, SUBN>(a[i], b[i]);
+    y[i] = o.y;
+    flags[i] = pack_flags(o);
+  }
+}
+
+// Scalar batch kernel of rounding mode rm and subnormal policy subn
+template <class F>
+inline typename Batch<F>::Fn batch_scalar(int rm, bool subn) {
+  static const typename Batch<F>::Fn table[2][5] = {
+    { mul_batch_k<F, RNE, false>, mul_batch_k<F, RTZ, false>, mul_batch_k<F, RDN, false>,
+      mul_batch_k<F, RUP, false>, mul_batch_k<F, RMM, false> },
+    { mul_batch_k<F, RNE, true>, mul_batch_k<F, RTZ, true>, mul_batch_k<F, RDN, true>,
+      mul_batch_k<F, RUP, true>, mul_batch_k<F, RMM, true> },
+  };
+  return table[subn ? 1 : 0][rm_index(rm)];
+}
+
+// SIMD kernels of format F, none unless specialized below
+template <class F>
+struct SimdKernels {
+  static typename Batch<F>::Fn get(int, Isa) { return nullptr; }
+};
+
+#ifdef FMUL_SOFT_X86
+// 4 lanes, operands in the low 32 bits of each 64-bit lane
+template <int RM>
+__attribute__((target("avx2")))
+inline void lanes_avx2(__m256i a, __m256i b, __m256i& y, __m256i& fl) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one  = _mm256_set1_epi64x(1);
+  const __m256i emax = _mm256_set1_epi64x(0xFF);
+  const __m256i hid  = _mm256_set1_epi64x(1 << 23);
+  const __m256i fmsk = _mm256_set1_epi64x(0x7FFFFF);
+  const __m256i inf  = _mm256_set1_epi64x(0x7F800000);
+
+  const __m256i s  = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi64x(0x80000000ll));
+  const __m256i ea = _mm256_and_si256(_mm256_srli_epi64(a, 23), emax);
+  const __m256i eb = _mm256_and_si256(_mm256_srli_epi64(b, 23), emax);
+  const __m256i fa = _mm256_and_si256(a, fmsk);
+  const __m256i fb = _mm256_and_si256(b, fmsk);
+
+  // Classification (all-ones lanes)
+  const __m256i ea_max = _mm256_cmpeq_epi64(ea, emax);
+  const __m256i eb_max = _mm256_cmpeq_epi64(eb, emax);
+  const __m256i fa_z   = _mm256_cmpeq_epi64(fa, zero);
+  const __m256i fb_z   = _mm256_cmpeq_epi64(fb, zero);
+  const __m256i a_inf  = _mm256_and_si256(ea_max, fa_z);
+  const __m256i b_inf  = _mm256_and_si256(eb_max, fb_z);
+  const __m256i a_z    = _mm256_cmpeq_epi64(ea, zero); // zero or DAZ subnormal
+  const __m256i b_z    = _mm256_cmpeq_epi64(eb, zero);
+
+  const __m256i m_nan = _mm256_or_si256(_mm256_andnot_si256(fa_z, ea_max),
+                                        _mm256_andnot_si256(fb_z, eb_max));
+  const __m256i m_inv = _mm256_andnot_si256(m_nan,
+                          _mm256_or_si256(_mm256_and_si256(a_inf, b_z), _mm256_and_si256(b_inf, a_z)));
+  const __m256i m_qnan = _mm256_or_si256(m_nan, m_inv);
+  const __m256i m_inf  = _mm256_andnot_si256(m_qnan, _mm256_or_si256(a_inf, b_inf));
+  const __m256i m_spec = _mm256_or_si256(m_qnan, _mm256_or_si256(m_inf, _mm256_or_si256(a_z, b_z)));
+
+  // Normal path: 48-bit product, normalize, G/R/S, round
+  __m256i prod = _mm256_mul_epu32(_mm256_or_si256(fa, hid), _mm256_or_si256(fb, hid));
+  const __m256i top = _mm256_srli_epi64(prod, 47);
+  prod = _mm256_or_si256(_mm256_srlv_epi64(prod, top), _mm256_and_si256(prod, top));  // keep sticky
+
+  __m256i up = _mm256_and_si256(_mm256_srli_epi64(prod, 23), _mm256_set1_epi64x(0xFFFFFF));
+  const __m256i G = _mm256_and_si256(_mm256_srli_epi64(prod, 22), one);
+  const __m256i R = _mm256_and_si256(_mm256_srli_epi64(prod, 21), one);
+  const __m256i S = _mm256_andnot_si256(
+                      _mm256_cmpeq_epi64(_mm256_and_si256(prod, _mm256_set1_epi64x(0x1FFFFF)), zero), one);
+  const __m256i RS = _mm256_or_si256(R, S);
+  const __m256i sb = _mm256_srli_epi64(s, 31);  // sign as 0/1
+  __m256i inc;
+  if (RM == RTZ)      inc = zero;
+  else if (RM == RDN) inc = _mm256_and_si256(sb, _mm256_or_si256(G, RS));
+  else if (RM == RUP) inc = _mm256_andnot_si256(sb, _mm256_or_si256(G, RS));
+  else if (RM == RMM) inc = G;
+  else                inc = _mm256_and_si256(G, _mm256_or_si256(RS, _mm256_and_si256(up, one)));
+  up = _mm256_add_epi64(up, inc);
+  const __m256i carry = _mm256_srli_epi64(up, 24);
+  up = _mm256_srlv_epi64(up, carry);
+
+  // Biased result exponent, signed
+  const __m256i e = _mm256_sub_epi64(_mm256_add_epi64(_mm256_add_epi64(ea, eb), _mm256_add_epi64(top, carry)),
+                                     _mm256_set1_epi64x(127));
+  const __m256i m_ovf = _mm256_cmpgt_epi64(e, _mm256_set1_epi64x(254));
+  const __m256i m_unf = _mm256_cmpgt_epi64(one, e);
+
+  // Overflow value: Inf, minus one (largest finite) where ovf_max()
+  __m256i ovf_dec;
+  if (RM == RTZ)      ovf_dec = one;
+  else if (RM == RDN) ovf_dec = _mm256_xor_si256(sb, one);
+  else if (RM == RUP) ovf_dec = sb;
+  else                ovf_dec = zero;
+  const __m256i ovf_y = _mm256_or_si256(s, _mm256_sub_epi64(inf, ovf_dec));
+
+  __m256i yv = _mm256_or_si256(_mm256_or_si256(s, _mm256_slli_epi64(e, 23)), _mm256_and_si256(up, fmsk));
+  yv = _mm256_blendv_epi8(yv, ovf_y, m_ovf);
+  yv = _mm256_blendv_epi8(yv, s, m_unf);
+
+  __m256i fv = _mm256_or_si256(_mm256_or_si256(G, R), S);                  // inexact
+  fv = _mm256_or_si256(fv, _mm256_and_si256(m_ovf, _mm256_set1_epi64x(5))); // overflow + inexact
+  fv = _mm256_or_si256(fv, _mm256_and_si256(m_unf, _mm256_set1_epi64x(3))); // underflow + inexact
+
+  // Specials override
+  yv = _mm256_blendv_epi8(yv, s, m_spec);
+  yv = _mm256_blendv_epi8(yv, _mm256_or_si256(s, inf), m_inf);
+  yv = _mm256_blendv_epi8(yv, _mm256_set1_epi64x(binary32::QNAN), m_qnan);
+  fv = _mm256_or_si256(_mm256_andnot_si256(m_spec, fv), _mm256_and_si256(m_inv, _mm256_set1_epi64x(8)));
+
+  y  = yv;
+  fl = fv;
+}
+
+template <int RM>
+__attribute__((target("avx2")))
+inline void mul_batch_avx2(const uint32_t* a, const uint32_t* b,
+                           uint32_t* y, uint8_t* flags, size_t n) {
+  const __m256i lo = _mm256_set1_epi64x(0xFFFFFFFFll);
+  // Low byte of each 32-bit lane to the bottom of each 128-bit half
+  const __m256i to_bytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  size_t i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    __m256i ye, fe, yo, fo;
+    lanes_avx2<RM>(_mm256_and_si256(va, lo), _mm256_and_si256(vb, lo), ye, fe);
+    lanes_avx2<RM>(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32), yo, fo);
+    _mm256_storeu_si256((__m256i*)(y + i), _mm256_or_si256(ye, _mm256_slli_epi64(yo, 32)));
+
+    const __m256i fb = _mm256_shuffle_epi8(_mm256_or_si256(fe, _mm256_slli_epi64(fo, 32)), to_bytes);
+    const uint32_t f_lo = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(fb));
+    const uint32_t f_hi = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(fb, 1));
+    std::memcpy(flags + i, &f_lo, 4);
+    std::memcpy(flags + i + 4, &f_hi, 4);
+  }
+
+  mul_batch_k<binary32, RM, false>(a + i, b + i, y + i, flags + i, n - i);
+}
+
+// GCC 12 warns about its own _mm512_undefined_*() placeholders once the
+// intrinsics are inlined into a target("avx512f") function
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// 8 lanes, operands in the low 32 bits of each 64-bit lane
+template <int RM>
+__attribute__((target("avx512f")))
+inline void lanes_avx512(__m512i a, __m512i b, __m512i& y, __m512i& fl) {
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i one  = _mm512_set1_epi64(1);
+  const __m512i emax = _mm512_set1_epi64(0xFF);
+  const __m512i hid  = _mm512_set1_epi64(1 << 23);
+  const __m512i fmsk = _mm512_set1_epi64(0x7FFFFF);
+  const __m512i inf  = _mm512_set1_epi64(0x7F800000);
+
+  const __m512i s  = _mm512_and_si512(_mm512_xor_si512(a, b), _mm512_set1_epi64(0x80000000ll));
+  const __m512i ea = _mm512_and_si512(_mm512_srli_epi64(a, 23), emax);
+  const __m512i eb = _mm512_and_si512(_mm512_srli_epi64(b, 23), emax);
+  const __m512i fa = _mm512_and_si512(a, fmsk);
+  const __m512i fb = _mm512_and_si512(b, fmsk);
+
+  // Classification
+  const __mmask8 ea_max = _mm512_cmpeq_epi64_mask(ea, emax);
+  const __mmask8 eb_max = _mm512_cmpeq_epi64_mask(eb, emax);
+  const __mmask8 fa_z   = _mm512_cmpeq_epi64_mask(fa, zero);
+  const __mmask8 fb_z   = _mm512_cmpeq_epi64_mask(fb, zero);
+  const __mmask8 a_inf  = ea_max & fa_z;
+  const __mmask8 b_inf  = eb_max & fb_z;
+  const __mmask8 a_z    = _mm512_cmpeq_epi64_mask(ea, zero); // zero or DAZ subnormal
+  const __mmask8 b_z    = _mm512_cmpeq_epi64_mask(eb, zero);
+
+  const __mmask8 m_nan  = (ea_max & ~fa_z) | (eb_max & ~fb_z);
+  const __mmask8 m_inv  = ~m_nan & ((a_inf & b_z) | (b_inf & a_z));
+  const __mmask8 m_qnan = m_nan | m_inv;
+  const __mmask8 m_inf  = ~m_qnan & (a_inf | b_inf);
+  const __mmask8 m_spec = m_qnan | m_inf | a_z | b_z;
+
+  // Normal path: 48-bit product, normalize, G/R/S, round
+  __m512i prod = _mm512_mul_epu32(_mm512_or_si512(fa, hid), _mm512_or_si512(fb, hid));
+  const __m512i top = _mm512_srli_epi64(prod, 47);
+  prod = _mm512_or_si512(_mm512_srlv_epi64(prod, top), _mm512_and_si512(prod, top));  // keep sticky
+
+  __m512i up = _mm512_and_si512(_mm512_srli_epi64(prod, 23), _mm512_set1_epi64(0xFFFFFF));
+  const __m512i G = _mm512_and_si512(_mm512_srli_epi64(prod, 22), one);
+  const __m512i R = _mm512_and_si512(_mm512_srli_epi64(prod, 21), one);
+  const __m512i S = _mm512_maskz_mov_epi64(
+                      _mm512_test_epi64_mask(prod, _mm512_set1_epi64(0x1FFFFF)), one);
+  const __m512i RS = _mm512_or_si512(R, S);
+  const __m512i sb = _mm512_srli_epi64(s, 31);  // sign as 0/1
+  __m512i inc;
+  if (RM == RTZ)      inc = zero;
+  else if (RM == RDN) inc = _mm512_and_si512(sb, _mm512_or_si512(G, RS));
+  else if (RM == RUP) inc = _mm512_andnot_si512(sb, _mm512_or_si512(G, RS));
+  else if (RM == RMM) inc = G;
+  else                inc = _mm512_and_si512(G, _mm512_or_si512(RS, _mm512_and_si512(up, one)));
+  up = _mm512_add_epi64(up, inc);
+  const __m512i carry = _mm512_srli_epi64(up, 24);
+  up = _mm512_srlv_epi64(up, carry);
+
+  // Biased result exponent, signed
+  const __m512i e = _mm512_sub_epi64(_mm512_add_epi64(_mm512_add_epi64(ea, eb), _mm512_add_epi64(top, carry)),
+                                     _mm512_set1_epi64(127));
+  const __mmask8 m_ovf = _mm512_cmpgt_epi64_mask(e, _mm512_set1_epi64(254));
+  const __mmask8 m_unf = _mm512_cmplt_epi64_mask(e, one);
+
+  // Overflow value: Inf, minus one (largest finite) where ovf_max()
+  __m512i ovf_dec;
+  if (RM == RTZ)      ovf_dec = one;
+  else if (RM == RDN) ovf_dec = _mm512_xor_si512(sb, one);
+  else if (RM == RUP) ovf_dec = sb;
+  else                ovf_dec = zero;
+  const __m512i ovf_y = _mm512_or_si512(s, _mm512_sub_epi64(inf, ovf_dec));
+
+  __m512i yv = _mm512_or_si512(_mm512_or_si512(s, _mm512_slli_epi64(e, 23)), _mm512_and_si512(up, fmsk));
+  yv = _mm512_mask_mov_epi64(yv, m_ovf, ovf_y);
+  yv = _mm512_mask_mov_epi64(yv, m_unf, s);
+
+  __m512i fv = _mm512_or_si512(_mm512_or_si512(G, R), S);                  // inexact
+  fv = _mm512_mask_or_epi64(fv, m_ovf, fv, _mm512_set1_epi64(5));           // overflow + inexact
+  fv = _mm512_mask_or_epi64(fv, m_unf, fv, _mm512_set1_epi64(3));           // underflow + inexact
+
+  // Specials override
+  yv = _mm512_mask_mov_epi64(yv, m_spec, s);
+  yv = _mm512_mask_mov_epi64(yv, m_inf, _mm512_or_si512(s, inf));
+  yv = _mm512_mask_mov_epi64(yv, m_qnan, _mm512_set1_epi64(binary32::QNAN));
+  fv = _mm512_mask_mov_epi64(fv, m_spec, zero);
+  fv = _mm512_mask_mov_epi64(fv, m_inv, _mm512_set1_epi64(8));
+
+  y  = yv;
+  fl = fv;
+}
+
+template <int RM>
+__attribute__((target("avx512f")))
+inline void mul_batch_avx512(const uint32_t* a, const uint32_t* b,
+                             uint32_t* y, uint8_t* flags, size_t n) {
+  const __m512i lo = _mm512_set1_epi64(0xFFFFFFFFll);
+  size_t i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    const __m512i va = _mm512_loadu_si512((const void*)(a + i));
+    const __m512i vb = _mm512_loadu_si512((const void*)(b + i));
+    __m512i ye, fe, yo, fo;
+    lanes_avx512<RM>(_mm512_and_si512(va, lo), _mm512_and_si512(vb, lo), ye, fe);
+    lanes_avx512<RM>(_mm512_srli_epi64(va, 32), _mm512_srli_epi64(vb, 32), yo, fo);
+    _mm512_storeu_si512((void*)(y + i), _mm512_or_si512(ye, _mm512_slli_epi64(yo, 32)));
+    _mm_storeu_si128((__m128i*)(flags + i),
+                     _mm512_cvtepi32_epi8(_mm512_or_si512(fe, _mm512_slli_epi64(fo, 32))));
+  }
+
+  mul_batch_k<binary32, RM, false>(a + i, b + i, y + i, flags + i, n - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+template <>
+struct SimdKernels<binary32> {
+  static Batch<binary32>::Fn get(int rm, Isa isa) {
+    static const Batch<binary32>::Fn avx512[5] = {
+      mul_batch_avx512<RNE>, mul_batch_avx512<RTZ>, mul_batch_avx512<RDN>,
+      mul_batch_avx512<RUP>, mul_batch_avx512<RMM>,
+    };
+    static const Batch<binary32>::Fn avx2[5] = {
+      mul_batch_avx2<RNE>, mul_batch_avx2<RTZ>, mul_batch_avx2<RDN>,
+      mul_batch_avx2<RUP>, mul_batch_avx2<RMM>,
+    };
+    switch (isa) {
+      case Isa::Avx512: return avx512[rm_index(rm)];
+      case Isa::Avx2:   return avx2[rm_index(rm)];
+      default:          return nullptr;
+    }
+  }
+};
+#endif // FMUL_SOFT_X86
+
+// Widest kernel the host supports
+inline Isa isa_best() {
+#ifdef FMUL_SOFT_X86
+  static const Isa best = __builtin_cpu_supports("avx512f") ? Isa::Avx512
+                        : __builtin_cpu_supports("avx2")    ? Isa::Avx2
+                                                            : Isa::Scalar;
+  return best;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+// Batch kernel of format F for rounding mode rm, subnormal policy subn,
+// at most isa. A loop over many batches selects once and calls the result.
+template <class F>
+inline typename Batch<F>::Fn batch_select(int rm, bool subn, Isa isa = isa_best()) {
+  if (!subn && isa != Isa::Scalar) {
+    if (typename Batch<F>::Fn fn = SimdKernels<F>::get(rm, isa)) return fn;
+  }
+  return batch_scalar<F>(rm, subn);
+}
+
+template <class F>
+inline void mul_batch(const typename F::word* a, const typename F::word* b,
+                      typename F::word* y, uint8_t* flags, size_t n,
+                      int rm = RNE, bool subn = false, Isa isa = isa_best()) {
+  batch_select<F>(rm, subn, isa)(a, b, y, flags, n);
+}
+
+#ifdef FMUL_SOFT_SPAN
+// -------------------------------------------------------------------
+// Bulk API: y[i] = a[i] * b[i] over whole arrays, for emulation at the
+// host's full rate. The arrays are cut into blocks of BULK_BLOCK vectors
+// handed to `threads` threads (0 = all hardware threads; small arrays
+// stay on the caller's thread). flags may be empty when only the OR of
+// the flags is wanted, which is returned either way, like the sticky
+// exception flags of an FPU.
+// -------------------------------------------------------------------
+static const size_t BULK_BLOCK = 4096;
+
+struct BulkConfig {
+  int rm = RNE;
+  bool subnormal = false;
+  unsigned threads = 1;
+  Isa isa = isa_best();
+};
+
+template <class F>
+inline uint8_t mul_bulk(std::span<const typename F::word> a, std::span<const typename F::word> b,
+                        std::span<typename F::word> y, std::span<uint8_t> flags = {},
+                        const BulkConfig& cfg = BulkConfig()) {
+  const size_t n = std::min({a.size(), b.size(), y.size()});
+  const bool own_flags = flags.size() < n;
+  const typename Batch<F>::Fn fn = batch_select<F>(cfg.rm, cfg.subnormal, cfg.isa);
+  const size_t blocks = (n + BULK_BLOCK - 1) / BULK_BLOCK;
+
+  // Blocks [first, last) on one thread, OR of their flags
+  auto run = [&](size_t first, size_t last) -> uint8_t {
+    uint8_t tmp[BULK_BLOCK];
+    uint8_t sticky = 0;
+    for (size_t k = first; k < last; k++) {
+      const size_t i = k * BULK_BLOCK;
+      const size_t m = std::min(BULK_BLOCK, n - i);
+      uint8_t* fl = own_flags ? tmp : flags.data() + i;
+      fn(a.data() + i, b.data() + i, y.data() + i, fl, m);
+      for (size_t j = 0; j < m; j++) sticky |= fl[j];
+    }
+    return sticky;
+  };
+
+  unsigned threads = cfg.threads ? cfg.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = (unsigned)std::min<size_t>(threads, (blocks + 15) / 16);  // >= 16 blocks each
+  if (threads <= 1) return run(0, blocks);
+
+  std::vector<std::thread> pool;
+  std::vector<uint8_t> sticky(threads, 0);
+  for (unsigned t = 0; t < threads; t++) {
+    pool.emplace_back([&, t] { sticky[t] = run(blocks * t / threads, blocks * (t + 1) / threads); });
+  }
+  uint8_t all = 0;
+  for (unsigned t = 0; t < threads; t++) {
+    pool[t].join();
+    all |= sticky[t];
+  }
+  return all;
+}
+#endif // FMUL_SOFT_SPAN
+
+}  // namespace fmul_soft
+
+#endif // FMUL_SOFT_H